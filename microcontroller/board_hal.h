@@ -0,0 +1,27 @@
+#pragma once
+
+// Thin hardware-abstraction layer for the board logic modules (board_sensors.cpp, ...).
+// On the ESP32 these map straight onto the Arduino core (board_hal_arduino.cpp);
+// host builds link host/hal_host.cpp instead, which simulates pins and time.
+
+#include <stdint.h>
+
+// Functions a timer interrupt calls must sit in IRAM on the ESP32: while flash is written (NVS,
+// Preferences) the cache is off and code in flash cannot run. Empty on the host.
+#ifdef ARDUINO
+#include <esp_attr.h>
+#define HAL_IRAM_ATTR IRAM_ATTR
+#else
+#define HAL_IRAM_ATTR
+#endif
+
+void halPinWrite(int pin, bool high);
+// Drives several output pins in one go: bit n of highMask / lowMask is GPIO n.
+// On the ESP32 this is one write to each of the set / clear registers per GPIO bank; in IRAM,
+// the step timer interrupt drives the motors with it.
+void halPinsWrite(uint64_t highMask, uint64_t lowMask);
+bool halPinRead(int pin);
+void halDelayMicros(uint32_t us);
+void halDelayMillis(uint32_t ms);
+uint32_t halMillis();
+uint32_t halMicros();
@@ -0,0 +1,35 @@
+// Arduino-core implementation of board_hal.h (compiled only in the firmware build).
+#ifdef ARDUINO
+
+#include <Arduino.h>
+#include "soc/gpio_reg.h"
+#include "board_hal.h"
+
+// Pin I/O goes to the GPIO registers directly: digitalWrite / digitalRead re-check the pin
+// on every call, which is most of the cost of a 64-channel reed scan.
+// Pins must already be configured with pinMode().
+
+void halPinWrite(int pin, bool high) {
+    uint64_t mask = uint64_t(1) << pin;
+    halPinsWrite(high ? mask : 0, high ? 0 : mask);
+}
+
+void HAL_IRAM_ATTR halPinsWrite(uint64_t highMask, uint64_t lowMask) {
+    // GPIO 0-31 live in OUT, 32-39 in OUT1
+    if (highMask & 0xFFFFFFFFULL) REG_WRITE(GPIO_OUT_W1TS_REG, uint32_t(highMask));
+    if (lowMask & 0xFFFFFFFFULL) REG_WRITE(GPIO_OUT_W1TC_REG, uint32_t(lowMask));
+    if (highMask >> 32) REG_WRITE(GPIO_OUT1_W1TS_REG, uint32_t(highMask >> 32));
+    if (lowMask >> 32) REG_WRITE(GPIO_OUT1_W1TC_REG, uint32_t(lowMask >> 32));
+}
+
+bool halPinRead(int pin) {
+    if (pin < 32) return (REG_READ(GPIO_IN_REG) >> pin) & 1;
+    return (REG_READ(GPIO_IN1_REG) >> (pin - 32)) & 1;
+}
+
+void halDelayMicros(uint32_t us) { delayMicroseconds(us); }
+void halDelayMillis(uint32_t ms) { delay(ms); }
+uint32_t halMillis() { return millis(); }
+uint32_t halMicros() { return micros(); }
+
+#endif
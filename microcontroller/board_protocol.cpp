@@ -0,0 +1,41 @@
+#include "board_protocol.h"
+#include <stdio.h>
+
+namespace {
+
+// snprintf result -> writer result (0 on error or truncation).
+size_t fitted(int written, size_t outSize) {
+    return (written < 0 || size_t(written) >= outSize) ? 0 : size_t(written);
+}
+
+} // namespace
+
+size_t writeHashHex(uint64_t hash, char *out, size_t outSize) {
+    return fitted(snprintf(out, outSize, "%08lx%08lx",
+                           (unsigned long)(hash >> 32), (unsigned long)(hash & 0xFFFFFFFFUL)), outSize);
+}
+
+size_t writeMoveFrame(const MoveMessage &msg, char *out, size_t outSize) {
+    char hash[HASH_HEX_LEN];
+    writeHashHex(msg.hash, hash, sizeof(hash));
+    return fitted(snprintf(out, outSize,
+                           "42/friends,[\"move\",{\"gameId\":%s,\"from\":\"%s\",\"to\":\"%s\",\"promotion\":\"%s\","
+                           "\"san\":\"%s\",\"fen\":\"%s\",\"movedBy\":\"%s\",\"currentTurn\":\"%s\","
+                           "\"hash\":\"%s\",\"isPhysical\":true}]",
+                           msg.gameId, msg.from, msg.to, msg.promotion, msg.san, msg.fen,
+                           msg.movedBy, msg.currentTurn, hash), outSize);
+}
+
+size_t writeMoveHttpBody(const MoveMessage &msg, int playerId, char *out, size_t outSize) {
+    return fitted(snprintf(out, outSize,
+                           "{\"gameId\":%s,\"playerId\":%d,\"action\":\"make_move\",\"moveData\":{"
+                           "\"from\":\"%s\",\"to\":\"%s\",\"promotion\":\"%s\",\"san\":\"%s\",\"fen\":\"%s\"}}",
+                           msg.gameId, playerId, msg.from, msg.to, msg.promotion, msg.san, msg.fen), outSize);
+}
+
+size_t writeSensorFrame(uint64_t occupancy, uint16_t seq, bool keyframe, char *out, size_t outSize) {
+    char occ[HASH_HEX_LEN];
+    writeHashHex(occupancy, occ, sizeof(occ));
+    return fitted(snprintf(out, outSize, "42/friends,[\"boardSensorUpdate\",{\"occ\":\"%s\",\"seq\":%u,\"kf\":%d}]",
+                           occ, unsigned(seq), keyframe ? 1 : 0), outSize);
+}
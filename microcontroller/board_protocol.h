@@ -0,0 +1,39 @@
+#pragma once
+
+// Outgoing server messages built into caller buffers (no Arduino String, no heap).
+// Values are written verbatim: they are FEN / SAN / square / colour / numeric id text,
+// none of which can contain a JSON quote or backslash.
+// Each writer returns the length written, or 0 if the buffer is too small.
+
+#include <stddef.h>
+#include <stdint.h>
+
+const size_t HASH_HEX_LEN = 17;      // 16 hex digits + terminator
+const size_t MOVE_FRAME_MAX = 384;   // longest move frame / HTTP move body + terminator
+const size_t SENSOR_FRAME_MAX = 96;
+
+struct MoveMessage {
+    const char *gameId;       // numeric id, written unquoted
+    const char *from;
+    const char *to;
+    const char *promotion;    // "" or "q"
+    const char *san;
+    const char *fen;          // position after the move
+    const char *movedBy;
+    const char *currentTurn;  // side to move after the move
+    uint64_t hash;            // Zobrist key of the position after the move
+};
+
+// 16 hex digits, as sent in the "hash" field of move frames.
+size_t writeHashHex(uint64_t hash, char *out, size_t outSize);
+
+// 42/friends,["move",{...,"isPhysical":true}] for the friends namespace.
+size_t writeMoveFrame(const MoveMessage &msg, char *out, size_t outSize);
+
+// {"gameId":..,"playerId":..,"action":"make_move","moveData":{...}} for POST /api/game/control-player.
+size_t writeMoveHttpBody(const MoveMessage &msg, int playerId, char *out, size_t outSize);
+
+// 42/friends,["boardSensorUpdate",{"occ":"<16 hex>","seq":n,"kf":0|1}]
+// occ is the 64-bit occupancy (bit sq = row * 8 + col) as hex, since JSON numbers cannot hold it;
+// the server expands it back to the 8 "rows" bytes the frontend draws.
+size_t writeSensorFrame(uint64_t occupancy, uint16_t seq, bool keyframe, char *out, size_t outSize);
@@ -0,0 +1,193 @@
+#include "board_sensors.h"
+#include "board_hal.h"
+#include <string.h>
+
+namespace {
+
+// Channel order for a bank: consecutive entries differ in one select bit.
+const uint8_t GRAY_CHANNELS[16] = { 0, 1, 3, 2, 6, 7, 5, 4, 12, 13, 15, 14, 10, 11, 9, 8 };
+// Settle times tried by measureReedSettleMicros, shortest first.
+const uint32_t SETTLE_STEPS_US[] = { 1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48 };
+
+uint32_t settleMicros = REED_SETTLE_SAFE_US;
+
+// Sensor columns 0 and 1 (mux 0); shifted left by 2m for mux m.
+const Bitboard BANK_COLUMNS = 0x0303030303030303ULL;
+
+inline uint64_t pinBit(int pin) { return uint64_t(1) << pin; }
+
+uint64_t enableMask(const ReedMuxPins &pins) {
+    uint64_t mask = 0;
+    for (int i = 0; i < 4; i++) mask |= pinBit(pins.enable[i]);
+    return mask;
+}
+
+void selectMasks(const ReedMuxPins &pins, int ch, uint64_t &high, uint64_t &low) {
+    high = low = 0;
+    for (int b = 0; b < 4; b++) {
+        if ((ch >> b) & 1) high |= pinBit(pins.select[b]);
+        else low |= pinBit(pins.select[b]);
+    }
+}
+
+// Waits out whatever is left of the settle time started at since.
+inline void waitSettled(uint32_t since) {
+    uint32_t elapsed = halMicros() - since;
+    if (elapsed < settleMicros) halDelayMicros(settleMicros - elapsed);
+}
+
+bool boardsEqual(const bool a[8][8], const bool b[8][8]) {
+    return memcmp(a, b, sizeof(bool) * 64) == 0;
+}
+
+} // namespace
+
+void setReedSettleMicros(uint32_t us) { settleMicros = us; }
+uint32_t reedSettleMicros() { return settleMicros; }
+
+bool readReed(const ReedMuxPins &pins, int mux, int ch) {
+    uint64_t high, low;
+    selectMasks(pins, ch, high, low);
+    uint64_t muxBit = pinBit(pins.enable[mux]);
+    halPinsWrite(high | (enableMask(pins) & ~muxBit), low | muxBit);
+    halDelayMicros(settleMicros);
+    bool closed = !halPinRead(pins.sig);
+    halPinWrite(pins.enable[mux], true);
+    return closed;
+}
+
+Bitboard scanSensorSquares(const ReedMuxPins &pins, Bitboard squares) {
+    uint64_t selectHigh[16], selectLow[16];
+    for (int ch = 0; ch < 16; ch++) selectMasks(pins, ch, selectHigh[ch], selectLow[ch]);
+    halPinsWrite(enableMask(pins), 0);
+
+    // SIG is shared, so samples cannot overlap; what overlaps is storing the previous sample,
+    // done while the next address settles.
+    Bitboard closed = 0, pendingBit = 0;
+    bool pendingClosed = false;
+    int enabled = -1;
+    for (int mux = 0; mux < 4; mux++) {
+        int base = mux * 2;
+        if (!(squares & (BANK_COLUMNS << base))) continue;
+        for (int i = 0; i < 16; i++) {
+            int ch = GRAY_CHANNELS[i];
+            Bitboard bit = squareBit(squareOf(ch % 8, base + (ch < 8 ? 0 : 1)));
+            if (!(squares & bit)) continue;
+            uint64_t high = selectHigh[ch], low = selectLow[ch];
+            if (enabled != mux) {
+                // bank switch: previous mux off and this one on together with the first address
+                if (enabled >= 0) high |= pinBit(pins.enable[enabled]);
+                low |= pinBit(pins.enable[mux]);
+                enabled = mux;
+            }
+            halPinsWrite(high, low);
+            uint32_t selectedAt = halMicros();
+            if (pendingClosed) closed |= pendingBit;
+            pendingBit = bit;
+            waitSettled(selectedAt);
+            pendingClosed = !halPinRead(pins.sig);
+        }
+    }
+    if (pendingClosed) closed |= pendingBit;
+    if (enabled >= 0) halPinWrite(pins.enable[enabled], true);
+    return closed;
+}
+
+void scanBoardTo(const ReedMuxPins &pins, bool outBoard[8][8]) {
+    sensorBoardFromBits(scanSensorSquares(pins, ALL_SENSOR_SQUARES), outBoard);
+}
+
+uint32_t measureReedSettleMicros(const ReedMuxPins &pins, int scansPerStep) {
+    uint32_t saved = settleMicros;
+    settleMicros = REED_SETTLE_SAFE_US;
+    bool reference[8][8], sample[8][8];
+    scanBoardTo(pins, reference);
+    scanBoardTo(pins, sample);
+    Bitboard bits = sensorBoardBits(reference);
+    uint32_t result = REED_SETTLE_SAFE_US;
+
+    if (boardsEqual(reference, sample) && bits != 0 && bits != ~Bitboard(0)) {
+        for (size_t step = 0; step < sizeof(SETTLE_STEPS_US) / sizeof(SETTLE_STEPS_US[0]); step++) {
+            settleMicros = SETTLE_STEPS_US[step];
+            bool stable = true;
+            for (int i = 0; i < scansPerStep && stable; i++) {
+                scanBoardTo(pins, sample);
+                stable = boardsEqual(reference, sample);
+            }
+            if (stable) {
+                result = SETTLE_STEPS_US[step] * 2;
+                if (result > REED_SETTLE_SAFE_US) result = REED_SETTLE_SAFE_US;
+                break;
+            }
+        }
+    }
+    settleMicros = saved;
+    return result;
+}
+
+float reedScansPerSecond(const ReedMuxPins &pins, int scans) {
+    bool sample[8][8];
+    uint32_t start = halMicros();
+    for (int i = 0; i < scans; i++) scanBoardTo(pins, sample);
+    uint32_t elapsed = halMicros() - start;
+    return elapsed ? float(scans) * 1000000.0f / float(elapsed) : 0.0f;
+}
+
+uint8_t sensorSquareMask(BoardTransform transform) {
+    switch (transform) {
+        case MAP_MIRROR_ROWS: return 56;
+        case MAP_MIRROR_COLS: return 7;
+        case MAP_MIRROR_BOTH: return 63;
+        default:              return 0;
+    }
+}
+
+int sensorToSquareIndex(int sensorRow, int sensorCol, BoardTransform transform) {
+    if (sensorRow < 0 || sensorRow > 7 || sensorCol < 0 || sensorCol > 7) return NO_SQUARE;
+    return squareOf(sensorRow, sensorCol) ^ sensorSquareMask(transform);
+}
+
+void positionToSensorBoard(const Position &pos, BoardTransform transform, bool outBoard[8][8]) {
+    uint8_t mask = sensorSquareMask(transform);
+    for (int sq = 0; sq < 64; sq++) {
+        int sensorSq = sq ^ mask;
+        outBoard[squareRow(sensorSq)][squareCol(sensorSq)] = (pos.occupiedAll & squareBit(sq)) != 0;
+    }
+}
+
+Bitboard sensorBoardBits(const bool board[8][8]) {
+    Bitboard bits = 0;
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            if (board[r][c]) bits |= squareBit(squareOf(r, c));
+        }
+    }
+    return bits;
+}
+
+void sensorBoardFromBits(Bitboard bits, bool outBoard[8][8]) {
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) outBoard[r][c] = (bits & squareBit(squareOf(r, c))) != 0;
+    }
+}
+
+Bitboard sensorOccupancy(const bool sensorBoard[8][8], BoardTransform transform) {
+    uint8_t mask = sensorSquareMask(transform);
+    Bitboard occupancy = 0;
+    for (int sensorSq = 0; sensorSq < 64; sensorSq++) {
+        if (sensorBoard[squareRow(sensorSq)][squareCol(sensorSq)]) occupancy |= squareBit(sensorSq ^ mask);
+    }
+    return occupancy;
+}
+
+Move moveFromSensorDelta(const bool oldB[8][8], const bool newB[8][8], const Position &pos, BoardTransform transform) {
+    int fromSq = NO_SQUARE, toSq = NO_SQUARE;
+    for (int r = 0; r < 8; r++) {
+        for (int c = 0; c < 8; c++) {
+            if (oldB[r][c] && !newB[r][c]) fromSq = sensorToSquareIndex(r, c, transform);
+            if (!oldB[r][c] && newB[r][c]) toSq = sensorToSquareIndex(r, c, transform);
+        }
+    }
+    if (fromSq == NO_SQUARE || toSq == NO_SQUARE) return MOVE_NONE;
+    return buildMove(pos, fromSq, toSq);
+}
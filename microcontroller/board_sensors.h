@@ -0,0 +1,62 @@
+#pragma once
+
+// Reed-switch matrix: scanning through the four 16-channel muxes, sensor ↔ chess coordinates,
+// and the occupancy bitboard streamed to the frontend (sensor_stream.h).
+// Hardware access goes through board_hal.h.
+// Sensor boards are bool[8][8] indexed [sensorRow][sensorCol] exactly as wired.
+
+#include "chess_position.h"
+
+enum BoardTransform : uint8_t {
+    MAP_IDENTITY = 0,      // sensor(r,c) -> chess(r,c)
+    MAP_MIRROR_ROWS = 1,   // sensor(r,c) -> chess(7-r,c)
+    MAP_MIRROR_COLS = 2,   // sensor(r,c) -> chess(r,7-c)
+    MAP_MIRROR_BOTH = 3    // sensor(r,c) -> chess(7-r,7-c)
+};
+
+struct ReedMuxPins {
+    int sig;        // shared mux output, LOW = reed closed
+    int select[4];  // S0..S3
+    int enable[4];  // E0..E3, active LOW, one per mux
+};
+
+// Time the mux output needs after an address change before SIG is sampled. The default is the
+// conservative figure the firmware always used; measureReedSettleMicros() finds the real one.
+const uint32_t REED_SETTLE_SAFE_US = 100;
+void setReedSettleMicros(uint32_t us);
+uint32_t reedSettleMicros();
+
+// Mux m covers sensor columns 2m (channels 0-7) and 2m+1 (channels 8-15); channel % 8 is the row.
+bool readReed(const ReedMuxPins &pins, int mux, int ch);
+const Bitboard ALL_SENSOR_SQUARES = ~Bitboard(0);
+
+// Reads the given sensor squares (bit row * 8 + col); the result has a bit set for each closed reed
+// among them. Each mux with a square to read is enabled once, and its channels are walked in
+// Gray-code order so only one select line toggles per step on a full bank.
+Bitboard scanSensorSquares(const ReedMuxPins &pins, Bitboard squares);
+// Full-board scan (scanSensorSquares of every square).
+void scanBoardTo(const ReedMuxPins &pins, bool outBoard[8][8]);
+// Shortest settle time at which scansPerStep scans all agree with a scan at REED_SETTLE_SAFE_US,
+// doubled for margin. Needs a mix of occupied and empty squares (e.g. the start position) to see
+// the SIG line swing; returns REED_SETTLE_SAFE_US if the board cannot tell. Does not apply it.
+uint32_t measureReedSettleMicros(const ReedMuxPins &pins, int scansPerStep);
+// Full-board scans per second at the current settle time, timed over the given number of scans.
+float reedScansPerSecond(const ReedMuxPins &pins, int scans);
+
+// XOR mask taking a chess square index to its sensor square index (see chessToSensorSquare).
+uint8_t sensorSquareMask(BoardTransform transform);
+// Chess square index for a sensor cell under the given transform, or NO_SQUARE.
+int sensorToSquareIndex(int sensorRow, int sensorCol, BoardTransform transform);
+// Occupancy of pos in sensor coordinates, so it shares index space with scanned boards.
+void positionToSensorBoard(const Position &pos, BoardTransform transform, bool outBoard[8][8]);
+// Sensor board as a bitboard indexed like chess squares: bit (row * 8 + col).
+Bitboard sensorBoardBits(const bool board[8][8]);
+// Inverse of sensorBoardBits.
+void sensorBoardFromBits(Bitboard bits, bool outBoard[8][8]);
+
+// Occupancy of a scanned board in chess coordinates: bit (row * 8 + col), row 0 = rank 1, col 0 = file a.
+// Byte r is the live-view "rows[r]" value.
+Bitboard sensorOccupancy(const bool sensorBoard[8][8], BoardTransform transform);
+
+// Single-piece move from one vacated and one filled sensor square, or MOVE_NONE.
+Move moveFromSensorDelta(const bool oldB[8][8], const bool newB[8][8], const Position &pos, BoardTransform transform);
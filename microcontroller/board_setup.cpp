@@ -0,0 +1,264 @@
+#include "board_setup.h"
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+const int MAX_KIND = 16;       // most pieces of one kind the assignment takes
+const int MAX_PENDING = 64;
+const float INF = 1e30f;
+
+struct Pending {
+    uint8_t from, to, piece;   // to == SETUP_NO_CELL: off the board, to the capture column
+};
+
+bool isCaptureCell(int cell) {
+    int col = setupCellCol(cell);
+    return col == 0 || col == CARRIAGE_COLS - 1;
+}
+
+int captureColumnOf(uint8_t piece) {
+    return pieceColor(piece) == PIECE_WHITE ? 0 : CARRIAGE_COLS - 1;
+}
+
+// The carriage's moves are CoreXY: a leg takes as long as |dx| + |dy| on the busier motor.
+float distanceMm(const CarriageGeometry &geometry, int a, int b) {
+    return fabsf((setupCellRow(a) - setupCellRow(b)) * geometry.cellMm) +
+           fabsf(geometry.colOffsets[setupCellCol(a)] - geometry.colOffsets[setupCellCol(b)]);
+}
+
+// Minimum-cost perfect matching of an n x n cost matrix: rowToCol[i] is row i's column.
+// Hungarian method with row / column potentials, O(n^3).
+void assignMinCost(int n, const float cost[MAX_KIND][MAX_KIND], int rowToCol[MAX_KIND]) {
+    float u[MAX_KIND + 1] = {}, v[MAX_KIND + 1] = {}, minv[MAX_KIND + 1];
+    int p[MAX_KIND + 1] = {}, way[MAX_KIND + 1] = {};
+    bool used[MAX_KIND + 1];
+    for (int i = 1; i <= n; i++) {
+        p[0] = i;
+        int j0 = 0;
+        for (int j = 0; j <= n; j++) {
+            minv[j] = INF;
+            used[j] = false;
+        }
+        do {
+            used[j0] = true;
+            int i0 = p[j0], j1 = 0;
+            float delta = INF;
+            for (int j = 1; j <= n; j++) {
+                if (used[j]) continue;
+                float cur = cost[i0 - 1][j - 1] - u[i0] - v[j];
+                if (cur < minv[j]) {
+                    minv[j] = cur;
+                    way[j] = j0;
+                }
+                if (minv[j] < delta) {
+                    delta = minv[j];
+                    j1 = j;
+                }
+            }
+            for (int j = 0; j <= n; j++) {
+                if (used[j]) {
+                    u[p[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minv[j] -= delta;
+                }
+            }
+            j0 = j1;
+        } while (p[j0] != 0);
+        do {
+            int j1 = way[j0];
+            p[j0] = p[j1];
+            j0 = j1;
+        } while (j0);
+    }
+    for (int j = 1; j <= n; j++) rowToCol[p[j] - 1] = j - 1;
+}
+
+// Nearest empty capture-column cell to `near`, in `column` if it has one (-1: either column).
+int freeCaptureCell(const CarriageGeometry &geometry, const SetupCells &cells, int near, int column) {
+    int best = SETUP_NO_CELL;
+    float bestMm = INF;
+    for (int pass = 0; pass < 2 && best == SETUP_NO_CELL; pass++) {
+        for (int side = 0; side < 2; side++) {
+            int col = side ? CARRIAGE_COLS - 1 : 0;
+            if (pass == 0 && column >= 0 && col != column) continue;
+            for (int row = 0; row < CARRIAGE_ROWS; row++) {
+                int cell = setupCell(row, col);
+                if (cells.piece[cell] != NO_PIECE) continue;
+                float mm = distanceMm(geometry, near, cell);
+                if (mm < bestMm) {
+                    bestMm = mm;
+                    best = cell;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+float pathSeconds(const MotionLimits &limits, const CarriagePath &path) {
+    static MotionPlan plan;
+    motionPlanBegin(plan, limits);
+    for (int i = 0; i < path.count; i++) motionPlanAdd(plan, path.dxMm[i], path.dyMm[i]);
+    motionPlanFinish(plan);
+    return motionPlanDuration(plan);
+}
+
+// Travel from the carriage to `from`, then the carry to `to` around the pieces in cells.
+float stepSeconds(const CarriageGeometry &geometry, const MotionLimits &limits, const SetupCells &cells,
+                  int carriage, int from, int to) {
+    CarriagePath path;
+    carriageDirectPath(geometry, setupCellRow(carriage), setupCellCol(carriage), setupCellRow(from), setupCellCol(from), path);
+    float seconds = pathSeconds(limits, path);
+    CarriageObstacles obstacles;
+    setupObstacles(cells, obstacles);
+    int fr = setupCellRow(from), fc = setupCellCol(from), tr = setupCellRow(to), tc = setupCellCol(to);
+    if (!carriageClearPath(geometry, obstacles, limits, fr, fc, tr, tc, path)) carriageLanePath(geometry, fr, fc, tr, tc, path);
+    return seconds + pathSeconds(limits, path);
+}
+
+bool emit(SetupPlan &out, SetupCells &cells, int from, int to, bool parking, float seconds) {
+    if (out.count >= SETUP_MAX_STEPS) return false;
+    SetupStep step = { uint8_t(from), uint8_t(to), cells.piece[from], parking };
+    out.steps[out.count++] = step;
+    out.seconds += seconds;
+    setupApply(cells, step);
+    return true;
+}
+
+} // namespace
+
+void setupCellsFromPosition(const Position &pos, SetupCells &out) {
+    memset(out.piece, NO_PIECE, sizeof(out.piece));
+    for (int sq = 0; sq < 64; sq++) out.piece[setupCellOfSquare(sq)] = pos.board[sq];
+}
+
+void setupCellsAddGraveyard(const Graveyard &g, SetupCells &cells) {
+    for (int side = 0; side < 2; side++) {
+        for (int row = 0; row < CARRIAGE_ROWS; row++) cells.piece[setupCell(row, graveyardColumn(side))] = g.piece[side][row];
+    }
+}
+
+void setupGraveyard(const SetupCells &cells, Graveyard &out) {
+    for (int side = 0; side < 2; side++) {
+        for (int row = 0; row < CARRIAGE_ROWS; row++) out.piece[side][row] = cells.piece[setupCell(row, graveyardColumn(side))];
+    }
+}
+
+void setupObstacles(const SetupCells &cells, CarriageObstacles &out) {
+    out.board = 0;
+    out.capture[0] = out.capture[1] = 0;
+    for (int row = 0; row < CARRIAGE_ROWS; row++) {
+        for (int col = 0; col < CARRIAGE_COLS; col++) {
+            if (cells.piece[setupCell(row, col)] == NO_PIECE) continue;
+            if (col == 0) out.capture[0] |= uint8_t(1 << row);
+            else if (col == CARRIAGE_COLS - 1) out.capture[1] |= uint8_t(1 << row);
+            else out.board |= squareBit(squareOf(row, col - 1));
+        }
+    }
+}
+
+void setupApply(SetupCells &cells, const SetupStep &step) {
+    cells.piece[step.to] = cells.piece[step.from];
+    cells.piece[step.from] = NO_PIECE;
+}
+
+bool planBoardSetup(const CarriageGeometry &geometry, const MotionLimits &limits, const SetupCells &current,
+                    const Position &target, int carriageRow, int carriageCol, SetupPlan &out) {
+    out.count = 0;
+    out.missingCount = 0;
+    out.seconds = 0.0f;
+    memset(out.missing, 0, sizeof(out.missing));
+
+    // 1) who goes where, one kind of piece at a time
+    Pending pending[MAX_PENDING];
+    int pendingCount = 0;
+    for (uint8_t piece = 0; piece < NO_PIECE; piece++) {
+        int sources[MAX_KIND], targets[MAX_KIND], ns = 0, nt = 0;
+        for (int cell = 0; cell < SETUP_CELLS; cell++) {
+            if (current.piece[cell] != piece) continue;
+            if (ns == MAX_KIND) return false;
+            sources[ns++] = cell;
+        }
+        for (int sq = 0; sq < 64; sq++) {
+            if (target.board[sq] != piece) continue;
+            if (nt == MAX_KIND) return false;
+            targets[nt++] = setupCellOfSquare(sq);
+        }
+        int n = ns > nt ? ns : nt;
+        if (n == 0) continue;
+        // rows: targets, then "off the board" for surplus pieces; columns: pieces, then missing ones
+        float cost[MAX_KIND][MAX_KIND];
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                if (j >= ns) cost[i][j] = 0.0f;
+                else if (i < nt) cost[i][j] = distanceMm(geometry, sources[j], targets[i]);
+                else if (isCaptureCell(sources[j])) cost[i][j] = 0.0f;
+                else cost[i][j] = distanceMm(geometry, sources[j], setupCell(setupCellRow(sources[j]), captureColumnOf(piece)));
+            }
+        }
+        int rowToCol[MAX_KIND];
+        assignMinCost(n, cost, rowToCol);
+        for (int i = 0; i < n; i++) {
+            int j = rowToCol[i];
+            if (i < nt && j >= ns) {
+                out.missing[piece]++;
+                out.missingCount++;
+                continue;
+            }
+            if (j >= ns) continue;
+            bool offBoard = i >= nt;
+            if (offBoard ? isCaptureCell(sources[j]) : sources[j] == targets[i]) continue; // already there
+            if (pendingCount == MAX_PENDING) return false;
+            Pending move = { uint8_t(sources[j]), uint8_t(offBoard ? SETUP_NO_CELL : targets[i]), piece };
+            pending[pendingCount++] = move;
+        }
+    }
+
+    // 2) in which order: the quickest move whose destination is free, else park a blocker
+    SetupCells cells = current;
+    int carriage = setupCell(carriageRow, carriageCol);
+    while (pendingCount > 0) {
+        int best = -1, bestTo = SETUP_NO_CELL;
+        float bestSeconds = INF;
+        for (int k = 0; k < pendingCount; k++) {
+            int to = pending[k].to != SETUP_NO_CELL
+                ? pending[k].to : freeCaptureCell(geometry, cells, pending[k].from, captureColumnOf(pending[k].piece));
+            if (to == SETUP_NO_CELL || cells.piece[to] != NO_PIECE) continue;
+            float seconds = stepSeconds(geometry, limits, cells, carriage, pending[k].from, to);
+            if (seconds < bestSeconds) {
+                best = k;
+                bestTo = to;
+                bestSeconds = seconds;
+            }
+        }
+        if (best >= 0) {
+            if (!emit(out, cells, pending[best].from, bestTo, false, bestSeconds)) return false;
+            carriage = bestTo;
+            pending[best] = pending[--pendingCount];
+            continue;
+        }
+        // every destination left is taken by a piece that still has to move: park the cheapest one
+        int blocker = -1, parkAt = SETUP_NO_CELL;
+        for (int k = 0; k < pendingCount; k++) {
+            if (pending[k].to == SETUP_NO_CELL || cells.piece[pending[k].to] == NO_PIECE) continue;
+            for (int b = 0; b < pendingCount; b++) {
+                if (pending[b].from != pending[k].to) continue;
+                int park = freeCaptureCell(geometry, cells, pending[b].from, -1);
+                if (park == SETUP_NO_CELL) return false;
+                float seconds = stepSeconds(geometry, limits, cells, carriage, pending[b].from, park);
+                if (seconds < bestSeconds) {
+                    blocker = b;
+                    parkAt = park;
+                    bestSeconds = seconds;
+                }
+            }
+        }
+        if (blocker < 0) return false;
+        if (!emit(out, cells, pending[blocker].from, parkAt, true, bestSeconds)) return false;
+        pending[blocker].from = uint8_t(parkAt);
+        carriage = parkAt;
+    }
+    return true;
+}
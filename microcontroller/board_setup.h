@@ -0,0 +1,61 @@
+#pragma once
+
+// Sets the board up for a target position (the start position after a game, or any FEN) from
+// whatever stands on the motor cells, board and capture columns alike:
+//   - each kind of piece is assigned its target squares by minimum total distance (Hungarian
+//     method), so pieces already home stay put and the others take the nearest free target;
+//     pieces the target has no room for are sent to their colour's capture column (white 0,
+//     black 9), pieces it needs but that are nowhere to be found are reported as missing;
+//   - the moves are then ordered greedily: next is whichever move with a free destination is
+//     quickest to reach and carry around the pieces standing at that point (carriageClearPath);
+//   - when every remaining destination is still taken by a piece that has to move itself (e.g. two
+//     pieces swapping squares), one of them is parked on a free capture-column cell first.
+// Cells are motor cells: row * CARRIAGE_COLS + col, board file f at column f + 1.
+
+#include "chess_position.h"
+#include "carriage_path.h"
+#include "motion_planner.h"
+#include "graveyard.h"
+
+const int SETUP_CELLS = CARRIAGE_ROWS * CARRIAGE_COLS;
+const int SETUP_MAX_STEPS = 96;
+const uint8_t SETUP_NO_CELL = 0xFF;
+
+struct SetupCells {
+    uint8_t piece[SETUP_CELLS];   // piece code, NO_PIECE if empty
+};
+
+struct SetupStep {
+    uint8_t from, to;             // cells
+    uint8_t piece;
+    bool parking;                 // to is a temporary spot, the piece moves on later
+};
+
+struct SetupPlan {
+    SetupStep steps[SETUP_MAX_STEPS];
+    int count;
+    uint8_t missing[12];          // by piece code: still to be put on the board by hand
+    int missingCount;
+    float seconds;                // planned carriage time, travel included
+};
+
+inline int setupCell(int row, int col) { return row * CARRIAGE_COLS + col; }
+inline int setupCellRow(int cell) { return cell / CARRIAGE_COLS; }
+inline int setupCellCol(int cell) { return cell % CARRIAGE_COLS; }
+inline int setupCellOfSquare(int sq) { return setupCell(squareRow(sq), squareCol(sq) + 1); }
+
+// The board squares of pos, capture columns empty.
+void setupCellsFromPosition(const Position &pos, SetupCells &out);
+// Adds what the graveyard holds to the capture-column cells, and reads it back after a setup.
+void setupCellsAddGraveyard(const Graveyard &g, SetupCells &cells);
+void setupGraveyard(const SetupCells &cells, Graveyard &out);
+// Occupied cells as carriage obstacles.
+void setupObstacles(const SetupCells &cells, CarriageObstacles &out);
+// Applies one step to cells.
+void setupApply(SetupCells &cells, const SetupStep &step);
+
+// Plans the moves from `current` to `target` starting with the carriage at (row, col).
+// False if there is no free capture-column cell to park or clear to, or the plan would not fit.
+// Uses static working memory (through carriageClearPath): not reentrant.
+bool planBoardSetup(const CarriageGeometry &geometry, const MotionLimits &limits, const SetupCells &current,
+                    const Position &target, int carriageRow, int carriageCol, SetupPlan &out);
@@ -0,0 +1,261 @@
+#include "carriage_path.h"
+#include <math.h>
+
+namespace {
+
+void addLeg(CarriagePath &path, float dxMm, float dyMm) {
+    path.dxMm[path.count] = dxMm;
+    path.dyMm[path.count] = dyMm;
+    path.count++;
+}
+
+// Half-cell grid: node (r, c) with r in 0..14, c in 0..18; even coordinates are cell centres,
+// odd ones the lanes between them.
+const int GRID_ROWS = 2 * CARRIAGE_ROWS - 1;
+const int GRID_COLS = 2 * CARRIAGE_COLS - 1;
+const int GRID_NODES = GRID_ROWS * GRID_COLS;
+const int DIRECTIONS = 8;
+const int START_DIRECTION = DIRECTIONS;   // the start state has not moved yet
+const int STATES = GRID_NODES * (DIRECTIONS + 1);
+const int DR[DIRECTIONS] = { 1, -1, 0, 0, 1, 1, -1, -1 };
+const int DC[DIRECTIONS] = { 0, 0, 1, -1, 1, -1, 1, -1 };
+const uint16_t NONE = 0xFFFF;
+// Passing between two pieces is allowed only when every other way is at least this much slower
+// (e.g. a knight boxed in on its starting rank).
+const float SQUEEZE_SECONDS = 1.0f;
+
+// A* working memory (states = node * 9 + arriving direction), kept off the loop task's stack
+float stateCost[STATES];
+uint16_t stateParent[STATES];
+uint16_t heapIndex[STATES];   // position in the open heap, NONE when not in it
+bool stateClosed[STATES];
+uint16_t openHeap[STATES];
+int openCount;
+
+float nodeX(const CarriageGeometry &geometry, int r) { return r * geometry.halfRow; }
+
+float nodeY(const CarriageGeometry &geometry, int c) {
+    if (!(c & 1)) return geometry.colOffsets[c / 2];
+    return 0.5f * (geometry.colOffsets[c / 2] + geometry.colOffsets[c / 2 + 1]);
+}
+
+struct SearchGrid {
+    const CarriageGeometry *geometry;
+    const CarriageObstacles *obstacles;
+    int fromRow, fromCol, toRow, toCol;
+};
+
+bool cellOccupied(const SearchGrid &grid, int row, int col) {
+    if ((row == grid.fromRow && col == grid.fromCol) || (row == grid.toRow && col == grid.toCol)) return false;
+    if (col == 0) return grid.obstacles->capture[0] & (1 << row);
+    if (col == CARRIAGE_COLS - 1) return grid.obstacles->capture[1] & (1 << row);
+    return grid.obstacles->board & squareBit(squareOf(row, col - 1));
+}
+
+bool centreBlocked(const SearchGrid &grid, int r, int c) {
+    return !(r & 1) && !(c & 1) && cellOccupied(grid, r / 2, c / 2);
+}
+
+// A lane point between two cells with pieces on both sides.
+bool squeezed(const SearchGrid &grid, int r, int c) {
+    if ((r & 1) && !(c & 1)) return cellOccupied(grid, r / 2, c / 2) && cellOccupied(grid, r / 2 + 1, c / 2);
+    if (!(r & 1) && (c & 1)) return cellOccupied(grid, r / 2, c / 2) && cellOccupied(grid, r / 2, c / 2 + 1);
+    return false;
+}
+
+bool stepAllowed(const SearchGrid &grid, int r, int c, int dir) {
+    int nr = r + DR[dir], nc = c + DC[dir];
+    if (nr < 0 || nr >= GRID_ROWS || nc < 0 || nc >= GRID_COLS) return false;
+    if (centreBlocked(grid, nr, nc)) return false;
+    // a diagonal step passes close to the two corners it cuts
+    if (DR[dir] && DC[dir] && (centreBlocked(grid, nr, c) || centreBlocked(grid, r, nc))) return false;
+    return true;
+}
+
+// Lower bound of the time to the target: every leg takes at least its L1 length at full speed.
+float remaining(const SearchGrid &grid, const MotionLimits &limits, int r, int c) {
+    const CarriageGeometry &geometry = *grid.geometry;
+    return (fabsf(nodeX(geometry, r) - nodeX(geometry, 2 * grid.toRow)) +
+            fabsf(nodeY(geometry, c) - nodeY(geometry, 2 * grid.toCol))) / limits.maxSpeed;
+}
+
+float openPriority(int state, const float *heuristic) { return stateCost[state] + heuristic[state / (DIRECTIONS + 1)]; }
+
+void heapSwap(int a, int b) {
+    uint16_t sa = openHeap[a], sb = openHeap[b];
+    openHeap[a] = sb; openHeap[b] = sa;
+    heapIndex[sb] = uint16_t(a); heapIndex[sa] = uint16_t(b);
+}
+
+void heapUp(int i, const float *heuristic) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (openPriority(openHeap[parent], heuristic) <= openPriority(openHeap[i], heuristic)) break;
+        heapSwap(i, parent);
+        i = parent;
+    }
+}
+
+void heapDown(int i, const float *heuristic) {
+    for (;;) {
+        int best = i, left = 2 * i + 1, right = left + 1;
+        if (left < openCount && openPriority(openHeap[left], heuristic) < openPriority(openHeap[best], heuristic)) best = left;
+        if (right < openCount && openPriority(openHeap[right], heuristic) < openPriority(openHeap[best], heuristic)) best = right;
+        if (best == i) return;
+        heapSwap(i, best);
+        i = best;
+    }
+}
+
+void openPush(int state, const float *heuristic) {
+    if (heapIndex[state] == NONE) {
+        openHeap[openCount] = uint16_t(state);
+        heapIndex[state] = uint16_t(openCount++);
+    }
+    heapUp(heapIndex[state], heuristic);
+}
+
+int openPop(const float *heuristic) {
+    int state = openHeap[0];
+    heapIndex[state] = NONE;
+    if (--openCount > 0) {
+        openHeap[0] = openHeap[openCount];
+        heapIndex[openHeap[0]] = 0;
+        heapDown(0, heuristic);
+    }
+    return state;
+}
+
+} // namespace
+
+void carriageGeometryInit(CarriageGeometry &geometry, float cellMm, float gapMm) {
+    geometry.cellMm = cellMm;
+    geometry.halfRow = cellMm * 0.5f;
+    geometry.colOffsets[0] = 0.0f;
+    geometry.halfCol[0] = gapMm * 0.5f;
+    for (int i = 1; i < CARRIAGE_COLS; ++i) {
+        if (i == 1) {
+            geometry.colOffsets[i] = gapMm;
+            geometry.halfCol[i] = geometry.halfRow;
+        } else if (i == CARRIAGE_COLS - 1) {
+            geometry.colOffsets[i] = geometry.colOffsets[i - 1] + gapMm;
+            geometry.halfCol[i] = gapMm * 0.5f;
+        } else {
+            geometry.colOffsets[i] = geometry.colOffsets[i - 1] + cellMm;
+            geometry.halfCol[i] = geometry.halfRow;
+        }
+    }
+}
+
+void carriageLanePath(const CarriageGeometry &geometry, int fromRow, int fromCol, int toRow, int toCol,
+                      CarriagePath &out) {
+    out.count = 0;
+    if (fromRow == toRow && fromCol == toCol) return;
+    float dx = (toRow - fromRow) * geometry.cellMm;
+    float dy = geometry.colOffsets[toCol] - geometry.colOffsets[fromCol];
+    if (fromRow == toRow) {
+        float vdir = (fromRow <= (CARRIAGE_ROWS - 1) / 2 ? +1.0f : -1.0f);
+        addLeg(out, vdir * geometry.halfRow, 0);
+        addLeg(out, 0, dy);
+        addLeg(out, -vdir * geometry.halfRow, 0);
+        return;
+    }
+    if (fromCol == toCol) {
+        float hdir = (fromCol <= (CARRIAGE_COLS - 1) / 2 ? +1.0f : -1.0f);
+        addLeg(out, 0, hdir * geometry.halfCol[fromCol]);
+        addLeg(out, dx, 0);
+        addLeg(out, 0, -hdir * geometry.halfCol[toCol]);
+        return;
+    }
+    float sx = (dx > 0 ? +1.0f : -1.0f);
+    float sy = (dy > 0 ? +1.0f : -1.0f);
+    float hxs = geometry.halfCol[fromCol], hxe = geometry.halfCol[toCol];
+    float hys = geometry.halfRow, hye = geometry.halfRow;
+    addLeg(out, 0, sy * hxs);
+    addLeg(out, sx * hys, 0);
+    addLeg(out, 0, dy - sy * (hxs + hxe));
+    addLeg(out, dx - sx * (hys + hye), 0);
+    addLeg(out, sx * hye, 0);
+    addLeg(out, 0, sy * hxe);
+}
+
+void carriageDirectPath(const CarriageGeometry &geometry, int fromRow, int fromCol, int toRow, int toCol,
+                        CarriagePath &out) {
+    out.count = 0;
+    if (fromRow == toRow && fromCol == toCol) return;
+    addLeg(out, (toRow - fromRow) * geometry.cellMm, geometry.colOffsets[toCol] - geometry.colOffsets[fromCol]);
+}
+
+bool carriageClearPath(const CarriageGeometry &geometry, const CarriageObstacles &obstacles,
+                       const MotionLimits &limits, int fromRow, int fromCol, int toRow, int toCol,
+                       CarriagePath &out) {
+    out.count = 0;
+    if (fromRow == toRow && fromCol == toCol) return true;
+    SearchGrid grid = { &geometry, &obstacles, fromRow, fromCol, toRow, toCol };
+    // a new leg costs roughly the ramp up to speed it starts with
+    float legCost = motionTransitionTime(limits, 0.0f, limits.maxSpeed);
+    static float heuristic[GRID_NODES];
+    for (int node = 0; node < GRID_NODES; node++) heuristic[node] = remaining(grid, limits, node / GRID_COLS, node % GRID_COLS);
+
+    for (int state = 0; state < STATES; state++) {
+        stateCost[state] = INFINITY;
+        stateParent[state] = NONE;
+        heapIndex[state] = NONE;
+        stateClosed[state] = false;
+    }
+    openCount = 0;
+    int start = ((2 * fromRow) * GRID_COLS + 2 * fromCol) * (DIRECTIONS + 1) + START_DIRECTION;
+    int goalNode = (2 * toRow) * GRID_COLS + 2 * toCol;
+    stateCost[start] = 0.0f;
+    openPush(start, heuristic);
+
+    int goal = -1;
+    while (openCount > 0) {
+        int state = openPop(heuristic);
+        int node = state / (DIRECTIONS + 1), arrived = state % (DIRECTIONS + 1);
+        if (node == goalNode) {
+            goal = state;
+            break;
+        }
+        stateClosed[state] = true;
+        int r = node / GRID_COLS, c = node % GRID_COLS;
+        for (int dir = 0; dir < DIRECTIONS; dir++) {
+            if (!stepAllowed(grid, r, c, dir)) continue;
+            int nr = r + DR[dir], nc = c + DC[dir];
+            int next = (nr * GRID_COLS + nc) * (DIRECTIONS + 1) + dir;
+            if (stateClosed[next]) continue;
+            // as long as the busier motor: |dx| + |dy| at full motor speed
+            float cost = stateCost[state] +
+                         (fabsf(nodeX(geometry, nr) - nodeX(geometry, r)) + fabsf(nodeY(geometry, nc) - nodeY(geometry, c))) /
+                         limits.maxSpeed;
+            if (dir != arrived) cost += legCost;
+            if (squeezed(grid, nr, nc)) cost += SQUEEZE_SECONDS;
+            if (cost >= stateCost[next]) continue;
+            stateCost[next] = cost;
+            stateParent[next] = uint16_t(state);
+            openPush(next, heuristic);
+        }
+    }
+    if (goal < 0) return false;
+
+    // walk back, one leg per run of the same direction
+    CarriagePath reversed;
+    reversed.count = 0;
+    int legDir = -1;
+    for (int state = goal; stateParent[state] != NONE; state = stateParent[state]) {
+        int node = state / (DIRECTIONS + 1), dir = state % (DIRECTIONS + 1);
+        int prevNode = stateParent[state] / (DIRECTIONS + 1);
+        float dx = nodeX(geometry, node / GRID_COLS) - nodeX(geometry, prevNode / GRID_COLS);
+        float dy = nodeY(geometry, node % GRID_COLS) - nodeY(geometry, prevNode % GRID_COLS);
+        if (dir == legDir) {
+            reversed.dxMm[reversed.count - 1] += dx;
+            reversed.dyMm[reversed.count - 1] += dy;
+            continue;
+        }
+        if (reversed.count == CARRIAGE_PATH_MAX) return false;
+        addLeg(reversed, dx, dy);
+        legDir = dir;
+    }
+    for (int i = reversed.count - 1; i >= 0; i--) addLeg(out, reversed.dxMm[i], reversed.dyMm[i]);
+    return true;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+// Carriage geometry and the paths the magnet follows between motor cells.
+// Motor cells are rows 0-7 and columns 0-9: columns 1-8 are the board files a-h, columns 0 and 9
+// the capture columns, each separated from the board by a wider gap. The carriage works in mm,
+// x along the rows and y along the columns (motionSegment's dx / dy).
+//
+// A carried piece must not brush the pieces it passes, so the lane path leaves the cell centre by
+// half a cell into the lane beside it, travels along the lanes and enters the target cell the
+// same way: up to six axis-aligned legs (three when the row or the column does not change).
+// With the magnet released nothing is dragged along, and the carriage goes straight there.
+//
+// The clear path searches the half-cell grid (cell centres, the lanes between cells and their
+// crossings, with diagonal steps) for the quickest route around the pieces actually on the board:
+//   - it never crosses an occupied cell centre, nor cuts a corner closer to one than a lane does;
+//   - it squeezes through a lane point with occupied cells on both sides only when any way
+//     around is much slower (a boxed-in piece has no other way out);
+//   - its cost is the motion time (a leg takes as long as its busier CoreXY motor, so a diagonal
+//     is no faster than the L it replaces) plus a fixed cost per leg for the corner it adds.
+
+#include "chess_position.h"
+#include "motion_planner.h"
+
+const int CARRIAGE_ROWS = 8;
+const int CARRIAGE_COLS = 10;   // 0 & 9 = capture columns
+const int CARRIAGE_PATH_MAX = MOTION_PLAN_MAX_BLOCKS;
+
+struct CarriageGeometry {
+    float cellMm;
+    float halfRow;                       // half a cell: row centre to the lane beside it
+    float colOffsets[CARRIAGE_COLS];     // column centre, mm from column 0
+    float halfCol[CARRIAGE_COLS];        // column centre to the lane beside it
+};
+
+// Cells the carried piece must go around: the board squares (bit = chess square, motor column =
+// file + 1) and the capture columns (bit = row; [0] = column 0, [1] = column 9).
+struct CarriageObstacles {
+    Bitboard board;
+    uint8_t capture[2];
+};
+
+struct CarriagePath {
+    float dxMm[CARRIAGE_PATH_MAX];
+    float dyMm[CARRIAGE_PATH_MAX];
+    int count;
+};
+
+// gapMm: distance between the capture columns' centres and the first / last file's centre.
+void carriageGeometryInit(CarriageGeometry &geometry, float cellMm, float gapMm);
+
+// Lane path from one motor cell to another (relative legs, in order); empty when they are the same cell.
+void carriageLanePath(const CarriageGeometry &geometry, int fromRow, int fromCol, int toRow, int toCol,
+                      CarriagePath &out);
+// Straight line from one motor cell to another (one leg), for travel with the magnet released.
+void carriageDirectPath(const CarriageGeometry &geometry, int fromRow, int fromCol, int toRow, int toCol,
+                        CarriagePath &out);
+
+// Clear path for a carried piece (see above); the start and target cells count as empty.
+// False when there is none (pieces wall the target off) or it needs more than CARRIAGE_PATH_MAX legs.
+// Uses static working memory: not reentrant.
+bool carriageClearPath(const CarriageGeometry &geometry, const CarriageObstacles &obstacles,
+                       const MotionLimits &limits, int fromRow, int fromCol, int toRow, int toCol,
+                       CarriagePath &out);
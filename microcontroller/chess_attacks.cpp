@@ -0,0 +1,70 @@
+#include "chess_attacks.h"
+
+// Generators are C++11 single-return constexpr so the tables build with older arduino-esp32 cores too.
+
+namespace {
+
+constexpr bool onBoard(int row, int col) { return row >= 0 && row < 8 && col >= 0 && col < 8; }
+
+constexpr Bitboard stepBit(int sq, int dr, int dc) {
+    return onBoard(sq / 8 + dr, sq % 8 + dc) ? Bitboard(1) << ((sq / 8 + dr) * 8 + sq % 8 + dc) : 0;
+}
+
+constexpr Bitboard knightMask(int sq) {
+    return stepBit(sq, 2, 1) | stepBit(sq, 1, 2) | stepBit(sq, -1, 2) | stepBit(sq, -2, 1) |
+           stepBit(sq, -2, -1) | stepBit(sq, -1, -2) | stepBit(sq, 1, -2) | stepBit(sq, 2, -1);
+}
+
+constexpr Bitboard kingMask(int sq) {
+    return stepBit(sq, 1, 0) | stepBit(sq, 1, 1) | stepBit(sq, 0, 1) | stepBit(sq, -1, 1) |
+           stepBit(sq, -1, 0) | stepBit(sq, -1, -1) | stepBit(sq, 0, -1) | stepBit(sq, 1, -1);
+}
+
+constexpr Bitboard whitePawnMask(int sq) { return stepBit(sq, 1, -1) | stepBit(sq, 1, 1); }
+constexpr Bitboard blackPawnMask(int sq) { return stepBit(sq, -1, -1) | stepBit(sq, -1, 1); }
+
+// Every square after sq up to the board edge in direction (dr, dc).
+constexpr Bitboard rayMask(int sq, int dr, int dc) {
+    return onBoard(sq / 8 + dr, sq % 8 + dc)
+        ? stepBit(sq, dr, dc) | rayMask((sq / 8 + dr) * 8 + sq % 8 + dc, dr, dc)
+        : 0;
+}
+
+constexpr Bitboard rayN(int sq) { return rayMask(sq, 1, 0); }
+constexpr Bitboard rayE(int sq) { return rayMask(sq, 0, 1); }
+constexpr Bitboard rayNE(int sq) { return rayMask(sq, 1, 1); }
+constexpr Bitboard rayNW(int sq) { return rayMask(sq, 1, -1); }
+constexpr Bitboard rayS(int sq) { return rayMask(sq, -1, 0); }
+constexpr Bitboard rayW(int sq) { return rayMask(sq, 0, -1); }
+constexpr Bitboard raySW(int sq) { return rayMask(sq, -1, -1); }
+constexpr Bitboard raySE(int sq) { return rayMask(sq, -1, 1); }
+
+} // namespace
+
+#define ATTACK_ROW8(f, base) f(base + 0), f(base + 1), f(base + 2), f(base + 3), \
+                             f(base + 4), f(base + 5), f(base + 6), f(base + 7)
+#define ATTACK_TABLE64(f) { ATTACK_ROW8(f, 0), ATTACK_ROW8(f, 8), ATTACK_ROW8(f, 16), ATTACK_ROW8(f, 24), \
+                            ATTACK_ROW8(f, 32), ATTACK_ROW8(f, 40), ATTACK_ROW8(f, 48), ATTACK_ROW8(f, 56) }
+
+namespace attack_tables {
+
+constexpr Bitboard KNIGHT_ATTACKS[64] = ATTACK_TABLE64(knightMask);
+constexpr Bitboard KING_ATTACKS[64] = ATTACK_TABLE64(kingMask);
+constexpr Bitboard PAWN_ATTACKS[2][64] = { ATTACK_TABLE64(whitePawnMask), ATTACK_TABLE64(blackPawnMask) };
+constexpr Bitboard RAYS[8][64] = {
+    ATTACK_TABLE64(rayN), ATTACK_TABLE64(rayE), ATTACK_TABLE64(rayNE), ATTACK_TABLE64(rayNW),
+    ATTACK_TABLE64(rayS), ATTACK_TABLE64(rayW), ATTACK_TABLE64(raySW), ATTACK_TABLE64(raySE)
+};
+
+// Spot checks evaluated by the compiler: a table that built wrong never reaches the board.
+static_assert(KNIGHT_ATTACKS[0] == 0x0000000000020400ULL, "knight a1");
+static_assert(KING_ATTACKS[63] == 0x40C0000000000000ULL, "king h8");
+static_assert(PAWN_ATTACKS[PIECE_WHITE][8] == 0x0000000000020000ULL, "white pawn a2");
+static_assert(PAWN_ATTACKS[PIECE_BLACK][55] == 0x0000400000000000ULL, "black pawn h7");
+static_assert(RAYS[RAY_N][0] == 0x0101010101010100ULL, "ray north a1");
+static_assert(RAYS[RAY_SW][63] == 0x0040201008040201ULL, "ray south-west h8");
+
+} // namespace attack_tables
+
+#undef ATTACK_TABLE64
+#undef ATTACK_ROW8
@@ -0,0 +1,53 @@
+#pragma once
+
+// Precomputed attack tables (knight / king / pawn masks and per-direction rays).
+// The tables are generated at compile time (chess_attacks.cpp) and live in .rodata — flash on the ESP32.
+// Sliding attacks use the classical ray + first-blocker bitscan: no loops, no PEXT (Xtensa has none)
+// and 4 KB of rays instead of the ~800 KB a magic-bitboard table would need.
+
+#include "chess_position.h"
+
+namespace attack_tables {
+
+// The first four directions increase the square index (first blocker = lowest bit),
+// the last four decrease it (first blocker = highest bit).
+enum RayDirection : uint8_t { RAY_N, RAY_E, RAY_NE, RAY_NW, RAY_S, RAY_W, RAY_SW, RAY_SE };
+
+extern const Bitboard KNIGHT_ATTACKS[64];
+extern const Bitboard KING_ATTACKS[64];
+extern const Bitboard PAWN_ATTACKS[2][64];   // [color][sq]
+extern const Bitboard RAYS[8][64];           // [RayDirection][sq], squares up to the board edge
+
+inline Bitboard positiveRay(int dir, int sq, Bitboard occupancy) {
+    Bitboard ray = RAYS[dir][sq];
+    Bitboard blockers = ray & occupancy;
+    return blockers ? ray ^ RAYS[dir][__builtin_ctzll(blockers)] : ray;
+}
+
+inline Bitboard negativeRay(int dir, int sq, Bitboard occupancy) {
+    Bitboard ray = RAYS[dir][sq];
+    Bitboard blockers = ray & occupancy;
+    return blockers ? ray ^ RAYS[dir][63 - __builtin_clzll(blockers)] : ray;
+}
+
+} // namespace attack_tables
+
+inline Bitboard knightAttacks(int sq) { return attack_tables::KNIGHT_ATTACKS[sq]; }
+inline Bitboard kingAttacks(int sq) { return attack_tables::KING_ATTACKS[sq]; }
+inline Bitboard pawnAttacks(uint8_t color, int sq) { return attack_tables::PAWN_ATTACKS[color][sq]; }
+
+inline Bitboard bishopAttacks(int sq, Bitboard occupancy) {
+    using namespace attack_tables;
+    return positiveRay(RAY_NE, sq, occupancy) | positiveRay(RAY_NW, sq, occupancy) |
+           negativeRay(RAY_SW, sq, occupancy) | negativeRay(RAY_SE, sq, occupancy);
+}
+
+inline Bitboard rookAttacks(int sq, Bitboard occupancy) {
+    using namespace attack_tables;
+    return positiveRay(RAY_N, sq, occupancy) | positiveRay(RAY_E, sq, occupancy) |
+           negativeRay(RAY_S, sq, occupancy) | negativeRay(RAY_W, sq, occupancy);
+}
+
+inline Bitboard queenAttacks(int sq, Bitboard occupancy) {
+    return bishopAttacks(sq, occupancy) | rookAttacks(sq, occupancy);
+}
@@ -4,11 +4,32 @@
     #include <HTTPClient.h>
     #include <ArduinoJson.h>
     #include <ESP32Servo.h>
-    #include <AccelStepper.h>
+    #include <Preferences.h>
     #include <cctype>
     #include <string.h>
     #include <math.h>
-    #include <utility>
+    #include "chess_position.h"
+    #include "chess_movegen.h"
+    #include "chess_move_table.h"
+    #include "board_sensors.h"
+    #include "chess_notation.h"
+    #include "board_protocol.h"
+    #include "socketio_packet.h"
+    #include "sensor_stream.h"
+    #include "sensor_snapshot.h"
+    #include "sensor_filter.h"
+    #include "move_tracker.h"
+    #include "move_inference.h"
+    #include "scan_scheduler.h"
+    #include "motion_queue.h"
+    #include "motion_planner.h"
+    #include "carriage_path.h"
+    #include "step_generator.h"
+    #include "pick_place.h"
+    #include "motion_tuning.h"
+    #include "board_setup.h"
+    #include "graveyard.h"
+    #include "board_hal.h"
 
     // Pin Definitions
     const int SIG = 34;
@@ -17,6 +38,7 @@
     const int BTN_PIN = 4;
     const int LED_PIN = 16;
     const int RESIGN_PIN = 15; // زر الاستسلام - يمكن تغييره حسب الحاجة
+    const ReedMuxPins REED_PINS = { SIG, { S0, S1, S2, S3 }, { E0, E1, E2, E3 } };
 
     #define STEP_PIN_A   5
     #define DIR_PIN_A    2
@@ -45,9 +67,16 @@
 
     // Global Variables
     WebSocketsClient webSocket;
-    String currentFen = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    // FEN / move text lives in fixed buffers (chess_notation, board_protocol) so a long session
+    // never fragments the heap with String concatenation.
+    char currentFen[FEN_MAX_LEN] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
     String gameId, playerColor = "white", currentTurn = "white", userToken;
-    String lastProcessedFen = currentFen; // متغير لتتبع آخر FEN تم معالجته
+    // Parsed once whenever a FEN arrives from the server; updated by makeMove() for our own moves.
+    // Change detection compares Position::hash (Zobrist) instead of FEN strings.
+    Position gamePosition;
+    Position lastProcessedPosition; // آخر وضعية تمت معالجتها (حركة الخصم نُفّذت أو تم تجاهلها)
+    // Legal moves of gamePosition keyed by their sensor delta; rebuilt whenever gamePosition changes.
+    MoveSignatureTable legalMoveTable;
     unsigned long lastServerUpdate = 0;
     const unsigned long SERVER_UPDATE_INTERVAL = 15000; // كل 15 ثانية - WebSocket يتولى التحديث الفوري
     unsigned long lastGameStatusCheck = 0;
@@ -63,8 +92,39 @@
     bool namespaceJoined = false;   // Socket.IO /friends namespace confirmed joined
     String lastEndedGameId = "";
     volatile bool opponentMovePending = false; // علامة سريعة: WS وصل حركة خصم جديدة
-    unsigned long lastSensorBroadcast = 0;
-    const unsigned long SENSOR_BROADCAST_INTERVAL_MS = 120;
+    volatile bool gameEndPending = false;      // gameEnd / gameTimeout وصل عبر WS
+    long whiteTimeLeft = -1, blackTimeLeft = -1; // from clockUpdate events (-1 until the first one)
+    // Sensor task: owns the reed muxes, wakes every SENSOR_TASK_PERIOD_MS on core 0, scans what the
+    // scan scheduler asks for (the whole board every SCAN_SCHEDULER_DEFAULTS.fullScanMs, the squares
+    // around a change on every tick) and publishes filtered snapshots; everything else reads
+    // sensorSnapshots and never scans itself, so the board is still watched while loop() (core 1)
+    // is stuck in an HTTP call.
+    const uint32_t SENSOR_TASK_PERIOD_MS = 2;
+    const BaseType_t SENSOR_TASK_CORE = 0;
+    SensorSnapshotChannel sensorSnapshots;
+    // Per-square filter thresholds: defaults until calibrateEmptyBoard() measures them. Handed to the
+    // task through the flag: the task copies the config, then clears it.
+    SensorFilterConfig pendingSensorFilterConfig;
+    std::atomic<bool> sensorFilterConfigPending(false);
+    // Rescan regions for the current legal moves, handed over the same way (refreshLegalMoveTable)
+    ScanRoiMap pendingScanRoiMap;
+    std::atomic<bool> scanRoiMapPending(false);
+    SensorErrorModel sensorErrors;   // per-reed error rates for move inference, from the same calibration
+    // A move is read once the filtered board has not changed for SENSOR_QUIET_MS
+    const uint32_t SENSOR_QUIET_MS = 50;
+    const uint32_t SENSOR_SETTLE_TIMEOUT_MS = 600;
+    // Button-free move detection (move_tracker.h): on the player's turn every new snapshot goes to
+    // the tracker, which commits the move once the board has held a legal result for dwellMs.
+    // BTN_PIN still works as "read the board now".
+    const bool AUTO_MOVE_DETECTION = true;
+    const MoveTrackerConfig MOVE_TRACKER_CONFIG = { 300, 1500 }; // dwell, report-illegal (ms)
+    MoveTracker moveTracker;
+    uint32_t lastTrackedScan = 0;
+    // Live view: the latest snapshot is fed to the stream every SENSOR_SCAN_INTERVAL_MS, but a
+    // boardSensorUpdate frame only goes out when the occupancy changes (coalesced) or as a 5 s keyframe.
+    unsigned long lastSensorScan = 0;
+    const unsigned long SENSOR_SCAN_INTERVAL_MS = 60;
+    SensorStream sensorStream;
 
     // Interrupt-based button detection — captures press even during HTTP blocking calls
     volatile bool btnPressedFlag = false;
@@ -75,45 +135,62 @@
 
     bool boardState[8][8], lastBoard[8][8];
     bool protectedOldBoard[8][8];
-    String protectedOldFen;
+    char protectedOldFen[FEN_MAX_LEN];
+    Position protectedOldPosition;
     bool isBoardProtected = false;
-    bool baselineBoard[8][8] = {}; // squares active on empty board (false positives to ignore)
 
-    AccelStepper motorA(AccelStepper::DRIVER, STEP_PIN_A, DIR_PIN_A);
-    AccelStepper motorB(AccelStepper::DRIVER, STEP_PIN_B, DIR_PIN_B);
+    // Step pulses come from a hardware timer interrupt (onStepTimer), not from polling the motors
+    StepGenerator stepGen;
+    hw_timer_t *stepTimer = nullptr;
+    const uint64_t STEP_BIT_A = 1ULL << STEP_PIN_A, STEP_BIT_B = 1ULL << STEP_PIN_B;
+    const uint64_t DIR_BIT_A = 1ULL << DIR_PIN_A, DIR_BIT_B = 1ULL << DIR_PIN_B;
+    const uint64_t STEPPER_PIN_BITS = STEP_BIT_A | STEP_BIT_B | DIR_BIT_A | DIR_BIT_B;
     Servo myServo;
     int currentServoAngle = SERVO_RELEASE_ANGLE;
     bool servoAngleInitialized = false;
+    // Motion task: runs motionQueue on core 0 (below the sensor task), so loop() queues a whole
+    // opponent move and goes on serving the WebSocket, the live view and the buttons while the
+    // carriage moves. Only the motion task (and its step timer) touches the steppers and the servo
+    // once it has started.
+    const BaseType_t MOTION_TASK_CORE = 0;
+    MotionQueue motionQueue;
 
     // Grid & Motion Parameters
     const float STEPS_PER_MM = 50.0f;
     const float CELL_SIZE_MM = 5.29f;
-    const int ROWS = 8;
-    const int COLS = 10;          // 0 & 9 = capture cols
-    const float G0_MM = 1.5f * CELL_SIZE_MM;
-    const float G1_MM = 1.5f * CELL_SIZE_MM;
-
-    const float MIN_END_SPEED = 1100.0f;
-    const float MAX_END_SPEED = 1500.0f;
-    const float RAMP_TIME = 0.2f;
-
-    float colOffsets[COLS], halfCol[COLS];
-    const float halfRow = CELL_SIZE_MM * 0.5f;
-    const float MIN_DIST_STEPS = CELL_SIZE_MM * STEPS_PER_MM;
-    const float MAX_DIST_STEPS = sqrtf(ROWS*ROWS + COLS*COLS) * CELL_SIZE_MM * STEPS_PER_MM;
+    const float CAPTURE_GAP_MM = 1.5f * CELL_SIZE_MM; // capture columns 0 & 9 ↔ board
+    CarriageGeometry carriage;
+    // Consecutive queued segments are planned together (motion_planner.h) and run through their
+    // corners, with the limits of what the magnet carries (motion_tuning.h); steps left when a
+    // block's profile ends run at no less than MIN_FOLLOW_SPEED_MM_S.
+    // motionProfiles is loaded from flash in setup() and only changed while the queue is idle.
+    MotionProfiles motionProfiles = MOTION_PROFILES_DEFAULTS;
+    Preferences motionPrefs;
+    bool tuningRequested = false; // button held at power-up
+    const float MIN_FOLLOW_SPEED_MM_S = 2.0f;
+    // Magnet arm timing (pick_place.h): the servo swings while the carriage is still moving and only
+    // the part of its travel that matters is waited for. 450°/s = 90° in 200 ms, a little slower
+    // than the old 150 ms engage wait assumed.
+    const ServoTiming SERVO_TIMING = { 450.0f, SERVO_ENGAGE_ANGLE, SERVO_RELEASE_ANGLE, SERVO_RELEASE_HOME_ANGLE, 40, 60 };
+    PickPlace pickPlace;
 
     // Runtime State
     long currentRow = 0, currentCol = 0;
+    // Whether the magnet will be engaged once the queue has run (the last servo command queued):
+    // only then does moveToCell need the lanes between the squares.
+    bool magnetEngaged = false;
+    MotionLoad carriedLoad = MOTION_LOAD_LIGHT; // what the engaged magnet holds (set by carryPiece)
+    // Pieces a carried piece has to go around, as they will stand when the queue gets there
+    // (set and updated by executeOpponentMove).
+    CarriageObstacles carriageObstacles = { 0, { 0, 0 } };
+    // The captured pieces in columns 0 / 9 as they will stand once the queue has run.
+    Graveyard graveyard;
 
     struct MoveResult {
-        String fromSq, toSq, san, newFen;
-    };
-
-    enum BoardTransform : uint8_t {
-        MAP_IDENTITY = 0,      // sensor(r,c) -> chess(r,c)
-        MAP_MIRROR_ROWS = 1,   // sensor(r,c) -> chess(7-r,c)
-        MAP_MIRROR_COLS = 2,   // sensor(r,c) -> chess(r,7-c)
-        MAP_MIRROR_BOTH = 3    // sensor(r,c) -> chess(7-r,7-c)
+        char fromSq[3], toSq[3];
+        char san[SAN_MAX_LEN];
+        char newFen[FEN_MAX_LEN];
+        Move move = MOVE_NONE;
     };
 
     // Lock board sensor mapping to avoid symmetric ambiguities.
@@ -126,110 +203,125 @@
     String getServerBaseUrl();
     void   connectWebSocket();
     void scanBoard();
-    void scanBoardTo(bool outBoard[8][8]);
-    bool scanBoardStable(bool outBoard[8][8], int samples, int gapMs);
-    bool readReed(int mux, int ch);
+    void sensorTask(void *param);
+    void startSensorTask();
+    void readSensorSnapshot(SensorSnapshot &out);
+    void readSettledBoard(bool outBoard[8][8], uint32_t quietMs, uint32_t timeoutMs);
     void countDiffs(bool oldB[8][8], bool newB[8][8], int &rem, int &add);
     void logBoardDiffDetails(bool oldB[8][8], bool newB[8][8]);
-    MoveResult computeMove(bool oldB[8][8], bool newB[8][8], const String &oldFen);
-    bool validateChessMove(const String &fen, const String &fromSq, const String &toSq, const String &currentTurn);
-    void updateOldBoardFromFen(const String &fen);
+    MoveResult computeMove(bool oldB[8][8], bool newB[8][8], const Position &pos);
+    bool updateOldBoardFromFen(const char *fen);
+    void restoreProtectedState();
+    void initJsonFilters();
+    bool readServerResponse(HTTPClient &http, const JsonDocument &filter, JsonDocument &doc);
     bool getTokenAndGameId();
     bool updateBoardStateFromServer();
     void webSocketEvent(WStype_t type, uint8_t* payload, size_t length);
+    void handleSocketPacket(const SocketIoPacket &packet);
+    DeserializationError readEventArgs(const PacketSpan &args, const JsonDocument &filter, JsonDocument &doc);
+    void onMoveMadeEvent(const PacketSpan &args);
+    void onClockUpdateEvent(const PacketSpan &args);
+    void onGameEndEvent(const PacketSpan &args);
+    void onGameStartedEvent(const PacketSpan &args);
+    void enterWaitingForNewGame();
     void printBoardArray(bool arr[8][8], const char* name);
     void blinkLED(int n);
-    void executeOpponentMove(const String &prevFen, const String &currentFen);
+    void executeOpponentMove(const Position &prevPos, const Position &curPos);
     void sendBoardSensorUpdate();
     void calibrateEmptyBoard();
     void moveServoSmooth(int targetAngle, int stepDelayMs = SERVO_STEP_DELAY_MS);
-    void fenToBoard(const String &fen, char board[8][8]);
-    bool isValidMove(char board[8][8], int fromRow, int fromCol, int toRow, int toCol, const String &currentTurn);
     void moveToCell(int row, int col);
-    void runSegment(float dx_mm, float dy_mm);
-    void parseFen(const String &fen, char board[8][8]);
-    bool isValidSquare(int row, int col);
-    bool isWhitePiece(char piece);
-    bool isBlackPiece(char piece);
-    bool isCurrentPlayerPiece(char piece, const String &currentTurn);
+    void runPlannedPath(const MotionPlan &plan, const MotionCommand *servoAhead);
+    void queuePickPlace(const MotionCommand *commands, int count);
+    void motionTask(void *param);
+    void startMotionTask();
+    void queueMotion(const MotionCommand &command);
+    bool motionBusy();
+    void carryPiece(int fromRow, int fromCol, int toRow, int toCol, MotionLoad load);
+    void loadMotionProfiles();
+    void saveMotionProfiles();
+    void tuneMotionProfiles();
+    bool tuningCarry(int from, int to, MotionLoad load, MotionLoad pieceLoad, Bitboard before);
+    void waitForBoardRestored(Bitboard expected);
     bool checkGameStatus();
     void returnMotorsToHome();
-    void handleCapture(int r, int c);
+    void carryToGraveyard(int sq, uint8_t piece);
+    bool setupBoardTo(const Position &target);
     bool fetchLastActiveGame();
-    bool submitMoveHTTP(const String &fromSq, const String &toSq, const String &san, const String &fen);
+    bool submitMoveHTTP(const MoveMessage &msg);
     void joinCurrentGameRoom();
-    // Returns (r,c) of any removed piece between prevFen and currentFen, or (-1,-1) if none.
-    std::pair<int,int> findCaptureFromFen(const String& prevFen, const String& currentFen);
-    String normalizeFenForBoard(const String &fen);
-    String sensorToSquare(int sensorRow, int sensorCol, BoardTransform transform);
-    String buildFenAfterMove(const String &oldFen, const String &fromSq, const String &toSq);
-    String buildSimpleSan(const String &oldFen, const String &fromSq, const String &toSq, bool isCapture);
-    bool inferMoveTransform(
-        bool oldB[8][8],
-        bool newB[8][8],
-        const String &oldFen,
-        const String &turn,
-        bool isCapture,
-        MoveResult &outMove,
-        BoardTransform &outTransform
-    );
+    bool normalizeFenForBoard(const char *fen, char out[FEN_MAX_LEN]);
+    void copyFen(char dest[FEN_MAX_LEN], const char *src);
+    String squareToString(int sq);
+    uint8_t playerSide();
+    bool buildMoveResult(const Position &pos, Move move, MoveResult &out);
+    void refreshLegalMoveTable();
+    void commitPlayerMove(const MoveResult &mv);
+    void boardAfterMove(const Position &pos, Move move, bool outBoard[8][8]);
+    void trackPlayerMove();
 
     // Sensor Functions
-    bool readReed(int mux, int ch) {
-        const int E_pins[4] = { E0, E1, E2, E3 };
-        for (int i = 0; i < 4; i++) digitalWrite(E_pins[i], HIGH);
-        digitalWrite(E_pins[mux], LOW);
-        digitalWrite(S0, (ch >> 0) & 1);
-        digitalWrite(S1, (ch >> 1) & 1);
-        digitalWrite(S2, (ch >> 2) & 1);
-        digitalWrite(S3, (ch >> 3) & 1);
-        delayMicroseconds(100);
-        bool closed = digitalRead(SIG) == LOW;
-        digitalWrite(E_pins[mux], HIGH);
-        return closed;
+    void scanBoard() {
+        SensorSnapshot snapshot;
+        readSensorSnapshot(snapshot);
+        sensorBoardFromBits(snapshot.occupancy, boardState);
     }
 
-    void scanBoardTo(bool outBoard[8][8]) {
-        for (int mux = 0; mux < 4; mux++) {
-            int base = mux * 2;
-            for (int ch = 0; ch < 16; ch++) {
-                outBoard[ch % 8][base + (ch < 8 ? 0 : 1)] = readReed(mux, ch);
+    // Scan → filter → publish, forever. A partial scan keeps the last reading of the squares it skipped.
+    void sensorTask(void *param) {
+        SensorFilter filter = SensorFilter();
+        SensorFilterConfig config;
+        sensorFilterDefaults(config);
+        ScanRoiMap roiMap;
+        scanRoiMapDefaults(roiMap);
+        ScanScheduler scheduler = ScanScheduler();
+        Bitboard raw = 0;
+        TickType_t wake = xTaskGetTickCount();
+        for (;;) {
+            if (sensorFilterConfigPending.load(std::memory_order_acquire)) {
+                config = pendingSensorFilterConfig;
+                sensorFilterConfigPending.store(false, std::memory_order_release);
+            }
+            if (scanRoiMapPending.load(std::memory_order_acquire)) {
+                roiMap = pendingScanRoiMap;
+                scanRoiMapPending.store(false, std::memory_order_release);
             }
+            uint32_t now = millis();
+            Bitboard squares = scanSchedulerNext(scheduler, now);
+            if (squares) {
+                raw = (raw & ~squares) | scanSensorSquares(REED_PINS, squares);
+                SensorSnapshot snapshot;
+                sensorFilterUpdate(filter, config, raw, now, snapshot, squares);
+                sensorSnapshotPublish(sensorSnapshots, snapshot);
+                // a square that flips has disagreed on the scans before, so its region is already active
+                scanSchedulerObserve(scheduler, roiMap, ((raw & ~config.suppressed) ^ snapshot.occupancy) & squares, now);
+            }
+            vTaskDelayUntil(&wake, pdMS_TO_TICKS(SENSOR_TASK_PERIOD_MS));
         }
     }
 
-    void scanBoard() {
-        scanBoardTo(boardState);
+    void startSensorTask() {
+        xTaskCreatePinnedToCore(sensorTask, "reed_scan", 4096, nullptr, 2, nullptr, SENSOR_TASK_CORE);
     }
 
-    bool scanBoardStable(bool outBoard[8][8], int samples, int gapMs) {
-        int votes[8][8];
-        memset(votes, 0, sizeof(votes));
-        bool sampleBoard[8][8];
-
-        for (int i = 0; i < samples; i++) {
-            scanBoardTo(sampleBoard);
-            for (int r = 0; r < 8; r++) {
-                for (int c = 0; c < 8; c++) {
-                    if (sampleBoard[r][c]) votes[r][c]++;
-                }
-            }
-            if (gapMs > 0) delay(gapMs);
-        }
+    // Latest snapshot; only waits right after start-up, before the first scan is published.
+    void readSensorSnapshot(SensorSnapshot &out) {
+        while (!sensorSnapshotRead(sensorSnapshots, out)) delay(1);
+    }
 
-        // Use a stricter threshold for squares that appear NEW (currently empty in lastBoard)
-        // to filter out transient magnetic coupling from a moving piece's magnet.
-        // Squares that were already occupied use the normal majority vote.
-        int normalThreshold = (samples / 2) + 1;       // e.g. 4/7
-        int strictThreshold = (samples * 3 / 4) + 1;   // e.g. 6/7 — for "appeared" squares
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                bool wasOccupied = lastBoard[r][c];
-                int thr = wasOccupied ? normalThreshold : strictThreshold;
-                outBoard[r][c] = (votes[r][c] >= thr);
-            }
-        }
-        return true;
+    // Filtered board from a scan taken after the call, once it has not changed for quietMs
+    // (or the latest one after timeoutMs, if pieces keep moving).
+    void readSettledBoard(bool outBoard[8][8], uint32_t quietMs, uint32_t timeoutMs) {
+        uint32_t since = millis();
+        SensorSnapshot snapshot;
+        for (;;) {
+            readSensorSnapshot(snapshot);
+            bool fresh = int32_t(snapshot.scannedAtMs - since) >= 0;
+            if (fresh && snapshot.scannedAtMs - snapshot.changedAtMs >= quietMs) break;
+            if (millis() - since >= timeoutMs) break;
+            delay(2);
+        }
+        sensorBoardFromBits(snapshot.occupancy, outBoard);
     }
 
     void countDiffs(bool oldB[8][8], bool newB[8][8], int &rem, int &add) {
@@ -259,407 +351,107 @@
         }
     }
 
-    String normalizeFenForBoard(const String &fen) {
-        String trimmed = fen;
-        trimmed.trim();
-        if (trimmed == "startpos") {
-            return "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    // Trims the server FEN into out and maps "startpos"; false if empty or longer than any legal FEN.
+    bool normalizeFenForBoard(const char *fen, char out[FEN_MAX_LEN]) {
+        while (*fen && isspace((unsigned char)*fen)) fen++;
+        size_t len = strlen(fen);
+        while (len && isspace((unsigned char)fen[len - 1])) len--;
+        if (len == 8 && strncmp(fen, "startpos", 8) == 0) {
+            copyFen(out, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+            return true;
         }
-        return trimmed;
+        if (len == 0 || len >= FEN_MAX_LEN) return false;
+        memcpy(out, fen, len);
+        out[len] = '\0';
+        return true;
     }
 
-    String sensorToSquare(int sensorRow, int sensorCol, BoardTransform transform) {
-        int rr = sensorRow;
-        int cc = sensorCol;
-        if (transform == MAP_MIRROR_ROWS || transform == MAP_MIRROR_BOTH) rr = 7 - rr;
-        if (transform == MAP_MIRROR_COLS || transform == MAP_MIRROR_BOTH) cc = 7 - cc;
-
-        if (rr < 0 || rr > 7 || cc < 0 || cc > 7) return "";
-        return String(char('a' + cc)) + String(rr + 1);
+    void copyFen(char dest[FEN_MAX_LEN], const char *src) {
+        strncpy(dest, src, FEN_MAX_LEN - 1);
+        dest[FEN_MAX_LEN - 1] = '\0';
     }
 
-    String buildFenAfterMove(const String &oldFen, const String &fromSq, const String &toSq) {
-        String normalizedFen = normalizeFenForBoard(oldFen);
-        String parts[6] = {"", "", "", "", "", ""};
-        int idx = 0, start = 0;
-        for (int i = 0; i <= normalizedFen.length() && idx < 6; i++) {
-            if (i == normalizedFen.length() || normalizedFen[i] == ' ') {
-                parts[idx++] = normalizedFen.substring(start, i);
-                start = i + 1;
-            }
-        }
-        if (idx < 6) return normalizedFen;
-
-        char board[8][8];
-        fenToBoard(normalizedFen, board);
-        int fromCol = fromSq.charAt(0) - 'a';
-        int fromRow = fromSq.charAt(1) - '1';
-        int toCol = toSq.charAt(0) - 'a';
-        int toRow = toSq.charAt(1) - '1';
-        if (!isValidSquare(fromRow, fromCol) || !isValidSquare(toRow, toCol)) return normalizedFen;
-
-        char movingPiece = board[fromRow][fromCol];
-        if (movingPiece == '.') return normalizedFen;
-        board[fromRow][fromCol] = '.';
-        board[toRow][toCol] = movingPiece;
-
-        String boardPart = "";
-        for (int rank = 7; rank >= 0; rank--) {
-            int empty = 0;
-            for (int col = 0; col < 8; col++) {
-                char piece = board[rank][col];
-                if (piece == '.') {
-                    empty++;
-                } else {
-                    if (empty > 0) {
-                        boardPart += String(empty);
-                        empty = 0;
-                    }
-                    boardPart += piece;
-                }
-            }
-            if (empty > 0) boardPart += String(empty);
-            if (rank > 0) boardPart += "/";
-        }
-
-        String nextTurn = (parts[1] == "w") ? "b" : "w";
-        return boardPart + " " + nextTurn + " " + parts[2] + " " + parts[3] + " " + parts[4] + " " + parts[5];
+    String squareToString(int sq) {
+        char name[3];
+        squareName(sq, name);
+        return String(name);
     }
 
-    String buildSimpleSan(const String &oldFen, const String &fromSq, const String &toSq, bool isCapture) {
-        char board[8][8];
-        fenToBoard(normalizeFenForBoard(oldFen), board);
-        int fromCol = fromSq.charAt(0) - 'a';
-        int fromRow = fromSq.charAt(1) - '1';
-        if (!isValidSquare(fromRow, fromCol)) return toSq;
-        char piece = board[fromRow][fromCol];
-        if (piece == '.') return toSq;
-
-        char upper = (piece >= 'a' && piece <= 'z') ? piece - 32 : piece;
-        if (upper == 'P') {
-            return isCapture ? (String(fromSq.charAt(0)) + "x" + toSq) : toSq;
-        }
-        return String(upper) + (isCapture ? String("x") : String("")) + toSq;
+    uint8_t playerSide() {
+        return playerColor == "white" ? PIECE_WHITE : PIECE_BLACK;
     }
 
-    MoveResult computeMove(bool oldB[8][8], bool newB[8][8], const String &oldFen) {
-        String normalizedFen = normalizeFenForBoard(oldFen);
-        String parts[6];
-        int idx=0, start=0;
-        for (int i=0; i<=normalizedFen.length() && idx<6; i++) {
-            if (i==normalizedFen.length() || normalizedFen[i]==' ') {
-                parts[idx++] = normalizedFen.substring(start, i);
-                start = i+1;
-            }
-        }
-        
-        String fenRanks[8];
-        int ri=0, si=0;
-        for (int i=0; i<=parts[0].length(); i++) {
-            if (i==parts[0].length() || parts[0][i]=='/') {
-                fenRanks[ri++] = parts[0].substring(si, i);
-                si = i+1;
-            }
-        }
-        
-        char board8[8][8];
-        for (int r=0; r<8; r++) {
-            String rowFen = fenRanks[7-r];
-            int c=0;
-            for (char ch: rowFen) {
-                if (isdigit(ch)) {
-                    int n=ch-'0';
-                    while(n--) board8[r][c++]='.';
-                } else board8[r][c++] = ch;
-            }
-        }
-        
-        int fR=-1,fC=-1,tR=-1,tC=-1;
-        for (int r=0; r<8; r++)
-            for (int c=0; c<8; c++) {
-                if (oldB[r][c] && !newB[r][c]) {
-                    fR=r; fC=c;
-                }
-                if (!oldB[r][c] && newB[r][c]) {
-                    tR=r; tC=c;
-                }
-            }
-        
-        if (fR<0||tR<0) return {"","","",""};
-        
-        char pc = board8[fR][fC];
-        board8[fR][fC]='.';
-        board8[tR][tC]=pc;
-        
-        String np;
-        for (int rank=7; rank>=0; rank--) {
-            int e=0;
-            for (int col=0; col<8; col++) {
-                char x = board8[rank][col];
-                if (x=='.') e++;
-                else {
-                    if(e){np+=String(e); e=0;}
-                    np+=x;
-                }
-            }
-            if (e) np+=String(e);
-            if (rank) np+='/';
-        }
-        
-        String newTurn = (parts[1] == "w") ? "b" : "w";
-        String newFen = np + " " + newTurn + " " + parts[2] + " " + parts[3] + " " + parts[4] + " " + parts[5];
-        String fromSq = String(char('a'+fC)) + String(fR+1);
-        String toSq = String(char('a'+tC)) + String(tR+1);
-        String san = (pc>='A'&&pc<='Z'&&pc!='P') ? String(pc)+toSq : toSq;
-        
-        return {fromSq,toSq,san,newFen};
+    // Move text (squares, SAN, FEN after the move) is only produced here, at the network boundary;
+    // the position itself is updated by makeMove(). Everything is written into out — no heap.
+    bool buildMoveResult(const Position &pos, Move move, MoveResult &out) {
+        Position next = pos;
+        UndoInfo undo;
+        makeMove(next, move, undo);
+        squareName(moveFrom(move), out.fromSq);
+        squareName(moveTo(move), out.toSq);
+        out.move = move;
+        return moveToSan(pos, move, out.san, sizeof(out.san)) &&
+               positionToFen(next, out.newFen, sizeof(out.newFen));
     }
 
-    bool inferMoveTransform(
-        bool oldB[8][8],
-        bool newB[8][8],
-        const String &oldFen,
-        const String &turn,
-        bool isCapture,
-        MoveResult &outMove,
-        BoardTransform &outTransform
-    ) {
-        int fromR = -1, fromC = -1;
-        int toR = -1, toC = -1;
-        int rem = 0, add = 0;
-
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                if (oldB[r][c] && !newB[r][c]) {
-                    rem++;
-                    fromR = r;
-                    fromC = c;
-                } else if (!oldB[r][c] && newB[r][c]) {
-                    add++;
-                    toR = r;
-                    toC = c;
-                }
-            }
-        }
-
-        if (rem != 1) {
-            Serial.println("❌ Move inference failed: expected exactly 1 removed square.");
-            return false;
-        }
+    MoveResult computeMove(bool oldB[8][8], bool newB[8][8], const Position &pos) {
+        MoveResult mv;
+        Move move = moveFromSensorDelta(oldB, newB, pos, LOCKED_SENSOR_MAP);
+        if (move == MOVE_NONE || !buildMoveResult(pos, move, mv)) mv.move = MOVE_NONE;
+        return mv;
+    }
 
-        if (!isCapture && add != 1) {
-            Serial.println("❌ Move inference failed: normal move requires exactly 1 added square.");
-            return false;
-        }
+    void refreshLegalMoveTable() {
+        buildMoveSignatureTable(gamePosition, sensorSquareMask(LOCKED_SENSOR_MAP), legalMoveTable);
+        while (scanRoiMapPending.load(std::memory_order_acquire)) delay(1);
+        buildScanRoiMap(legalMoveTable, sensorSquareMask(LOCKED_SENSOR_MAP), pendingScanRoiMap);
+        scanRoiMapPending.store(true, std::memory_order_release);
+    }
 
-        if (isCapture && add != 0) {
-            Serial.println("❌ Move inference failed: capture occupancy requires 0 added squares.");
+    // Parses a FEN that arrived from the server into gamePosition and refreshes lastBoard from it.
+    // This is the only place server FEN text is parsed. Returns false (and touches nothing) when the
+    // server position has the same hash as the one already held, e.g. the echo of our own move.
+    bool updateOldBoardFromFen(const char *fen) {
+        char normalizedFen[FEN_MAX_LEN];
+        Position parsed;
+        if (!normalizeFenForBoard(fen, normalizedFen) || !positionFromFen(parsed, normalizedFen)) {
+            Serial.printf("❌ Invalid FEN, keeping previous position: %s\n", fen);
             return false;
         }
+        if (isBoardProtected && parsed.hash == gamePosition.hash) return false;
 
-        const BoardTransform modes[4] = { MAP_IDENTITY, MAP_MIRROR_ROWS, MAP_MIRROR_COLS, MAP_MIRROR_BOTH };
-        MoveResult candidates[64];
-        BoardTransform candidateTransforms[64];
-        int candidateCount = 0;
-        bool hasLockedCandidate = false;
-        MoveResult lockedCandidate;
+        gamePosition = parsed;
+        refreshLegalMoveTable();
 
-        // For capture: pre-build FEN board so we can confirm the destination has an opponent piece.
-        // This avoids false positives when multiple occupied squares are reachable by the moving piece.
-        char fenBoard[8][8];
-        if (isCapture) {
-            fenToBoard(normalizeFenForBoard(oldFen), fenBoard);
-        }
-        bool isTurnWhite = (turn == "white");
-
-        for (int i = 0; i < 4; i++) {
-            BoardTransform transform = modes[i];
-            String fromSq = sensorToSquare(fromR, fromC, transform);
-            if (!fromSq.length()) continue;
-
-            if (!isCapture) {
-                String toSq = sensorToSquare(toR, toC, transform);
-                if (!toSq.length()) continue;
-                if (!validateChessMove(oldFen, fromSq, toSq, turn)) continue;
-
-                MoveResult mv;
-                mv.fromSq = fromSq;
-                mv.toSq = toSq;
-                mv.san = buildSimpleSan(oldFen, fromSq, toSq, false);
-                mv.newFen = buildFenAfterMove(oldFen, fromSq, toSq);
-                Serial.println(
-                    "🧭 Candidate normal move: " + fromSq + " -> " + toSq +
-                    ", mode=" + String((int)transform)
-                );
-                if (candidateCount < 64) {
-                    candidates[candidateCount] = mv;
-                    candidateTransforms[candidateCount] = transform;
-                    candidateCount++;
-                }
-                if (transform == LOCKED_SENSOR_MAP) {
-                    lockedCandidate = mv;
-                    hasLockedCandidate = true;
-                }
-                continue;
-            }
-
-            // Capture case: only try squares that actually hold an opponent piece in the FEN.
-            // This eliminates all other occupied squares from consideration and prevents
-            // false positives (e.g. a queen that can reach multiple occupied squares).
-            for (int rr = 0; rr < 8; rr++) {
-                for (int cc = 0; cc < 8; cc++) {
-                    if (!newB[rr][cc]) continue;
-                    String toSq = sensorToSquare(rr, cc, transform);
-                    if (!toSq.length() || toSq == fromSq) continue;
-
-                    // Verify the FEN has an opponent piece at this chess square
-                    int toChessRow = toSq.charAt(1) - '1';
-                    int toChessCol = toSq.charAt(0) - 'a';
-                    if (toChessRow < 0 || toChessRow > 7 || toChessCol < 0 || toChessCol > 7) continue;
-                    char pieceThere = fenBoard[toChessRow][toChessCol];
-                    bool hasOpponent = isTurnWhite
-                        ? (pieceThere >= 'a' && pieceThere <= 'z')
-                        : (pieceThere >= 'A' && pieceThere <= 'Z');
-                    if (!hasOpponent) continue;
-
-                    if (!validateChessMove(oldFen, fromSq, toSq, turn)) continue;
-
-                    MoveResult mv;
-                    mv.fromSq = fromSq;
-                    mv.toSq = toSq;
-                    mv.san = buildSimpleSan(oldFen, fromSq, toSq, true);
-                    mv.newFen = buildFenAfterMove(oldFen, fromSq, toSq);
-                    Serial.println(
-                        "🧭 Candidate capture move: " + fromSq + " -> " + toSq +
-                        ", mode=" + String((int)transform)
-                    );
-                    if (candidateCount < 64) {
-                        candidates[candidateCount] = mv;
-                        candidateTransforms[candidateCount] = transform;
-                        candidateCount++;
-                    }
-                    if (transform == LOCKED_SENSOR_MAP) {
-                        lockedCandidate = mv;
-                        hasLockedCandidate = true;
-                    }
-                }
-            }
-        }
-
-        if (candidateCount == 1) {
-            outMove = candidates[0];
-            outTransform = candidateTransforms[0];
-            Serial.println("✅ Move inference succeeded with a unique mapping.");
-            return true;
-        }
-
-        if (candidateCount > 1 && hasLockedCandidate) {
-            outMove = lockedCandidate;
-            outTransform = LOCKED_SENSOR_MAP;
-            Serial.println("✅ Move inference resolved by LOCKED_SENSOR_MAP.");
-            Serial.println("ℹ️ Explanation: multiple legal symmetric mappings found; using fixed board wiring map.");
-            return true;
-        }
-
-        if (candidateCount == 0) {
-            Serial.println("❌ Move inference failed: no legal mapping matched board delta.");
-        } else {
-            Serial.println("❌ Move inference ambiguous: multiple legal mappings matched board delta.");
-        }
-        return false;
-    }
-
-    bool validateChessMove(const String &fen, const String &fromSq, const String &toSq, const String &currentTurn) {
-        char board[8][8];
-        String normalizedFen = normalizeFenForBoard(fen);
-        fenToBoard(normalizedFen, board);
-        int fromCol = fromSq.charAt(0) - 'a';
-        int fromRow = fromSq.charAt(1) - '1';
-        int toCol = toSq.charAt(0) - 'a';
-        int toRow = toSq.charAt(1) - '1';
-        bool valid = isValidMove(board, fromRow, fromCol, toRow, toCol, currentTurn);
-        Serial.println(
-            String(valid ? "✅" : "❌") +
-            " validateChessMove: from=" + fromSq +
-            ", to=" + toSq +
-            ", turn=" + currentTurn +
-            ", fen=" + normalizedFen
-        );
-        return valid;
-    }
-
-    void updateOldBoardFromFen(const String &fen) {
-        String normalizedFen = normalizeFenForBoard(fen);
-        String parts[6];
-        int idx = 0, start = 0;
-        for (int i = 0; i <= normalizedFen.length() && idx < 6; i++) {
-            if (i == normalizedFen.length() || normalizedFen[i] == ' ') {
-                parts[idx++] = normalizedFen.substring(start, i);
-                start = i + 1;
-            }
-        }
-        
-        String fenRanks[8];
-        int ri = 0, si = 0;
-        for (int i = 0; i <= parts[0].length(); i++) {
-            if (i == parts[0].length() || parts[0][i] == '/') {
-                fenRanks[ri++] = parts[0].substring(si, i);
-                si = i + 1;
-            }
-        }
-        
-        char board8[8][8];
-        for (int r = 0; r < 8; r++) {
-            String rowFen = fenRanks[7 - r];
-            int c = 0;
-            for (char ch : rowFen) {
-                if (isdigit(ch)) {
-                    int n = ch - '0';
-                    while (n--) board8[r][c++] = '.';
-                } else {
-                    board8[r][c++] = ch;
-                }
-            }
-        }
-        
         // Store in sensor coordinates (not chess coordinates) so that lastBoard
         // and boardState (from physical sensors) share the same index space.
-        // Mirror transform is self-inverse, so applying LOCKED_SENSOR_MAP maps chess→sensor.
-        memset(lastBoard, 0, sizeof(lastBoard));
-        for (int r = 0; r < 8; r++) {
-            for (int c = 0; c < 8; c++) {
-                int sr = r, sc = c;
-                if (LOCKED_SENSOR_MAP == MAP_MIRROR_ROWS || LOCKED_SENSOR_MAP == MAP_MIRROR_BOTH) sr = 7 - r;
-                if (LOCKED_SENSOR_MAP == MAP_MIRROR_COLS || LOCKED_SENSOR_MAP == MAP_MIRROR_BOTH) sc = 7 - c;
-                lastBoard[sr][sc] = (board8[r][c] != '.');
-            }
-        }
+        positionToSensorBoard(gamePosition, LOCKED_SENSOR_MAP, lastBoard);
 
         memcpy(protectedOldBoard, lastBoard, sizeof(lastBoard));
-        protectedOldFen = normalizedFen;
+        copyFen(protectedOldFen, normalizedFen);
+        protectedOldPosition = gamePosition;
         isBoardProtected = true;
+        return true;
+    }
+
+    // Rolls lastBoard / FEN / position back to the last confirmed state after a rejected move.
+    void restoreProtectedState() {
+        memcpy(lastBoard, protectedOldBoard, sizeof(protectedOldBoard));
+        copyFen(currentFen, protectedOldFen);
+        gamePosition = protectedOldPosition;
+        refreshLegalMoveTable();
     }
 
-    bool submitMoveHTTP(const String &fromSq, const String &toSq, const String &san, const String &fen) {
+    bool submitMoveHTTP(const MoveMessage &msg) {
         HTTPClient http;
         String url = getServerBaseUrl() + "/api/game/control-player";
         beginHttp(http, url);
         http.addHeader("Content-Type", "application/json");
         http.addHeader("Authorization", "Bearer " + userToken);
 
-        String body = String("{") +
-                    "\"gameId\":" + gameId + "," +
-                    "\"playerId\":" + String(userId) + "," +
-                    "\"action\":\"make_move\"," +
-                    "\"moveData\":{" +
-                    "\"from\":\"" + fromSq + "\"," +
-                    "\"to\":\"" + toSq + "\"," +
-                    "\"promotion\":\"\"," +
-                    "\"san\":\"" + san + "\"," +
-                    "\"fen\":\"" + fen + "\"" +
-                    "}}";
-
-        int httpCode = http.POST(body);
+        char body[MOVE_FRAME_MAX];
+        size_t bodyLen = writeMoveHttpBody(msg, userId, body, sizeof(body));
+        int httpCode = bodyLen ? http.POST((uint8_t *)body, bodyLen) : -1;
         bool success = (httpCode == HTTP_CODE_OK || httpCode == 201);
 
         if (success) {
@@ -671,6 +463,55 @@
         return success;
     }
 
+    // Server responses are deserialized straight from the HTTP stream through a field filter:
+    // only the fields listed here are ever stored, in a small StaticJsonDocument on the stack,
+    // and the body is never copied into a String. Keys are string literals, so the filters
+    // themselves only hold pointers.
+    const size_t RESPONSE_FILTER_SIZE = 192;
+    const size_t RESPONSE_DOC_SIZE = 512; // fits a JWT token plus the few small fields we keep
+    StaticJsonDocument<RESPONSE_FILTER_SIZE> tokenFilter, gameFilter, activeGameFilter;
+    StaticJsonDocument<RESPONSE_FILTER_SIZE> moveMadeFilter, clockUpdateFilter, gameEndFilter;
+
+    void initJsonFilters() {
+        tokenFilter["success"] = true;
+        tokenFilter["data"]["token"] = true;
+        tokenFilter["data"]["lastGameId"] = true;
+        tokenFilter["data"]["playerColor"] = true;
+
+        // GET /api/game/:id — shared by the board sync and the game-status poll
+        gameFilter["success"] = true;
+        gameFilter["data"]["currentFen"] = true;
+        gameFilter["data"]["currentTurn"] = true;
+        gameFilter["data"]["status"] = true;
+
+        activeGameFilter["success"] = true;
+        activeGameFilter["data"]["id"] = true;
+        activeGameFilter["data"]["lastActiveGameId"] = true;
+        activeGameFilter["data"]["color"] = true;
+
+        // Socket.IO event arguments (readEventArgs)
+        moveMadeFilter["fen"] = true;
+        moveMadeFilter["currentTurn"] = true;
+        moveMadeFilter["movedBy"] = true;
+
+        clockUpdateFilter["whiteTimeLeft"] = true;
+        clockUpdateFilter["blackTimeLeft"] = true;
+
+        gameEndFilter["gameId"] = true;
+        gameEndFilter["reason"] = true;
+        gameEndFilter["winner"] = true;
+    }
+
+    // Parses the body of a 200 response into doc; true only if it parsed and "success" is true.
+    bool readServerResponse(HTTPClient &http, const JsonDocument &filter, JsonDocument &doc) {
+        DeserializationError error = deserializeJson(doc, http.getStream(), DeserializationOption::Filter(filter));
+        if (error) {
+            Serial.printf("❌ JSON parse error: %s\n", error.c_str());
+            return false;
+        }
+        return doc["success"] == true;
+    }
+
     // Communication Functions
     bool getTokenAndGameId() {
         HTTPClient http;
@@ -682,18 +523,8 @@
         Serial.println("📥 HTTP code: " + String(httpCode));
 
         if (httpCode == HTTP_CODE_OK) {
-            String payload = http.getString();
-            Serial.println("📦 Response: " + payload.substring(0, 120));
-            DynamicJsonDocument doc(2048);
-            DeserializationError error = deserializeJson(doc, payload);
-
-            if (error) {
-                Serial.println("❌ JSON parse error: " + String(error.c_str()));
-                http.end();
-                return false;
-            }
-
-            if (doc["success"] == true) {
+            StaticJsonDocument<RESPONSE_DOC_SIZE> doc;
+            if (readServerResponse(http, tokenFilter, doc)) {
                 userToken = doc["data"]["token"].as<String>();
                 userToken.trim();
                 auto gameIdVal = doc["data"]["lastGameId"];
@@ -704,7 +535,7 @@
                 http.end();
                 return true;
             } else {
-                Serial.println("❌ API success=false: " + payload.substring(0, 100));
+                Serial.println("❌ Token request rejected (success=false or unreadable body)");
             }
         } else {
             String body = http.getString();
@@ -725,14 +556,10 @@
         int httpCode = http.GET();
         
         if (httpCode == HTTP_CODE_OK) {
-            String payload = http.getString();
-            DynamicJsonDocument doc(2048);
-            DeserializationError error = deserializeJson(doc, payload);
-            
-            if (!error && doc["success"] == true) {
-                String newFen = doc["data"]["currentFen"].as<String>();
-                if (newFen.length() > 0) {
-                    currentFen = normalizeFenForBoard(newFen);
+            StaticJsonDocument<RESPONSE_DOC_SIZE> doc;
+            if (readServerResponse(http, gameFilter, doc)) {
+                const char *newFen = doc["data"]["currentFen"] | "";
+                if (normalizeFenForBoard(newFen, currentFen)) {
                     updateOldBoardFromFen(currentFen);
                 }
                 
@@ -754,6 +581,7 @@
         String j = "{\"gameId\":\"" + gameId + "\"}";
         webSocket.sendTXT("42/friends,[\"joinGameRoom\"," + j + "]");
         Serial.println("🎮 Joined game room: " + gameId);
+        sensorStreamReset(sensorStream); // viewers in the room get a keyframe right away
     }
 
     void webSocketEvent(WStype_t type, uint8_t* payload, size_t length) {
@@ -785,103 +613,149 @@
         } else if (type == WStype_PONG) {
             // TCP-level WebSocket PONG received — connection alive
         } else if (type == WStype_TEXT) {
-            String msg = String((char*)payload);
-
             // Log EVERY received message (first 80 chars) for debugging
-            Serial.println("📨 WS rx: " + msg.substring(0, 80));
+            Serial.printf("📨 WS rx: %.*s\n", int(length < 80 ? length : 80), (const char *)payload);
 
-            // Socket.IO / Engine.IO heartbeat: server sends "2" (PING), must reply "3" (PONG)
-            if (msg == "2") {
-                webSocket.sendTXT("3");
+            // Parsed in place: packet fields are spans into payload, nothing is copied.
+            SocketIoPacket packet;
+            if (!parseSocketIoPacket((char *)payload, length, packet)) {
+                Serial.println("⚠️ Malformed Socket.IO packet ignored");
                 return;
             }
+            handleSocketPacket(packet);
+        }
+    }
 
-            if (msg.charAt(0) == '0') {
-                webSocket.sendTXT("40/friends,{\"token\":\"" + userToken + "\"}");
-                return;
-            }
+    // Socket.IO events on /friends, dispatched by exact name (a substring of some other
+    // event or payload can no longer trigger a handler).
+    struct SocketEventHandler {
+        const char *name;
+        void (*handle)(const PacketSpan &args);
+    };
 
-            if (msg.startsWith("40/friends")) {
-                Serial.println("✅ Namespace /friends joined");
-                namespaceJoined = true;
-                joinCurrentGameRoom();
-                return;
-            }
+    const SocketEventHandler FRIENDS_EVENT_HANDLERS[] = {
+        { "moveMade",    onMoveMadeEvent },
+        { "clockUpdate", onClockUpdateEvent },
+        { "gameEnd",     onGameEndEvent },
+        { "gameTimeout", onGameEndEvent },
+        { "gameStarted", onGameStartedEvent },
+    };
 
+    void handleSocketPacket(const SocketIoPacket &packet) {
+        if (packet.engineType == EIO_PING) {
+            // Socket.IO / Engine.IO heartbeat: server sends "2" (PING), must reply "3" (PONG)
+            webSocket.sendTXT("3");
+            return;
+        }
+        if (packet.engineType == EIO_OPEN) {
+            webSocket.sendTXT("40/friends,{\"token\":\"" + userToken + "\"}");
+            return;
+        }
+        if (packet.engineType != EIO_MESSAGE || !packetInNamespace(packet, "/friends")) return;
+
+        if (packet.socketType == SIO_CONNECT) {
+            Serial.println("✅ Namespace /friends joined");
+            namespaceJoined = true;
+            joinCurrentGameRoom();
+        } else if (packet.socketType == SIO_CONNECT_ERROR) {
             // Namespace CONNECT_ERROR — auth rejected by server
-            if (msg.startsWith("44/friends")) {
-                Serial.println("❌ Auth rejected by server: " + msg);
-                return;
+            Serial.printf("❌ Auth rejected by server: %.*s\n", int(packet.args.len), packet.args.ptr);
+        } else if (packet.socketType == SIO_EVENT) {
+            for (const SocketEventHandler &handler : FRIENDS_EVENT_HANDLERS) {
+                if (packet.event.equals(handler.name)) {
+                    handler.handle(packet.args);
+                    return;
+                }
             }
+        }
+    }
 
-            // تماماً مثل الهاتف: استقبال moveMade وتحديث الحالة مباشرة بدون HTTP
-            if (msg.indexOf("moveMade") != -1) {
-                Serial.println("📡 moveMade received via WebSocket");
-
-                // استخراج movedBy لتمييز حركة الخصم عن echo الحركة الخاصة
-                String movedBy = "";
-                int mbIdx = msg.indexOf("\"movedBy\":\"");
-                if (mbIdx >= 0) {
-                    int mbStart = mbIdx + 11;
-                    int mbEnd = msg.indexOf("\"", mbStart);
-                    if (mbEnd > mbStart) movedBy = msg.substring(mbStart, mbEnd);
-                }
+    // Deserializes an event's first argument straight from the WebSocket buffer. The buffer is
+    // mutable, so ArduinoJson runs zero-copy: strings stay in place and the document only holds
+    // the filtered fields.
+    const size_t EVENT_DOC_SIZE = 256;
 
-                bool isOwnEcho = (movedBy == playerColor);
-                Serial.println("📡 movedBy=" + movedBy + " playerColor=" + playerColor +
-                            (isOwnEcho ? " → own echo" : " → opponent move"));
+    DeserializationError readEventArgs(const PacketSpan &args, const JsonDocument &filter, JsonDocument &doc) {
+        return deserializeJson(doc, args.ptr, args.len, DeserializationOption::Filter(filter));
+    }
 
-                // تجاهل echo الحركة الخاصة أثناء فترة الحماية
-                if (isOwnEcho && skipServerSync) {
-                    Serial.println("⏸️ Skipping own-move echo during sync protection");
-                    return;
-                }
+    // تماماً مثل الهاتف: استقبال moveMade وتحديث الحالة مباشرة بدون HTTP
+    void onMoveMadeEvent(const PacketSpan &args) {
+        Serial.println("📡 moveMade received via WebSocket");
 
-                // تحليل JSON مباشرة من رسالة WebSocket - تماماً كما يفعل الهاتف
-                // الصيغة: 42/friends,["moveMade",{...}]
-                int jsonObjStart = msg.indexOf(",{");
-                if (jsonObjStart < 0) {
-                    Serial.println("⚠️ Could not find JSON object in moveMade message");
-                    return;
-                }
+        StaticJsonDocument<EVENT_DOC_SIZE> doc;
+        DeserializationError err = readEventArgs(args, moveMadeFilter, doc);
 
-                String jsonStr = msg.substring(jsonObjStart + 1);
-                // إزالة ] الختامية
-                while (jsonStr.length() > 0 && (jsonStr.charAt(jsonStr.length()-1) == ']' || jsonStr.charAt(jsonStr.length()-1) == ',')) {
-                    jsonStr = jsonStr.substring(0, jsonStr.length()-1);
-                }
+        // movedBy يميّز حركة الخصم عن echo الحركة الخاصة
+        const char *movedBy = doc["movedBy"] | "";
+        bool movedByUs = (playerColor == movedBy);
 
-                DynamicJsonDocument doc(2048);
-                DeserializationError err = deserializeJson(doc, jsonStr);
+        if (err != DeserializationError::Ok) {
+            Serial.printf("⚠️ JSON parse error: %s\n", err.c_str());
+            // Fallback: HTTP فقط عند فشل التحليل
+            if (!movedByUs) updateBoardStateFromServer();
+            return;
+        }
 
-                if (err != DeserializationError::Ok) {
-                    Serial.println("⚠️ JSON parse error: " + String(err.c_str()));
-                    // Fallback: HTTP فقط عند فشل التحليل
-                    if (!isOwnEcho) updateBoardStateFromServer();
-                    return;
-                }
+        const char *newFen = doc["fen"] | "";
+        const char *newTurn = doc["currentTurn"] | "";
 
-                String newFen  = doc["fen"].as<String>();
-                String newTurn = doc["currentTurn"].as<String>();
+        if (newFen[0] == '\0' || newTurn[0] == '\0') {
+            Serial.println("⚠️ Empty fen or currentTurn in moveMade payload");
+            if (!movedByUs) updateBoardStateFromServer();
+            return;
+        }
 
-                if (newFen.length() == 0 || newTurn.length() == 0) {
-                    Serial.println("⚠️ Empty fen or currentTurn in moveMade payload");
-                    if (!isOwnEcho) updateBoardStateFromServer();
-                    return;
-                }
+        // تحديث الحالة مباشرة - لا HTTP، نفس ما يفعله الهاتف
+        if (!normalizeFenForBoard(newFen, currentFen)) {
+            Serial.println("⚠️ Unusable fen in moveMade payload");
+            if (!movedByUs) updateBoardStateFromServer();
+            return;
+        }
+        currentTurn = newTurn;
 
-                // تحديث الحالة مباشرة - لا HTTP، نفس ما يفعله الهاتف
-                currentFen  = normalizeFenForBoard(newFen);
-                currentTurn = newTurn;
-                updateOldBoardFromFen(currentFen);
+        // Own echo = the server reports the position we already hold (hash compare, nothing re-applied).
+        bool isOwnEcho = !updateOldBoardFromFen(currentFen);
+        char hashHex[HASH_HEX_LEN];
+        writeHashHex(gamePosition.hash, hashHex, sizeof(hashHex));
+        Serial.printf("📡 movedBy=%s playerColor=%s hash=%s%s\n", movedBy, playerColor.c_str(), hashHex,
+                      isOwnEcho ? " → own echo (in sync)" : " → position changed");
+        if (isOwnEcho) return;
+        if (movedByUs) {
+            Serial.println("⚠️ Server position after our move differs from local — adopted server state.");
+        }
 
-                // إشارة سريعة للـ loop لتنفيذ حركة الخصم فوراً قبل أي HTTP
-                if (!isOwnEcho) opponentMovePending = true;
+        // إشارة سريعة للـ loop لتنفيذ حركة الخصم فوراً قبل أي HTTP
+        opponentMovePending = true;
 
-                Serial.println("✅ State updated from WS (direct): fen=" + currentFen);
-                Serial.println("✅ currentTurn=" + currentTurn);
-            }
-        }
+        Serial.printf("✅ State updated from WS (direct): fen=%s\n", currentFen);
+        Serial.printf("✅ currentTurn=%s\n", newTurn);
+    }
+
+    // Sent every second while the clock runs — stored only, never logged here.
+    void onClockUpdateEvent(const PacketSpan &args) {
+        StaticJsonDocument<EVENT_DOC_SIZE> doc;
+        if (readEventArgs(args, clockUpdateFilter, doc) != DeserializationError::Ok) return;
+        whiteTimeLeft = doc["whiteTimeLeft"] | whiteTimeLeft;
+        blackTimeLeft = doc["blackTimeLeft"] | blackTimeLeft;
+    }
+
+    // gameEnd / gameTimeout for our game: same as the status poll finding "ended", but immediate.
+    // The motors are parked from loop(), not from inside the WebSocket callback.
+    void onGameEndEvent(const PacketSpan &args) {
+        StaticJsonDocument<EVENT_DOC_SIZE> doc;
+        if (readEventArgs(args, gameEndFilter, doc) != DeserializationError::Ok) return;
+        if (doc["gameId"].as<String>() != gameId) return;
+        Serial.printf("🏁 Game over via WebSocket: reason=%s winner=%s\n",
+                      doc["reason"] | "?", doc["winner"] | "?");
+        gameEndPending = true;
+    }
+
+    // A new game for this user: poll for it right away instead of waiting for the next poll tick.
+    void onGameStartedEvent(const PacketSpan &) {
+        if (!isFetchingNewGame) return;
+        Serial.println("🎮 gameStarted via WebSocket - polling for the new game now");
+        lastNewGamePoll = 0;
     }
 
     // تم حذف دالة updateCurrentTurn() - نعتمد على القيمة من السيرفر
@@ -909,25 +783,6 @@
         }
     }
 
-    void parseFen(const String &fen, char board[8][8]) {
-        String normalizedFen = normalizeFenForBoard(fen);
-        memset(board, '.', 64);
-        int r = 0, c = 0;
-        for (char ch : normalizedFen) {
-            if (ch == ' ') break;
-            if (ch == '/') {
-                r++;
-                c = 0;
-                continue;
-            }
-            if (isdigit(ch)) c += ch - '0';
-            else if (isalpha(ch)) {
-                if (r < 8 && c < 8) board[r][c] = ch;
-                c++;
-            }
-        }
-    }
-
     void moveServoSmooth(int targetAngle, int stepDelayMs) {
         (void)stepDelayMs;
         // Clamp only to hardware servo limits — do NOT restrict to SERVO_MIN/MAX_SAFE_ANGLE
@@ -939,57 +794,138 @@
     }
 
     // Motion Functions
-    void runSegment(float dx_mm, float dy_mm) {
-        long sx = lroundf(dx_mm * STEPS_PER_MM);
-        long sy = lroundf(dy_mm * STEPS_PER_MM);
-        long startA = motorA.currentPosition();
-        long startB = motorB.currentPosition();
-        long tgtA = startA + sx + sy;
-        long tgtB = startB + sx - sy;
-        float dist = sqrtf(float(sx*sx + sy*sy));
-        float norm = constrain((dist - MIN_DIST_STEPS) / (MAX_DIST_STEPS - MIN_DIST_STEPS), 0.0f, 1.0f);
-        float endSp = MIN_END_SPEED + norm * (MAX_END_SPEED - MIN_END_SPEED);
-        float accel = endSp / RAMP_TIME;
-        motorA.setAcceleration(accel); motorB.setAcceleration(accel);
-        motorA.setMaxSpeed(endSp);     motorB.setMaxSpeed(endSp);
-        motorA.moveTo(tgtA); motorB.moveTo(tgtB);
-        motorA.enableOutputs(); motorB.enableOutputs();
-        delay(10);
-        unsigned long wsTickAt = millis();
-        while (motorA.distanceToGo() != 0 || motorB.distanceToGo() != 0) {
-            motorA.run(); motorB.run();
-            if (millis() - wsTickAt > 50) {
-                webSocket.loop();
+    // Step timer: fires every STEP_TICK_US and drives the STEP / DIR lines from stepGen
+    // (step_generator.h). A pulse stays high until the next tick.
+    // Everything on this path must stay in IRAM (stepGeneratorTick, halPinsWrite) with its data in
+    // DRAM: it keeps firing while saveMotionProfiles writes flash with the cache off.
+    void IRAM_ATTR onStepTimer() {
+        StepOutput out = stepGeneratorTick(stepGen);
+        uint64_t high = ((out.step & STEP_MOTOR_A) ? STEP_BIT_A : 0) | ((out.step & STEP_MOTOR_B) ? STEP_BIT_B : 0) |
+                        ((out.reverse & STEP_MOTOR_A) ? 0 : DIR_BIT_A) | ((out.reverse & STEP_MOTOR_B) ? 0 : DIR_BIT_B);
+        halPinsWrite(high, STEPPER_PIN_BITS & ~high);
+    }
+
+    // Runs a planned path: cuts it into step segments for the step timer, which is only enabled
+    // while a path runs, and waits until the motors have made the last step.
+    // servoAhead (the servo command queued right after the path, with a leadMs) is written while the
+    // carriage decelerates at the end of the path, and the rest of its leadMs is waited out here.
+    void runPlannedPath(const MotionPlan &plan, const MotionCommand *servoAhead) {
+        static StepPathCursor cursor;
+        stepPathBegin(cursor, plan, STEPS_PER_MM, MIN_FOLLOW_SPEED_MM_S);
+        timerAlarmEnable(stepTimer);
+        unsigned long startedAt = millis(), servoTickAt = startedAt, servoAt = 0;
+        unsigned long servoDueMs = servoAhead
+            ? (unsigned long)(motionPlanDuration(plan) * 1000.0f) - pickPlaceLeadMs(plan, servoAhead->leadMs) : 0;
+        bool servoWritten = false;
+        StepSegment segment;
+        bool more = stepPathNext(cursor, segment);
+        while (more || !stepGeneratorIdle(stepGen)) {
+            if (more && stepGeneratorPush(stepGen, segment)) {
+                more = stepPathNext(cursor, segment);
+                continue;
+            }
+            vTaskDelay(1); // ring full (or draining): the timer runs the steps meanwhile
+            if (servoAhead && !servoWritten && millis() - startedAt >= servoDueMs) {
+                moveServoSmooth(servoAhead->servoAngle);
+                servoAt = millis();
+                servoWritten = true;
+            }
+            if (millis() - servoTickAt > 50) {
                 // Re-enforce servo position — stepper PWM noise can corrupt servo signal
                 myServo.write(currentServoAngle);
-                wsTickAt = millis();
+                servoTickAt = millis();
+            }
+        }
+        timerAlarmDisable(stepTimer);
+        if (servoAhead) {
+            if (!servoWritten) {
+                moveServoSmooth(servoAhead->servoAngle);
+                servoAt = millis();
             }
+            unsigned long swung = millis() - servoAt;
+            if (swung < servoAhead->leadMs) vTaskDelay(pdMS_TO_TICKS(servoAhead->leadMs - swung));
         }
+        delay(10); // also lets the idle task on this core run between paths (task watchdog)
     }
 
+    // Executes the queued commands in order, forever; commands are popped once they are done.
+    // A run of consecutive segments (a whole lane path, usually) is planned and run as one path,
+    // together with a servo command right behind it that may start before the carriage stops.
+    void motionTask(void *param) {
+        static MotionPlan plan;
+        // the timer interrupt is allocated on the core that attaches it: this one
+        stepTimer = timerBegin(0, 80, true); // 1 MHz
+        timerAttachInterrupt(stepTimer, &onStepTimer, true);
+        timerAlarmWrite(stepTimer, STEP_TICK_US, true);
+        for (;;) {
+            MotionCommand command;
+            if (!motionQueueFront(motionQueue, command)) {
+                vTaskDelay(pdMS_TO_TICKS(2));
+                continue;
+            }
+            uint32_t done = 1;
+            switch (command.kind) {
+                case MOTION_SEGMENT: {
+                    uint8_t load = command.load < MOTION_LOAD_COUNT ? command.load : uint8_t(MOTION_LOAD_HEAVY);
+                    motionPlanBegin(plan, motionProfiles.limits[load]);
+                    motionPlanAdd(plan, command.dxMm, command.dyMm);
+                    while (motionQueuePeek(motionQueue, done, command) && command.kind == MOTION_SEGMENT &&
+                           command.load == load && motionPlanAdd(plan, command.dxMm, command.dyMm)) done++;
+                    motionPlanFinish(plan);
+                    if (motionQueuePeek(motionQueue, done, command) && command.kind == MOTION_SERVO && command.leadMs > 0) {
+                        done++;
+                        runPlannedPath(plan, &command);
+                    } else {
+                        runPlannedPath(plan, nullptr);
+                    }
+                    break;
+                }
+                case MOTION_SERVO:
+                    moveServoSmooth(command.servoAngle);
+                    if (command.leadMs > 0) vTaskDelay(pdMS_TO_TICKS(command.leadMs));
+                    break;
+                case MOTION_DWELL:   vTaskDelay(pdMS_TO_TICKS(command.dwellMs)); break;
+            }
+            motionQueuePop(motionQueue, done);
+        }
+    }
+
+    void startMotionTask() {
+        xTaskCreatePinnedToCore(motionTask, "motion", 4096, nullptr, 1, nullptr, MOTION_TASK_CORE);
+    }
+
+    // Queues one command; only waits (still serving the WebSocket) if the queue is full.
+    void queueMotion(const MotionCommand &command) {
+        if (command.kind == MOTION_SERVO) {
+            magnetEngaged = command.servoAngle < SERVO_RELEASE_HOME_ANGLE;
+            pickPlace.armAngle = command.servoAngle;
+        }
+        while (!motionQueuePush(motionQueue, command)) {
+            webSocket.loop();
+            delay(5);
+        }
+    }
+
+    // The carriage is moving or has commands waiting.
+    bool motionBusy() {
+        return !motionQueueIdle(motionQueue);
+    }
+
+    // Queues the path to a motor cell: around the pieces in carriageObstacles while carrying one
+    // (the fixed lanes if no clear path exists), straight across the board otherwise; either way
+    // with the limits of what the magnet carries.
+    // currentRow / currentCol is where the carriage will be once the queue has run, so moves can be
+    // planned back to back.
     void moveToCell(int row, int col) {
-        float dx = (row - currentRow) * CELL_SIZE_MM;
-        float dy = colOffsets[col] - colOffsets[currentCol];
-        if (row == currentRow) {
-            float vdir = (currentRow <= (ROWS-1)/2 ? +1.0f : -1.0f);
-            runSegment(vdir * halfRow, 0); runSegment(0, dy); runSegment(-vdir * halfRow, 0);
-            currentCol = col; return;
-        }
-        if (col == currentCol) {
-            float hdir = (currentCol <= (COLS-1)/2 ? +1.0f : -1.0f);
-            runSegment(0, hdir * halfCol[currentCol]); runSegment(dx, 0); runSegment(0, -hdir * halfCol[col]);
-            currentRow = row; return;
-        }
-        float sx = (dx > 0 ? +1.0f : -1.0f);
-        float sy = (dy > 0 ? +1.0f : -1.0f);
-        float hxs = halfCol[currentCol], hxe = halfCol[col];
-        float hys = halfRow, hye = halfRow;
-        runSegment(0, sy * hxs);
-        runSegment(sx * hys, 0);
-        runSegment(0, dy - sy * (hxs + hxe));
-        runSegment(dx - sx * (hys + hye), 0);
-        runSegment(sx * hye, 0);
-        runSegment(0, sy * hxe);
+        CarriagePath path;
+        MotionLoad load = magnetEngaged ? carriedLoad : MOTION_LOAD_EMPTY;
+        if (!magnetEngaged) {
+            carriageDirectPath(carriage, currentRow, currentCol, row, col, path);
+        } else if (!carriageClearPath(carriage, carriageObstacles, motionProfiles.limits[load],
+                                      currentRow, currentCol, row, col, path)) {
+            carriageLanePath(carriage, currentRow, currentCol, row, col, path);
+        }
+        for (int i = 0; i < path.count; i++) queueMotion(motionSegment(path.dxMm[i], path.dyMm[i], load));
         currentRow = row; currentCol = col;
     }
 
@@ -1006,7 +942,10 @@
 
     // Set up HTTPClient for plain HTTP (local) or HTTPS (deployed).
     // Must call http.end() after the request; _secureClient lifetime is tied to this scope.
+    // HTTP/1.0 keeps the server from chunking the body, so http.getStream() is plain JSON
+    // that readServerResponse() can parse in place.
     void beginHttp(HTTPClient &http, const String &url) {
+        http.useHTTP10(true);
         if (DEPLOY_DOMAIN.length() > 0 && DEPLOY_USE_TLS) {
             _secureClient.setInsecure(); // accept any cert (no CA bundle on ESP32)
             http.begin(_secureClient, url);
@@ -1036,6 +975,7 @@
     // Setup Function
     void setup() {
         Serial.begin(115200);
+        initJsonFilters();
         pinMode(LED_PIN, OUTPUT);
         delay(200);
         
@@ -1053,37 +993,36 @@
         pinMode(E3, OUTPUT);
         digitalWrite(E3, HIGH);
         pinMode(SIG, INPUT);
+        // قياس أقل زمن استقرار للـ mux (يحتاج قطعاً على الرقعة، وإلا يبقى 100us)
+        setReedSettleMicros(measureReedSettleMicros(REED_PINS, 20));
+        Serial.printf("⏱️ Reed settle %u us → %.0f full-board scans/s\n",
+                      (unsigned)reedSettleMicros(), reedScansPerSecond(REED_PINS, 100));
+        startSensorTask(); // من هنا فصاعداً المهمة وحدها تلمس الـ mux
         pinMode(BTN_PIN, INPUT_PULLUP);
+        delay(1);
+        tuningRequested = digitalRead(BTN_PIN) == LOW; // الزر مضغوط عند التشغيل → وضع ضبط الحركة
         pinMode(RESIGN_PIN, INPUT_PULLUP); // تهيئة زر الاستسلام
         
         // Initialize Stepper Motor Pins
+        pinMode(STEP_PIN_A, OUTPUT);
+        pinMode(DIR_PIN_A, OUTPUT);
+        pinMode(STEP_PIN_B, OUTPUT);
+        pinMode(DIR_PIN_B, OUTPUT);
         pinMode(ENABLE_PIN, OUTPUT);
-        digitalWrite(ENABLE_PIN, LOW);
-        motorA.setEnablePin(ENABLE_PIN);
-        motorB.setEnablePin(ENABLE_PIN);
-        motorA.setPinsInverted(false, false, true);
-        motorB.setPinsInverted(false, false, true);
+        digitalWrite(ENABLE_PIN, LOW); // drivers enabled (active LOW)
         
+        loadMotionProfiles(); // قبل مهمة الحركة: هي التي تقرأ الحدود
+
         // Initialize Servo
+        pickPlaceInit(pickPlace, SERVO_TIMING);
+        graveyardClear(graveyard); // لا حساسات في أعمدة الخردة: نفترض أنها فارغة عند التشغيل
         myServo.setPeriodHertz(50);
         myServo.attach(SERVO_PIN, 500, 2500);
         moveServoSmooth(SERVO_RELEASE_ANGLE); // RELEASE
+        startMotionTask(); // من هنا فصاعداً المهمة وحدها تحرّك المحركات والسيرفو
         
         // Pre-compute column offsets
-        colOffsets[0] = 0.0f;
-        halfCol[0] = G0_MM * 0.5f;
-        for (int i = 1; i < COLS; ++i) {
-            if (i == 1) {
-                colOffsets[i] = G0_MM;
-                halfCol[i] = halfRow;
-            } else if (i == COLS-1) {
-                colOffsets[i] = colOffsets[i-1] + G1_MM;
-                halfCol[i] = G1_MM * 0.5f;
-            } else {
-                colOffsets[i] = colOffsets[i-1] + CELL_SIZE_MM;
-                halfCol[i] = halfRow;
-            }
-        }
+        carriageGeometryInit(carriage, CELL_SIZE_MM, CAPTURE_GAP_MM);
         
         Serial.println("🚀 ESP32 Chess Board Starting...");
         Serial.println("ℹ️ Debug pins: LED_PIN=" + String(LED_PIN) + ", DIR_PIN_A=" + String(DIR_PIN_A));
@@ -1119,8 +1058,9 @@
         attachInterrupt(digitalPinToInterrupt(BTN_PIN),    onBtnPress,    FALLING);
         attachInterrupt(digitalPinToInterrupt(RESIGN_PIN), onResignPress, FALLING);
 
+        updateOldBoardFromFen(currentFen); // start position until the server answers
         updateBoardStateFromServer();
-        lastProcessedFen = currentFen;
+        lastProcessedPosition = gamePosition;
 
         // lastBoard is already set from the server FEN by updateOldBoardFromFen() inside
         // updateBoardStateFromServer(). Do NOT overwrite it with a physical scan here —
@@ -1131,10 +1071,12 @@
         scanBoard();  // populates boardState; lastBoard intentionally NOT updated here
 
         memcpy(protectedOldBoard, lastBoard, sizeof(lastBoard));
-        protectedOldFen = currentFen;
+        copyFen(protectedOldFen, currentFen);
+        protectedOldPosition = gamePosition;
         isBoardProtected = true;
 
         calibrateEmptyBoard(); // snapshot false-positive sensors on startup
+        if (tuningRequested) tuneMotionProfiles();
 
         Serial.println("✅ Board initialized and ready!");
         Serial.println("🤖 Opponent move monitoring activated!");
@@ -1155,16 +1097,17 @@
                 Serial.println("💡 [LOOP] wsConnected=" + String(wsConnected) +
                                " namespaceJoined=" + String(namespaceJoined) +
                                " gameId=" + gameId +
-                               " playerColor=" + playerColor);
+                               " playerColor=" + playerColor +
+                               " clock=" + String(whiteTimeLeft) + "/" + String(blackTimeLeft));
             }
         }
 
-        // Real-time sensor broadcast to frontend (only after /friends namespace is confirmed joined)
+        // Real-time sensor stream to frontend (only after /friends namespace is confirmed joined)
         if (namespaceJoined && gameId.length() > 0) {
             unsigned long nowMs = millis();
-            if (nowMs - lastSensorBroadcast >= SENSOR_BROADCAST_INTERVAL_MS) {
+            if (nowMs - lastSensorScan >= SENSOR_SCAN_INTERVAL_MS) {
                 sendBoardSensorUpdate();
-                lastSensorBroadcast = nowMs;
+                lastSensorScan = nowMs;
             }
         }
 
@@ -1181,27 +1124,28 @@
         // نتحقق هنا قبل أي HTTP لضمان أسرع استجابة ممكنة للرقعة الفيزيائية.
         if (opponentMovePending) {
             opponentMovePending = false;
-            // تحقق مزدوج: هل تغيّر FEN فعلاً وهل هي حركة خصم؟
-            if (currentFen != lastProcessedFen) {
-                int fenSpaceIdx = currentFen.indexOf(' ');
-                char fenTurnChar = (fenSpaceIdx >= 0) ? currentFen.charAt(fenSpaceIdx + 1) : '?';
-                char playerColorChar = (playerColor == "white") ? 'w' : 'b';
-                if (fenTurnChar == playerColorChar) {
+            // تحقق مزدوج: هل تغيّرت الوضعية فعلاً وهل هي حركة خصم؟
+            if (gamePosition.hash != lastProcessedPosition.hash) {
+                if (gamePosition.sideToMove == playerSide()) {
                     Serial.println("⚡ Fast-path: WS opponent move → executing motors immediately");
-                    executeOpponentMove(lastProcessedFen, currentFen);
-                    lastProcessedFen = currentFen;
-                    Serial.println("✅ Fast-path move executed");
+                    executeOpponentMove(lastProcessedPosition, gamePosition);
+                    lastProcessedPosition = gamePosition;
+                    Serial.println("✅ Fast-path move queued");
                 } else {
                     // echo للحركة الخاصة — لا تشغيل محركات
-                    lastProcessedFen = currentFen;
+                    lastProcessedPosition = gamePosition;
                 }
             }
         }
+        if (gameEndPending) {
+            gameEndPending = false;
+            enterWaitingForNewGame();
+        }
 
         // ==================== 1) جلب آخر FEN من السيرفر (احتياطي HTTP) ====================
         unsigned long currentTime = millis();
         if (currentTime - lastServerUpdate >= SERVER_UPDATE_INTERVAL) {
-            String prevFen = currentFen; // حفظ FEN السابق للمقارنة
+            Position prevPosition = gamePosition; // حفظ الوضعية السابقة للمقارنة
 
             // منع التزامن مع السيرفر مؤقتاً بعد الـ capture
             if (skipServerSync) {
@@ -1217,9 +1161,9 @@
                 if (updateBoardStateFromServer()) {
                     Serial.println("✅ Server update successful");
 
-                    // تحديث FEN المعالج إذا تم تحديثه من السيرفر
-                    if (currentFen != prevFen) {
-                        lastProcessedFen = prevFen;  // جهّز lastProcessedFen للكشف
+                    // تحديث الوضعية المعالجة إذا تم تحديثها من السيرفر
+                    if (gamePosition.hash != prevPosition.hash) {
+                        lastProcessedPosition = prevPosition;  // جهّز lastProcessedPosition للكشف
                         Serial.println("🔄 FEN updated from server - ready for detection");
                     }
                 } else {
@@ -1230,30 +1174,31 @@
         }
 
         // ==================== 2) كشف حركة الخصم من HTTP (احتياطي إذا فات WS) ====================
-        if (currentFen != lastProcessedFen) {
-            Serial.println("🤖 FEN changed");
-            Serial.println("Last processed FEN: " + lastProcessedFen);
-            Serial.println("Current FEN: " + currentFen);
+        if (gamePosition.hash != lastProcessedPosition.hash) {
+            char lastHash[HASH_HEX_LEN], newHash[HASH_HEX_LEN], lastFen[FEN_MAX_LEN];
+            writeHashHex(lastProcessedPosition.hash, lastHash, sizeof(lastHash));
+            writeHashHex(gamePosition.hash, newHash, sizeof(newHash));
+            positionToFen(lastProcessedPosition, lastFen, sizeof(lastFen));
+            Serial.printf("🤖 Position changed: %s -> %s\n", lastHash, newHash);
+            Serial.printf("Last processed FEN: %s\n", lastFen);
+            Serial.printf("Current FEN: %s\n", currentFen);
             Serial.println("Current Turn: " + currentTurn);
             Serial.println("Player Color: " + playerColor);
 
             // Only execute motors when the new FEN shows it is NOW the player's turn,
             // meaning the OPPONENT just moved. Skip if it is still the opponent's turn
             // (player's own move reflected back, or AI playing the wrong color).
-            int fenSpaceIdx = currentFen.indexOf(' ');
-            char fenTurnChar = (fenSpaceIdx >= 0) ? currentFen.charAt(fenSpaceIdx + 1) : '?';
-            char playerColorChar = (playerColor == "white") ? 'w' : 'b';
-            bool isOpponentMove = (fenTurnChar == playerColorChar);
+            bool isOpponentMove = (gamePosition.sideToMove == playerSide());
 
             if (isOpponentMove) {
                 Serial.println("🤖 Opponent move detected - executing motors");
-                executeOpponentMove(lastProcessedFen, currentFen);
-                Serial.println("✅ Move executed - FEN updated");
+                executeOpponentMove(lastProcessedPosition, gamePosition);
+                Serial.println("✅ Move queued - FEN updated");
             } else {
                 Serial.println("⏩ FEN change is player's own move or server echo - skipping motors");
             }
 
-            lastProcessedFen = currentFen;
+            lastProcessedPosition = gamePosition;
         }
         
         // ==================== 3) فحص حالة اللعبة / الانتقال التلقائي للعبة جديدة ====================
@@ -1270,9 +1215,10 @@
                         // انضم لغرفة اللعبة الجديدة ثم حدّث الحالة المحلية.
                         joinCurrentGameRoom();
                         if (updateBoardStateFromServer()) {
-                            lastProcessedFen = currentFen;
+                            lastProcessedPosition = gamePosition;
                             memcpy(protectedOldBoard, lastBoard, sizeof(lastBoard));
-                            protectedOldFen = currentFen;
+                            copyFen(protectedOldFen, currentFen);
+                            protectedOldPosition = gamePosition;
                             skipServerSync = false;
                             serverSyncSkipCount = 0;
                             hasResigned = false;
@@ -1280,7 +1226,7 @@
                             btnPressedFlag = false;
                             resignPressedFlag = false;
                             // Re-scan physical board so lastBoard matches reality
-                            scanBoardStable(boardState, 5, 5);
+                            readSettledBoard(boardState, SENSOR_QUIET_MS, SENSOR_SETTLE_TIMEOUT_MS);
                             memcpy(lastBoard, boardState, sizeof(boardState));
                             memcpy(protectedOldBoard, lastBoard, sizeof(lastBoard));
                             Serial.println("✅ Ready for the new game without ESP restart.");
@@ -1306,432 +1252,459 @@
             lastGameStatusCheck = currentTime;
         }
         
+        // كشف حركة اللاعب تلقائياً (رفع/وضع القطع) دون الحاجة للزر
+        trackPlayerMove();
+
         // كشف حركة اللاعب عبر interrupt flag
         if (btnPressedFlag) {
             btnPressedFlag = false;
             Serial.println("🔘 BTN PRESSED");
-            // Settle window: let the piece magnet stop moving before scanning.
-            // 200ms + 15 samples × 8ms = ~320ms total — filters magnetic coupling transients.
-            delay(200);
-            scanBoardStable(boardState, 15, 8);
+            // The per-square filter already absorbs magnetic coupling transients; only wait for the
+            // board to be quiet for SENSOR_QUIET_MS (usually long done by the time the button is hit).
+            readSettledBoard(boardState, SENSOR_QUIET_MS, SENSOR_SETTLE_TIMEOUT_MS);
             printBoardArray(lastBoard, "Old Board");
             printBoardArray(boardState, "New Board");
-            Serial.println("Old FEN: " + currentFen);
+            Serial.printf("Old FEN: %s\n", currentFen);
             Serial.println("Current Turn: " + currentTurn);
             Serial.println("Player Color: " + playerColor);
             
             int rem, add;
             countDiffs(lastBoard, boardState, rem, add);
-            
-            // --- Spurious-sensor recovery: rem=1, add=2 ---
-            // This happens when a moving piece's magnet couples magnetically with a nearby sensor,
-            // triggering a false "piece appeared" reading. Try to recover by checking if exactly
-            // one of the two "added" squares is a valid move destination according to the FEN.
-            if (rem == 1 && add == 2) {
-                Serial.println("⚠️ rem=1,add=2 — attempting spurious-sensor recovery");
-                logBoardDiffDetails(lastBoard, boardState);
-
-                // Find the removed square (source) and the two added squares
-                int srcR = -1, srcC = -1;
-                int addR[2] = {-1, -1}, addC[2] = {-1, -1};
-                int ai = 0;
-                for (int r = 0; r < 8 && ai <= 2; r++) {
-                    for (int c = 0; c < 8 && ai <= 2; c++) {
-                        if (lastBoard[r][c] && !boardState[r][c]) { srcR = r; srcC = c; }
-                        if (!lastBoard[r][c] && boardState[r][c] && ai < 2) { addR[ai] = r; addC[ai] = c; ai++; }
-                    }
-                }
 
-                // Build a synthetic single-add board for each candidate and try to infer the move
-                bool recovered = false;
-                for (int candidate = 0; candidate < 2 && !recovered; candidate++) {
-                    bool trialBoard[8][8];
-                    memcpy(trialBoard, lastBoard, sizeof(lastBoard));
-                    trialBoard[srcR][srcC] = false;
-                    trialBoard[addR[candidate]][addC[candidate]] = true;
-                    // The other candidate square must be empty in old board AND it appeared → spurious
-                    int otherR = addR[1 - candidate], otherC = addC[1 - candidate];
-                    // Check: other square was empty in lastBoard (it is, by definition of add)
-                    // and leave trialBoard[otherR][otherC] = false (as in lastBoard)
-
-                    MoveResult mv;
-                    BoardTransform usedTransform = MAP_IDENTITY;
-                    bool inferred = inferMoveTransform(lastBoard, trialBoard, currentFen, currentTurn, false, mv, usedTransform);
-                    if (inferred && mv.fromSq.length() && mv.toSq.length() && mv.newFen.length()) {
-                        Serial.println("🔧 Recovered: ignoring spurious sensor at r=" + String(otherR) + ",c=" + String(otherC));
-                        // Accept the move using the clean trial board
-                        memcpy(boardState, trialBoard, sizeof(trialBoard));
-                        rem = 1; add = 1;
-                        recovered = true;
-                    }
-                }
+            if (motionBusy()) {
+                Serial.println("⚠️ Move ignored: the board is still playing the opponent's move.");
+                blinkLED(2);
+            } else if (rem == 0 && add == 0) {
+                Serial.println("⚠️ No legal move shape detected.");
+                Serial.println("ℹ️ Explanation: no square changed, so no piece moved.");
+                restoreProtectedState();
+            } else if (currentTurn != playerColor) {
+                Serial.println("⚠️ Move ignored: not your turn.");
+                Serial.println("ℹ️ Explanation: currentTurn=" + currentTurn + ", playerColor=" + playerColor);
+                blinkLED(2);
+                restoreProtectedState();
+            } else {
+                // Every legal move is scored against the reading under the per-reed error model, so a
+                // spurious or missed reed (magnetic coupling, a weak magnet) does not reject the move.
+                Serial.println("♟️ Move delta detected: rem=" + String(rem) + ", add=" + String(add));
+                uint8_t mask = sensorSquareMask(LOCKED_SENSOR_MAP);
+                MoveInference inference = inferMostLikelyMove(gamePosition, sensorBoardBits(boardState), mask, sensorErrors);
+                char bestUci[UCI_MAX_LEN] = "none", runnerUci[UCI_MAX_LEN] = "none";
+                if (inference.best != MOVE_NONE) moveToUci(inference.best, bestUci, sizeof(bestUci));
+                if (inference.runnerUp != MOVE_NONE) moveToUci(inference.runnerUp, runnerUci, sizeof(runnerUci));
+                Serial.printf("🎯 Most likely: %s, runner-up: %s, margin %.1f over %d moves\n",
+                              bestUci, runnerUci, inference.margin, inference.candidates);
 
-                if (!recovered) {
+                MoveResult mv;
+                if (!moveInferenceAccepted(inference) || !buildMoveResult(gamePosition, inference.best, mv)) {
+                    Serial.println("❌ Move inference failed, restoring protected state.");
+                    Serial.println("ℹ️ Explanation: no legal move explains the board clearly enough.");
+                    logBoardDiffDetails(lastBoard, boardState);
+                    restoreProtectedState();
                     blinkLED(3);
-                    Serial.println("❌ Recovery failed — rejecting move.");
-                    memcpy(lastBoard, protectedOldBoard, sizeof(protectedOldBoard));
-                    currentFen = protectedOldFen;
+                } else {
+                    boardAfterMove(gamePosition, inference.best, boardState);
+                    commitPlayerMove(mv);
                 }
-                // If recovered, fall through to the rem==1 && add==1 branch below
             }
+        }
+    }
 
-            if (rem > 1 || add > 1) {
-                // Still invalid after any recovery attempt (double-restore is harmless)
-                blinkLED(3);
-                Serial.println("⚠️ Invalid board delta: rem=" + String(rem) + " add=" + String(add));
-                logBoardDiffDetails(lastBoard, boardState);
-                memcpy(lastBoard, protectedOldBoard, sizeof(protectedOldBoard));
-                currentFen = protectedOldFen;
+    // Sensor board the move leaves behind: what lastBoard becomes for an inferred move, rather than
+    // the reading with its stray reeds.
+    void boardAfterMove(const Position &pos, Move move, bool outBoard[8][8]) {
+        Position next = pos;
+        UndoInfo undo;
+        makeMove(next, move, undo);
+        positionToSensorBoard(next, LOCKED_SENSOR_MAP, outBoard);
+    }
 
-            } else if (rem == 1 && (add == 0 || add == 1)) {
-                bool isCaptureShape = (add == 0);
-                Serial.println(
-                    String(isCaptureShape ? "🎯 Capture-shape" : "♟️ Normal-shape") +
-                    " move detected: rem=" + String(rem) + ", add=" + String(add)
-                );
+    // Applies the player's move locally (position, FEN, boards) and sends it to the server.
+    // boardState must hold the board after the move.
+    void commitPlayerMove(const MoveResult &mv) {
+        Serial.println("✅ Inferred move:");
+        Serial.printf("   from=%s, to=%s, san=%s\n", mv.fromSq, mv.toSq, mv.san);
+        Serial.printf("   newFen=%s\n", mv.newFen);
+
+        UndoInfo undo;
+        makeMove(gamePosition, mv.move, undo);
+        refreshLegalMoveTable();
+        copyFen(currentFen, mv.newFen);
+        memcpy(lastBoard, boardState, sizeof(boardState));
+        memcpy(protectedOldBoard, lastBoard, sizeof(lastBoard));
+        copyFen(protectedOldFen, currentFen);
+        protectedOldPosition = gamePosition;
+
+        const char *nextTurn = (currentTurn == "white") ? "black" : "white";
+
+        // Primary: WebSocket move event — isPhysical:true so phone shows board notification.
+        // Promotion only when pawn reaches last rank (buildMove defaults to queen).
+        MoveMessage msg = {
+            gameId.c_str(), mv.fromSq, mv.toSq, moveIsPromotion(mv.move) ? "q" : "",
+            mv.san, mv.newFen, playerColor.c_str(), nextTurn, gamePosition.hash
+        };
+        static char frame[MOVE_FRAME_MAX];
+        size_t frameLen = writeMoveFrame(msg, frame, sizeof(frame));
+
+        if (wsConnected && frameLen) {
+            webSocket.sendTXT(frame, frameLen);
+            Serial.printf("📤 Move sent via WebSocket (primary): %s->%s\n", mv.fromSq, mv.toSq);
+        } else {
+            // Fallback: HTTP عندما لا يكون WebSocket متصلاً
+            Serial.println("⚠️ WS not connected, falling back to HTTP");
+            bool httpOk = submitMoveHTTP(msg);
+            if (!httpOk) {
+                Serial.println("❌ HTTP fallback also failed");
+            }
+        }
+        Serial.println("ℹ️ Explanation: accepted legal move and synchronized local FEN.");
+        // Heap watermark: should stay flat from move to move (see host/bench_codec.cpp).
+        Serial.printf("🧮 Heap free=%u min=%u\n", (unsigned)ESP.getFreeHeap(), (unsigned)ESP.getMinFreeHeap());
 
-                if (currentTurn != playerColor) {
-                    Serial.println("⚠️ Move ignored: not your turn.");
-                    Serial.println("ℹ️ Explanation: currentTurn=" + currentTurn + ", playerColor=" + playerColor);
-                    blinkLED(2);
-                    memcpy(lastBoard, protectedOldBoard, sizeof(protectedOldBoard));
-                    currentFen = protectedOldFen;
-                } else {
-                    MoveResult mv;
-                    BoardTransform usedTransform = MAP_IDENTITY;
-                    bool inferred = inferMoveTransform(lastBoard, boardState, currentFen, currentTurn, isCaptureShape, mv, usedTransform);
-
-                    if (!inferred || !mv.fromSq.length() || !mv.toSq.length() || !mv.newFen.length()) {
-                        Serial.println("❌ Move inference failed, restoring protected state.");
-                        Serial.println("ℹ️ Explanation: board delta cannot be mapped to one legal move.");
-                        memcpy(lastBoard, protectedOldBoard, sizeof(protectedOldBoard));
-                        currentFen = protectedOldFen;
-                        blinkLED(3);
-                    } else {
-                        Serial.println("✅ Inferred move:");
-                        Serial.println("   from=" + mv.fromSq + ", to=" + mv.toSq + ", san=" + mv.san);
-                        Serial.println("   mappingMode=" + String((int)usedTransform));
-                        Serial.println("   newFen=" + mv.newFen);
-
-                        currentFen = mv.newFen;
-                        memcpy(lastBoard, boardState, sizeof(boardState));
-                        memcpy(protectedOldBoard, lastBoard, sizeof(lastBoard));
-                        protectedOldFen = currentFen;
-
-                        String nextTurn = (currentTurn == "white") ? "black" : "white";
-
-                        // Promotion only when pawn reaches last rank
-                        bool isPawnMove = (mv.san.length() > 0 && mv.san.charAt(0) >= 'a' && mv.san.charAt(0) <= 'h');
-                        char toRankChar  = mv.toSq.charAt(1);
-                        bool isPromotion = isPawnMove &&
-                            ((playerColor == "white" && toRankChar == '8') ||
-                             (playerColor == "black" && toRankChar == '1'));
-                        String promVal = isPromotion ? "q" : "";
-
-                        // Primary: WebSocket move event — isPhysical:true so phone shows board notification
-                        String p = "{\"gameId\":" + gameId + "," +
-                                "\"from\":\"" + mv.fromSq + "\"," +
-                                "\"to\":\""   + mv.toSq   + "\"," +
-                                "\"promotion\":\"" + promVal + "\"," +
-                                "\"san\":\""  + mv.san    + "\"," +
-                                "\"fen\":\""  + mv.newFen + "\"," +
-                                "\"movedBy\":\"" + playerColor + "\"," +
-                                "\"currentTurn\":\"" + nextTurn + "\"," +
-                                "\"isPhysical\":true}";
-                        String frame = "42/friends,[\"move\"," + p + "]";
-
-                        if (wsConnected) {
-                            webSocket.sendTXT(frame);
-                            Serial.println("📤 Move sent via WebSocket (primary): " + mv.fromSq + "->" + mv.toSq);
-                        } else {
-                            // Fallback: HTTP عندما لا يكون WebSocket متصلاً
-                            Serial.println("⚠️ WS not connected, falling back to HTTP");
-                            bool httpOk = submitMoveHTTP(mv.fromSq, mv.toSq, mv.san, mv.newFen);
-                            if (!httpOk) {
-                                Serial.println("❌ HTTP fallback also failed");
-                            }
-                        }
-                        Serial.println("ℹ️ Explanation: accepted legal move and synchronized local FEN.");
+        currentTurn = nextTurn;
+        lastProcessedPosition = gamePosition;
+        skipServerSync = true;
+        serverSyncSkipCount = 0;
+        Serial.println("⏸️ Temporary sync skip enabled to avoid self-move replay.");
 
-                        currentTurn = nextTurn;
-                        lastProcessedFen = currentFen;
-                        skipServerSync = true;
-                        serverSyncSkipCount = 0;
-                        Serial.println("⏸️ Temporary sync skip enabled to avoid self-move replay.");
+        digitalWrite(LED_PIN, HIGH);
+        delay(80);
+        digitalWrite(LED_PIN, LOW);
+    }
 
-                        digitalWrite(LED_PIN, HIGH);
-                        delay(80);
-                        digitalWrite(LED_PIN, LOW);
-                    }
-                }
-            } else {
-                Serial.println("⚠️ No legal move shape detected.");
-                Serial.println("ℹ️ Explanation: expected (rem=1,add=1) or capture-shape (rem=1,add=0).");
-                memcpy(lastBoard, protectedOldBoard, sizeof(protectedOldBoard));
-                currentFen = protectedOldFen;
+    // Feeds new sensor snapshots to the move tracker while it is the player's turn and the carriage
+    // is not still setting up the opponent's move.
+    void trackPlayerMove() {
+        if (!AUTO_MOVE_DETECTION || isFetchingNewGame || gameId.length() == 0 || currentTurn != playerColor) return;
+        if (motionBusy()) return;
+        SensorSnapshot snapshot;
+        readSensorSnapshot(snapshot);
+        if (snapshot.scan == lastTrackedScan) return;
+        lastTrackedScan = snapshot.scan;
+
+        // lastBoard changes under the tracker on server syncs, rollbacks and opponent moves
+        Bitboard reference = sensorBoardBits(lastBoard);
+        if (moveTracker.reference != reference) {
+            moveTrackerReset(moveTracker, reference, sensorSquareMask(LOCKED_SENSOR_MAP), snapshot.scannedAtMs);
+        }
+
+        MoveTrackerEvent event = moveTrackerUpdate(moveTracker, legalMoveTable, snapshot.occupancy,
+                                                   snapshot.scannedAtMs, MOVE_TRACKER_CONFIG);
+        if (event.kind == MOVE_EVENT_COMMIT) {
+            MoveResult mv;
+            if (!buildMoveResult(gamePosition, event.move, mv)) return;
+            sensorBoardFromBits(snapshot.occupancy, boardState);
+            Serial.println("🤖 Move detected from lift/place (no button)");
+            commitPlayerMove(mv);
+        } else if (event.kind == MOVE_EVENT_ILLEGAL) {
+            // No exact match: a stray or missed reed may be hiding the move, ask the error model.
+            // Only captures whose victim has been lifted count, like in the tracker itself.
+            MoveInference inference = inferMostLikelyMove(gamePosition, snapshot.occupancy,
+                                                          sensorSquareMask(LOCKED_SENSOR_MAP), sensorErrors,
+                                                          moveTracker.lifted);
+            MoveResult mv;
+            if (moveInferenceAccepted(inference) && buildMoveResult(gamePosition, inference.best, mv)) {
+                boardAfterMove(gamePosition, inference.best, boardState);
+                Serial.printf("🎯 Move inferred despite sensor noise (margin %.1f)\n", inference.margin);
+                commitPlayerMove(mv);
+                return;
             }
+            bool current[8][8];
+            sensorBoardFromBits(snapshot.occupancy, current);
+            Serial.println("⚠️ Board matches no legal move — finish the move or put the pieces back.");
+            logBoardDiffDetails(lastBoard, current);
+            blinkLED(3);
         }
     }
 
-    // Additional helper functions
-    void fenToBoard(const String &fen, char board[8][8]) {
-        String parts[6];
-        int idx = 0, start = 0;
-        for (int i = 0; i <= fen.length() && idx < 6; i++) {
-            if (i == fen.length() || fen[i] == ' ') {
-                parts[idx++] = fen.substring(start, i);
-                start = i + 1;
-            }
+    // Queues carrying one piece between two motor cells: release → travel → engage → travel → seat → release.
+    void carryPiece(int fromRow, int fromCol, int toRow, int toCol, MotionLoad load) {
+        MotionCommand servo[PICK_PLACE_MAX_COMMANDS];
+        carriedLoad = load;
+        // 1) RELEASE → origin (sets off once the arm is clear of the pieces)
+        queuePickPlace(servo, pickPlaceRaise(pickPlace, servo));
+        moveToCell(fromRow, fromCol);
+        // 2) ENGAGE — lowering starts while the carriage decelerates into the square
+        queuePickPlace(servo, pickPlaceGrip(pickPlace, servo));
+        // 3) move to destination while ENGAGED
+        moveToCell(toRow, toCol);
+        // 4) Tap down to seat piece, then RELEASE — leaves as soon as the arm is clear
+        queuePickPlace(servo, pickPlaceDrop(pickPlace, servo));
+    }
+
+    void queuePickPlace(const MotionCommand *commands, int count) {
+        for (int i = 0; i < count; i++) queueMotion(commands[i]);
+    }
+
+    // دالة تنفيذ حركة الخصم: تضع الحركة كاملة في طابور الحركة وتعود فوراً (مهمة الحركة تنفّذها)
+    void executeOpponentMove(const Position &prevPos, const Position &curPos) {
+        // تحديد الحركة القانونية التي تنقل الوضعية السابقة إلى الحالية (تشمل التبييت والأخذ بالتجاوز)
+        Move move = findMoveBetween(prevPos, curPos);
+        if (move == MOVE_NONE) {
+            queueMotion(motionServo(SERVO_RELEASE_ANGLE)); // مهم
+            Serial.println("❌ Position diff is not a single legal move - aborting motor move");
+            return;
         }
-        
-        String fenRanks[8];
-        int ri = 0, si = 0;
-        for (int i = 0; i <= parts[0].length(); i++) {
-            if (i == parts[0].length() || parts[0][i] == '/') {
-                fenRanks[ri++] = parts[0].substring(si, i);
-                si = i + 1;
+
+        int fromSq = moveFrom(move), toSq = moveTo(move);
+        uint8_t flags = moveFlags(move);
+        bool capture = moveIsCapture(move);
+        Serial.println("🎯 Move: " + squareToString(fromSq) + " -> " + squareToString(toSq));
+        Serial.println("🎯 Capture: " + String(capture ? "YES" : "NO"));
+
+        carriageObstacles.board = prevPos.occupiedAll; // القطع التي يجب الالتفاف حولها
+        graveyardObstacles(graveyard, carriageObstacles);
+
+        // تحويل مربعات الرقعة إلى إحداثيات المحرك الفيزيائية.
+        // الصفوف: rank1 → motor row 0 ... rank8 → motor row 7 (نفس squareRow).
+        // الأعمدة: motor col 0 = a-file (يسار أبيض) = نفس squareCol، +1 offset for grid (عمود 0 للخردة).
+        if (capture) {
+            // En passant: the captured pawn sits beside the destination, on the mover's rank.
+            int capSq = (flags == MF_EP_CAPTURE) ? squareOf(squareRow(fromSq), squareCol(toSq)) : toSq;
+            carryToGraveyard(capSq, prevPos.board[capSq]);
+        }
+
+        // A promotion fetches the new piece from the graveyard if one is there: it goes to the
+        // promotion square first (freeing its slot), then the pawn goes to the graveyard.
+        uint8_t mover = prevPos.board[fromSq];
+        uint8_t promoted = moveIsPromotion(move) ? pieceCode(pieceColor(mover), movePromotionType(move)) : NO_PIECE;
+        int slotRow, slotCol;
+        if (promoted != NO_PIECE && graveyardFind(graveyard, promoted, squareRow(toSq), slotRow, slotCol)) {
+            Serial.println("👑 Promotion: " + String(pieceChar(promoted)) + " from the graveyard (" + String(slotRow) + "," +
+                           String(slotCol) + ") to " + squareToString(toSq));
+            graveyardTake(graveyard, slotRow, slotCol);
+            graveyardObstacles(graveyard, carriageObstacles);
+            carryPiece(slotRow, slotCol, squareRow(toSq), squareCol(toSq) + 1, motionLoadOf(promoted));
+            carriageObstacles.board |= squareBit(toSq);
+            carryToGraveyard(fromSq, mover);
+        } else {
+            // Move active piece
+            Serial.println("🤖 Moving piece from (" + String(squareRow(fromSq)) + "," + String(squareCol(fromSq) + 1) +
+                           ") to (" + String(squareRow(toSq)) + "," + String(squareCol(toSq) + 1) + ")");
+            carryPiece(squareRow(fromSq), squareCol(fromSq) + 1, squareRow(toSq), squareCol(toSq) + 1, motionLoadOf(mover));
+            carriageObstacles.board = (carriageObstacles.board & ~squareBit(fromSq)) | squareBit(toSq);
+            if (promoted != NO_PIECE) {
+                Serial.println("👑 Promotion to " + String(pieceChar(promoted)) + " on " + squareToString(toSq) +
+                               " - none in the graveyard, replace the pawn by hand");
             }
         }
-        
-        for (int r = 0; r < 8; r++) {
-            String rowFen = fenRanks[7 - r];
-            int c = 0;
-            for (char ch : rowFen) {
-                if (isdigit(ch)) {
-                    int n = ch - '0';
-                    while (n--) board[r][c++] = '.';
-                } else {
-                    board[r][c++] = ch;
-                }
-            }
+
+        if (moveIsCastle(move)) {
+            int rookFrom = (flags == MF_KING_CASTLE) ? toSq + 1 : toSq - 2;
+            int rookTo = (flags == MF_KING_CASTLE) ? toSq - 1 : toSq + 1;
+            Serial.println("🏰 Castling rook: " + squareToString(rookFrom) + " -> " + squareToString(rookTo));
+            carryPiece(squareRow(rookFrom), squareCol(rookFrom) + 1, squareRow(rookTo), squareCol(rookTo) + 1,
+                       motionLoadOf(prevPos.board[rookFrom]));
         }
-    }
 
-    bool isValidSquare(int row, int col) {
-        return row >= 0 && row < 8 && col >= 0 && col < 8;
+        // Safety re-write in case PWM noise corrupted the release
+        queueMotion(motionServo(SERVO_RELEASE_ANGLE));
+        Serial.println("✅ Opponent move queued (" + String(MOTION_QUEUE_CAPACITY - motionQueueFree(motionQueue)) + " motion commands)");
     }
 
-    bool isWhitePiece(char piece) {
-        return piece >= 'A' && piece <= 'Z';
+    // Carries the piece on board square sq to the nearest free graveyard slot. With both capture
+    // columns full it has to be taken off by hand: waits (motors done) until the sensors show sq empty.
+    void carryToGraveyard(int sq, uint8_t piece) {
+        int slotRow, slotCol;
+        if (graveyardFreeSlot(graveyard, piece, squareRow(sq), slotRow, slotCol)) {
+            Serial.println("🗑️ " + String(pieceChar(piece)) + " on " + squareToString(sq) + " to the graveyard (" +
+                           String(slotRow) + "," + String(slotCol) + ")");
+            carriageObstacles.board &= ~squareBit(sq);
+            carryPiece(squareRow(sq), squareCol(sq) + 1, slotRow, slotCol, motionLoadOf(piece));
+            graveyardPut(graveyard, slotRow, slotCol, piece);
+            graveyardObstacles(graveyard, carriageObstacles);
+            return;
+        }
+        while (motionBusy()) {
+            webSocket.loop();
+            delay(5);
+        }
+        Serial.println("🖐️ Graveyard full - take " + String(pieceChar(piece)) + " off " + squareToString(sq) + " by hand");
+        bool settled[8][8];
+        do {
+            webSocket.loop();
+            readSettledBoard(settled, SENSOR_QUIET_MS, SENSOR_SETTLE_TIMEOUT_MS);
+        } while (sensorOccupancy(settled, LOCKED_SENSOR_MAP) & squareBit(sq));
+        carriageObstacles.board &= ~squareBit(sq);
     }
 
-    bool isBlackPiece(char piece) {
-        return piece >= 'a' && piece <= 'z';
+    // Motion profiles from flash (Preferences "motion"/"profiles"); the defaults if none or stale.
+    void loadMotionProfiles() {
+        MotionProfiles stored;
+        motionPrefs.begin("motion", true);
+        bool found = motionPrefs.getBytes("profiles", &stored, sizeof(stored)) == sizeof(stored);
+        motionPrefs.end();
+        bool tuned = found && motionProfilesValid(stored);
+        if (tuned) motionProfiles = stored;
+        else if (found) Serial.println("⚠️ Stored motion profiles are stale or out of range - using the defaults");
+        for (int i = 0; i < MOTION_LOAD_COUNT; i++) {
+            Serial.printf("🏎️ Motion profile %s: %.0f mm/s, %.0f mm/s² %s\n", motionLoadName(MotionLoad(i)),
+                          motionProfiles.limits[i].maxSpeed, motionProfiles.limits[i].accel, tuned ? "(tuned)" : "(default)");
+        }
     }
 
-    bool isCurrentPlayerPiece(char piece, const String &currentTurn) {
-        if (piece == '.') return false;
-        if (currentTurn == "white") return (piece >= 'A' && piece <= 'Z');
-        else return (piece >= 'a' && piece <= 'z');
+    void saveMotionProfiles() {
+        motionPrefs.begin("motion", false);
+        motionPrefs.putBytes("profiles", &motionProfiles, sizeof(motionProfiles));
+        motionPrefs.end();
+        Serial.println("💾 Motion profiles saved");
     }
 
-    bool isValidMove(char board[8][8], int fromRow, int fromCol, int toRow, int toCol, const String &currentTurn) {
-        if (!isValidSquare(fromRow, fromCol) || !isValidSquare(toRow, toCol)) return false;
-        char piece = board[fromRow][fromCol];
-        char target = board[toRow][toCol];
-        if (piece == '.') return false;
-        if (!isCurrentPlayerPiece(piece, currentTurn)) return false;
-        if (target != '.' && isCurrentPlayerPiece(target, currentTurn)) return false;
-        
-        char p = (piece >= 'a' && piece <= 'z') ? piece - 32 : piece;
-        switch (p) {
-            case 'P': {
-                int dir = (currentTurn == "white") ? 1 : -1;
-                int startRow = (currentTurn == "white") ? 1 : 6;
-                if (fromCol == toCol && toRow - fromRow == dir && board[toRow][toCol] == '.') return true;
-                if (fromCol == toCol && fromRow == startRow && toRow - fromRow == 2*dir && board[fromRow+dir][fromCol] == '.' && board[toRow][toCol] == '.') return true;
-                if (abs(toCol - fromCol) == 1 && toRow - fromRow == dir && board[toRow][toCol] != '.' && !isCurrentPlayerPiece(board[toRow][toCol], currentTurn)) return true;
-                return false;
-            }
-            case 'N': {
-                int dr = abs(toRow - fromRow), dc = abs(toCol - fromCol);
-                return (dr == 2 && dc == 1) || (dr == 1 && dc == 2);
-            }
-            case 'B': {
-                int dr = toRow - fromRow, dc = toCol - fromCol;
-                if (abs(dr) != abs(dc)) return false;
-                int rStep = (dr > 0) ? 1 : -1, cStep = (dc > 0) ? 1 : -1;
-                for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow; r += rStep, c += cStep)
-                    if (board[r][c] != '.') return false;
-                return true;
-            }
-            case 'R': {
-                if (fromRow != toRow && fromCol != toCol) return false;
-                int rStep = (toRow == fromRow) ? 0 : ((toRow > fromRow) ? 1 : -1);
-                int cStep = (toCol == fromCol) ? 0 : ((toCol > fromCol) ? 1 : -1);
-                for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow || c != toCol; r += rStep, c += cStep)
-                    if (board[r][c] != '.') return false;
-                return true;
-            }
-            case 'Q': {
-                int dr = toRow - fromRow, dc = toCol - fromCol;
-                if (abs(dr) == abs(dc)) {
-                    int rStep = (dr > 0) ? 1 : -1, cStep = (dc > 0) ? 1 : -1;
-                    for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow; r += rStep, c += cStep)
-                        if (board[r][c] != '.') return false;
-                    return true;
-                } else if (fromRow == toRow || fromCol == toCol) {
-                    int rStep = (toRow == fromRow) ? 0 : ((toRow > fromRow) ? 1 : -1);
-                    int cStep = (toCol == fromCol) ? 0 : ((toCol > fromCol) ? 1 : -1);
-                    for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow || c != toCol; r += rStep, c += cStep)
-                        if (board[r][c] != '.') return false;
-                    return true;
+    // Tuning mode (button held at power-up, run once the board matches the game position): for each
+    // load, a piece of that class is carried to the farthest empty square and back at ever faster
+    // limits until the sensors find it missing or misplaced; one step below the fastest limits that
+    // worked is saved (motion_tuning.h).
+    // Empty travel goes last, through the far corner before every carry (at the tuned light limits),
+    // and fails when a carry lands off its square because the carriage lost steps.
+    void tuneMotionProfiles() {
+        Serial.println("🛠️ Motion tuning mode");
+        bool settled[8][8];
+        readSettledBoard(settled, 300, 3000);
+        Bitboard start = gamePosition.occupiedAll;
+        if (sensorOccupancy(settled, LOCKED_SENSOR_MAP) != start) {
+            Serial.println("❌ Board does not match the game position - tuning skipped");
+            return;
+        }
+        const MotionLoad ORDER[MOTION_LOAD_COUNT] = { MOTION_LOAD_LIGHT, MOTION_LOAD_HEAVY, MOTION_LOAD_EMPTY };
+        bool anyPassed = false;
+        for (MotionLoad load : ORDER) {
+            MotionLoad pieceLoad = load == MOTION_LOAD_EMPTY ? MOTION_LOAD_LIGHT : load;
+            // the piece of this class with the longest way to an empty square
+            int from = NO_SQUARE, to = NO_SQUARE, best = -1;
+            for (int sq = 0; sq < 64; sq++) {
+                if (gamePosition.board[sq] == NO_PIECE || motionLoadOf(gamePosition.board[sq]) != pieceLoad) continue;
+                for (int dest = 0; dest < 64; dest++) {
+                    if (start & squareBit(dest)) continue;
+                    int dr = squareRow(dest) - squareRow(sq), dc = squareCol(dest) - squareCol(sq);
+                    if (dr * dr + dc * dc > best) { best = dr * dr + dc * dc; from = sq; to = dest; }
                 }
-                return false;
             }
-            case 'K': {
-                int dr = abs(toRow - fromRow), dc = abs(toCol - fromCol);
-                return dr <= 1 && dc <= 1;
+            if (from == NO_SQUARE) {
+                Serial.printf("⚠️ No %s piece to tune with - keeping its profile\n", motionLoadName(load));
+                continue;
             }
-            default:
-                return false;
-        }
-    }
-
-    // دالة تنفيذ حركة الخصم
-    void executeOpponentMove(const String &prevFen, const String &currentFen) {
-        char prevB[8][8], curB[8][8];
-        parseFen(prevFen, prevB);
-        parseFen(currentFen, curB);
-
-        // البحث عن مربع البداية والنهاية
-        int fr = -1, fc = -1, tr = -1, tc = -1;
-        int removedCount = 0, addedCount = 0;
-        for (int r = 0; r < 8; ++r) {
-            for (int c = 0; c < 8; ++c) {
-                if (prevB[r][c] != '.' && curB[r][c] == '.') {
-                    removedCount++;
-                    fr = r; fc = c;
-                    Serial.println("🔍 Found removed piece at: (" + String(r) + "," + String(c) + ")");
-                }
-                if (prevB[r][c] != curB[r][c] && curB[r][c] != '.') {
-                    addedCount++;
-                    tr = r; tc = c;
-                    Serial.println("🔍 Found added piece at: (" + String(r) + "," + String(c) + ")");
-                }
+            MotionTuner tuner;
+            motionTunerBegin(tuner, motionProfiles.limits[load]);
+            while (!tuner.done) {
+                motionProfiles.limits[load] = tuner.trial; // the queue is idle between runs
+                bool arrived = tuningCarry(from, to, load, pieceLoad, start) &&
+                               tuningCarry(to, from, load, pieceLoad, (start & ~squareBit(from)) | squareBit(to));
+                Serial.printf("🛠️ %s %.0f mm/s %.0f mm/s²: %s\n", motionLoadName(load), tuner.trial.maxSpeed,
+                              tuner.trial.accel, arrived ? "✅" : "❌");
+                motionTunerResult(tuner, arrived);
+                if (!arrived) waitForBoardRestored(start);
             }
-        }
+            // nothing passed, not even the slowest trial: the starting limits are known to fail
+            motionProfiles.limits[load] = tuner.passed ? tuner.safe : MOTION_PROFILES_DEFAULTS.limits[load];
+            if (tuner.passed) anyPassed = true;
+            Serial.printf("%s %s profile: %.0f mm/s, %.0f mm/s²%s\n", tuner.passed ? "🏎️" : "❌", motionLoadName(load),
+                          motionProfiles.limits[load].maxSpeed, motionProfiles.limits[load].accel,
+                          tuner.passed ? "" : " (tuning failed - firmware defaults)");
+        }
+        MotionCommand servo[PICK_PLACE_MAX_COMMANDS];
+        queuePickPlace(servo, pickPlaceRaise(pickPlace, servo));
+        moveToCell(0, 0);
+        while (motionBusy()) delay(5);
+        if (anyPassed) saveMotionProfiles();
+        else Serial.println("❌ Motion tuning failed for every load - nothing saved");
+    }
 
-        if (removedCount != 1 || addedCount != 1) {
-            moveServoSmooth(SERVO_RELEASE_ANGLE); // مهم
-            Serial.println("❌ Ambiguous FEN diff: removed=" + String(removedCount) + " added=" + String(addedCount) + " - aborting motor move");
-            return;
-        }
+    // One tuning carry from board square `from` to `to`, with the board occupied as `before`;
+    // true if the sensors then show the piece moved and nothing else changed.
+    bool tuningCarry(int from, int to, MotionLoad load, MotionLoad pieceLoad, Bitboard before) {
+        if (load == MOTION_LOAD_EMPTY) moveToCell(CARRIAGE_ROWS - 1, CARRIAGE_COLS - 1);
+        carriageObstacles.board = before & ~squareBit(from);
+        carryPiece(squareRow(from), squareCol(from) + 1, squareRow(to), squareCol(to) + 1, pieceLoad);
+        while (motionBusy()) {
+            webSocket.loop();
+            delay(5);
+        }
+        bool settled[8][8];
+        readSettledBoard(settled, 300, 3000);
+        return sensorOccupancy(settled, LOCKED_SENSOR_MAP) == ((before & ~squareBit(from)) | squareBit(to));
+    }
 
-        if (fr < 0 || tr < 0) {
-            Serial.println("❌ Error: Could not determine move coordinates");
-            return;
+    // After a failed trial: motors off so the carriage can be pushed back to its home corner, the
+    // pieces back on their squares by hand, then the button.
+    void waitForBoardRestored(Bitboard expected) {
+        digitalWrite(ENABLE_PIN, HIGH);
+        for (;;) {
+            Serial.println("🖐️ Put the pieces back and the carriage on its home corner, then press the button");
+            btnPressedFlag = false;
+            while (!btnPressedFlag) {
+                webSocket.loop();
+                delay(20);
+            }
+            bool settled[8][8];
+            readSettledBoard(settled, 300, 3000);
+            if (sensorOccupancy(settled, LOCKED_SENSOR_MAP) == expected) break;
+            Serial.println("❌ Board still differs from the game position");
         }
-        
-        // حفظ الإحداثيات الأصلية قبل الانعكاس
-        int originalFr = fr, originalFc = fc, originalTr = tr, originalTc = tc;
-        
-        bool capture = (prevB[originalTr][originalTc] != '.');
-        Serial.println("🎯 Move: (" + String(fr) + "," + String(fc) + ") -> (" + String(tr) + "," + String(tc) + ")");
-        Serial.println("🎯 Capture: " + String(capture ? "YES" : "NO"));
-
-        // تحويل إحداثيات FEN إلى إحداثيات المحرك الفيزيائية.
-        // الصفوف: FEN row 0 = rank8 (بعيد عن المحرك) → motor row 7، FEN row 7 = rank1 → motor row 0.
-        // الأعمدة: motor col 0 = a-file (يسار أبيض) = نفس FEN col 0 → لا انعكاس للأعمدة.
-        fr = 7 - originalFr;
-        fc = originalFc;
-        tr = 7 - originalTr;
-        tc = originalTc;
-        Serial.println("🔄 After transform: (" + String(fr) + "," + String(fc) + ") -> (" + String(tr) + "," + String(tc) + ")");
-
-        // حساب إحداثيات الشبكة بعد الانعكاس
-        int gFr = fr;
-        int gFc = fc + 1;   // +1 offset for grid
-        int gTr = tr;
-        int gTc = tc + 1;
-
-        if (capture) {
-            bool whiteCap = isupper(prevB[originalTr][originalTc]);
-            int scrapCol = whiteCap ? 0 : 9;
-            Serial.println("🗑️ Capturing piece to scrap column: " + String(scrapCol));
-
-            // 1) RELEASE → move to captured piece
-            moveServoSmooth(SERVO_RELEASE_ANGLE);
-            delay(400); // let servo reach 90° before motors start
-            moveToCell(gTr, gTc);
-            // 2) ENGAGE — servo settle time
-            moveServoSmooth(SERVO_ENGAGE_ANGLE);
-            delay(150);
-            // 3) move to scrap column while ENGAGED
-            moveToCell(gTr, scrapCol);
-            // 4) Tap down to seat piece, then RELEASE
-            moveServoSmooth(SERVO_ENGAGE_ANGLE);
-            delay(80);
-            moveServoSmooth(SERVO_RELEASE_ANGLE);
-            delay(150);
-        }
-
-        // Move active piece
-        Serial.println("🤖 Moving piece from (" + String(gFr) + "," + String(gFc) + ") to (" + String(gTr) + "," + String(gTc) + ")");
-
-        // 1) RELEASE → origin
-        moveServoSmooth(SERVO_RELEASE_ANGLE);
-        delay(400); // let servo reach 90° before motors start
-        moveToCell(gFr, gFc);
-        // 2) ENGAGE — servo settle time
-        moveServoSmooth(SERVO_ENGAGE_ANGLE);
-        delay(150);
-        // 3) move to destination while ENGAGED
-        moveToCell(gTr, gTc);
-        // 4) Tap down to seat piece, then RELEASE — ensures servo always comes down
-        moveServoSmooth(SERVO_ENGAGE_ANGLE);
-        delay(80);
-        moveServoSmooth(SERVO_RELEASE_ANGLE);
-        delay(150);
-        // Safety re-write in case PWM noise corrupted the release
-        myServo.write(constrain(SERVO_RELEASE_ANGLE, 0, 180));
-        Serial.println("✅ Opponent move executed successfully!");
+        digitalWrite(ENABLE_PIN, LOW);
+        currentRow = 0; currentCol = 0;
+        queueMotion(motionServo(SERVO_RELEASE_ANGLE));
     }
 
-    // Scan board 10 times and mark persistently-active EMPTY squares as baseline false-positives.
-    // Squares that have a piece in the current FEN are never marked, so piece rows are unaffected.
+    // Collects raw scans of the board as the current position says it stands and derives every
+    // square's filter thresholds from its error rates. Persistently-active EMPTY squares are
+    // suppressed; squares that have a piece in the position are never suppressed.
     void calibrateEmptyBoard() {
-        Serial.println("🔬 Calibrating empty board baseline...");
-
-        // Build FEN piece map so we skip squares that legitimately have pieces
-        char fenPieces[8][8];
-        fenToBoard(normalizeFenForBoard(currentFen), fenPieces);
-
-        const int SAMPLES = 10;
-        const int THRESHOLD = 8;
-        int counts[8][8] = {};
-        for (int s = 0; s < SAMPLES; s++) {
-            bool tmp[8][8];
-            scanBoardTo(tmp);
-            for (int r = 0; r < 8; r++)
-                for (int c = 0; c < 8; c++)
-                    if (tmp[r][c]) counts[r][c]++;
-            delay(30);
-        }
-
-        int fpCount = 0;
-        for (int sr = 0; sr < 8; sr++) {
-            for (int sc = 0; sc < 8; sc++) {
-                // Map sensor coords → chess coords to look up the FEN
-                int cr = sr, cc = sc;
-                if (LOCKED_SENSOR_MAP == MAP_MIRROR_ROWS || LOCKED_SENSOR_MAP == MAP_MIRROR_BOTH) cr = 7 - sr;
-                if (LOCKED_SENSOR_MAP == MAP_MIRROR_COLS || LOCKED_SENSOR_MAP == MAP_MIRROR_BOTH) cc = 7 - sc;
-                bool fenHasPiece = (fenPieces[cr][cc] != '.');
-                // A square with a real piece can never be a false-positive
-                baselineBoard[sr][sc] = !fenHasPiece && (counts[sr][sc] >= THRESHOLD);
-                if (baselineBoard[sr][sc]) fpCount++;
+        Serial.println("🔬 Calibrating sensor filter...");
+
+        // The game position is the truth the scans are measured against. A piece it has but the
+        // sensors do not see means the board differs (e.g. after a restart mid-game): then the
+        // default thresholds stay. Closed reeds on squares it has empty are what calibration is
+        // for (stuck reeds get suppressed), so they do not count as a mismatch.
+        bool settled[8][8];
+        readSettledBoard(settled, 300, 3000);
+        Bitboard missing = gamePosition.occupiedAll & ~sensorOccupancy(settled, LOCKED_SENSOR_MAP);
+        if (missing) {
+            String squares;
+            for (int sq = 0; sq < 64; sq++) {
+                if (missing & squareBit(sq)) squares += " " + squareToString(sq);
             }
+            Serial.println("⚠️ No piece on" + squares + " as the game position has - calibration skipped, "
+                           "default sensor filter kept");
+            return;
         }
-        Serial.println("✅ Baseline done. False-positive squares: " + String(fpCount));
+
+        const int SCANS = 100; // full scans only, ~2 s at SCAN_SCHEDULER_DEFAULTS.fullScanMs
+        SensorCalibration calibration = SensorCalibration();
+        SensorSnapshot snapshot;
+        readSensorSnapshot(snapshot);
+        uint32_t lastScan = snapshot.scan;
+        while (calibration.samples < SCANS) {
+            delay(1);
+            readSensorSnapshot(snapshot);
+            if (snapshot.scan == lastScan) continue;
+            lastScan = snapshot.scan;
+            if (snapshot.scanned != ALL_SENSOR_SQUARES) continue;
+            sensorCalibrationAdd(calibration, snapshot.raw);
+        }
+
+        bool expected[8][8];
+        positionToSensorBoard(gamePosition, LOCKED_SENSOR_MAP, expected);
+        while (sensorFilterConfigPending.load(std::memory_order_acquire)) delay(1);
+        int fpCount = sensorFilterFromCalibration(calibration, sensorBoardBits(expected), pendingSensorFilterConfig);
+        sensorErrorModelFromCalibration(calibration, sensorBoardBits(expected), pendingSensorFilterConfig, sensorErrors);
+        int noisyCount = 0;
+        for (int sq = 0; sq < 64; sq++) {
+            if (pendingSensorFilterConfig.onScans[sq] > SENSOR_FILTER_DEFAULT_SCANS ||
+                pendingSensorFilterConfig.offScans[sq] > SENSOR_FILTER_DEFAULT_SCANS) noisyCount++;
+        }
+        sensorFilterConfigPending.store(true, std::memory_order_release);
+        Serial.println("✅ Baseline done. False-positive squares: " + String(fpCount) +
+                       " | noisy squares: " + String(noisyCount));
     }
 
-    // Broadcast current sensor state to the frontend via WebSocket
+    // Feeds the latest sensor snapshot to the stream and sends a boardSensorUpdate frame if one is due
     void sendBoardSensorUpdate() {
-        static uint8_t prevRows[8] = {0}; // last broadcast (raw, before de-ghosting)
         static unsigned long lastDebugPrint = 0;
 
+        SensorSnapshot snapshot;
+        readSensorSnapshot(snapshot);
         bool sensorBoard[8][8];
-        scanBoardTo(sensorBoard);
+        sensorBoardFromBits(snapshot.occupancy, sensorBoard);
 
         // DEBUG: print sensor state every 5 seconds
         unsigned long nowDbg = millis();
@@ -1754,44 +1727,16 @@
             }
         }
 
-        // Convert sensor → chess coordinates (inverse of LOCKED_SENSOR_MAP).
-        // rows[r]: r=0 → rank 1.  bit c: c=0 → file a.
-        uint8_t rows[8] = {0};
-        for (int sr = 0; sr < 8; sr++) {
-            for (int sc = 0; sc < 8; sc++) {
-                if (!sensorBoard[sr][sc]) continue;
-                int cr = sr, cc = sc;
-                if (LOCKED_SENSOR_MAP == MAP_MIRROR_ROWS || LOCKED_SENSOR_MAP == MAP_MIRROR_BOTH) cr = 7 - sr;
-                if (LOCKED_SENSOR_MAP == MAP_MIRROR_COLS || LOCKED_SENSOR_MAP == MAP_MIRROR_BOTH) cc = 7 - sc;
-                rows[cr] |= (1u << cc);
-            }
-        }
-
-        // Smart de-ghosting:
-        // • If any new square just appeared (piece placed somewhere new) → use raw reading.
-        //   This immediately clears the ghost of where the piece came from, once the reed
-        //   switch at the origin opens.
-        // • If no new squares appeared (stable state or piece still in transit) → apply
-        //   1-frame persistence so brief reed-switch bounces during lift don't cause flicker.
-        bool anyNew = false;
-        for (int i = 0; i < 8; i++) {
-            if (rows[i] & ~prevRows[i]) { anyNew = true; break; }
-        }
+        // Coalescing replaces the old per-frame de-ghosting: a lift's intermediate readings and
+        // reed bounces settle before anything is sent, so the origin square never flickers.
+        SensorFrame update = sensorStreamUpdate(sensorStream, sensorOccupancy(sensorBoard, LOCKED_SENSOR_MAP),
+                                                snapshot.scannedAtMs);
+        if (update.kind == SENSOR_FRAME_NONE) return;
 
-        uint8_t sent[8];
-        for (int i = 0; i < 8; i++) {
-            sent[i] = anyNew ? rows[i]                // new arrival: show only current reading
-                             : (rows[i] | prevRows[i]); // stable: persist 1 extra frame (anti-flicker)
-        }
-        memcpy(prevRows, rows, sizeof(rows));
-
-        String payload = "{\"rows\":[";
-        for (int i = 0; i < 8; i++) {
-            if (i > 0) payload += ",";
-            payload += String(sent[i]);
-        }
-        payload += "]}";
-        webSocket.sendTXT("42/friends,[\"boardSensorUpdate\"," + payload + "]");
+        char frame[SENSOR_FRAME_MAX];
+        size_t frameLen = writeSensorFrame(update.occupancy, update.seq, update.kind == SENSOR_FRAME_KEYFRAME,
+                                           frame, sizeof(frame));
+        if (frameLen) webSocket.sendTXT(frame, frameLen);
     }
 
     // دالة فحص حالة اللعبة
@@ -1806,24 +1751,13 @@
         int httpCode = http.GET();
         
         if (httpCode == HTTP_CODE_OK) {
-            String payload = http.getString();
-            DynamicJsonDocument doc(2048);
-            DeserializationError error = deserializeJson(doc, payload);
-            
-            if (!error && doc["success"] == true) {
-                String gameStatus = doc["data"]["status"].as<String>();
+            StaticJsonDocument<RESPONSE_DOC_SIZE> doc;
+            if (readServerResponse(http, gameFilter, doc)) {
+                bool ended = strcmp(doc["data"]["status"] | "", "ended") == 0;
                 http.end();
                 
-                if (gameStatus == "ended") {
-                    // أي لعبة منتهية => دخول وضع انتظار لعبة جديدة بدون الحاجة لإعادة تشغيل ESP.
-                    if (!isFetchingNewGame) {
-                        Serial.println("🏁 Game ended - returning motors to home position");
-                        returnMotorsToHome();
-                        lastEndedGameId = gameId;
-                        isFetchingNewGame = true;
-                        lastNewGamePoll = 0;
-                        Serial.println("⏳ Waiting for a new active game...");
-                    }
+                if (ended) {
+                    enterWaitingForNewGame();
                     return true;
                 }
             }
@@ -1832,24 +1766,86 @@
         return false;
     }
 
+    // أي لعبة منتهية => دخول وضع انتظار لعبة جديدة بدون الحاجة لإعادة تشغيل ESP.
+    // Reached from the status poll or a gameEnd / gameTimeout event.
+    void enterWaitingForNewGame() {
+        if (isFetchingNewGame) return;
+        Serial.println("🏁 Game ended - setting the board up for the next one");
+        Position startPos;
+        positionFromFen(startPos, "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+        setupBoardTo(startPos);
+        returnMotorsToHome();
+        lastEndedGameId = gameId;
+        isFetchingNewGame = true;
+        lastNewGamePoll = 0;
+        Serial.println("⏳ Waiting for a new active game...");
+    }
+
     // دالة إعادة الموتورات للموقع 0,0
     void returnMotorsToHome() {
         Serial.println("🏠 Returning motors to home position (0,0)");
 
-        // Raise servo fully before travel so it doesn't drag over pieces
-        moveServoSmooth(SERVO_RELEASE_ANGLE);
-        delay(150);
+        // Raise servo before travel so it doesn't drag over pieces
+        MotionCommand servo[PICK_PLACE_MAX_COMMANDS];
+        queuePickPlace(servo, pickPlaceRaise(pickPlace, servo));
 
         // Move to home position (0,0)
         moveToCell(0, 0);
 
         // Keep servo raised at home
-        moveServoSmooth(SERVO_RELEASE_ANGLE);
+        queueMotion(motionServo(SERVO_RELEASE_ANGLE));
 
-        Serial.println("✅ Motors returned to home position");
+        Serial.println("✅ Return to home position queued");
         blinkLED(5); // إشارة بصرية أن اللعبة انتهت
     }
 
+    // ترتيب الرقعة على وضعية الهدف (بداية اللعبة أو أي FEN) من الوضعية الحالية: planBoardSetup
+    // يختار أي قطعة تذهب إلى أي مربع وبأي ترتيب، والقطع الزائدة تذهب إلى عمود الخردة.
+    // Blocks until the carriage is done. The graveyard's pieces count (and end up in it again if the
+    // target has no room for them); pieces taken off by hand are reported for hand placement.
+    bool setupBoardTo(const Position &target) {
+        while (motionBusy()) {
+            webSocket.loop();
+            delay(5);
+        }
+        bool settled[8][8];
+        readSettledBoard(settled, SENSOR_QUIET_MS, SENSOR_SETTLE_TIMEOUT_MS);
+        if (sensorOccupancy(settled, LOCKED_SENSOR_MAP) != gamePosition.occupiedAll) {
+            Serial.println("❌ Board does not match the game position - setup skipped");
+            return false;
+        }
+        SetupCells cells;
+        setupCellsFromPosition(gamePosition, cells);
+        setupCellsAddGraveyard(graveyard, cells);
+        static SetupPlan plan;
+        if (!planBoardSetup(carriage, motionProfiles.limits[MOTION_LOAD_LIGHT], cells, target, currentRow, currentCol, plan)) {
+            Serial.println("❌ No room to set the board up - setup skipped");
+            return false;
+        }
+        Serial.printf("🧩 Board setup: %d moves, about %.0f s\n", plan.count, plan.seconds);
+        for (int i = 0; i < plan.count; i++) {
+            const SetupStep &step = plan.steps[i];
+            cells.piece[step.from] = NO_PIECE; // القطعة المحمولة ليست عائقاً
+            setupObstacles(cells, carriageObstacles);
+            cells.piece[step.from] = step.piece;
+            carryPiece(setupCellRow(step.from), setupCellCol(step.from), setupCellRow(step.to), setupCellCol(step.to),
+                       motionLoadOf(step.piece));
+            setupApply(cells, step);
+        }
+        setupGraveyard(cells, graveyard);
+        for (uint8_t piece = 0; piece < NO_PIECE; piece++) {
+            for (int k = 0; k < plan.missing[piece]; k++) {
+                Serial.println("🖐️ Missing " + String(pieceChar(piece)) + " - place it by hand");
+            }
+        }
+        while (motionBusy()) {
+            webSocket.loop();
+            delay(5);
+        }
+        Serial.println("✅ Board setup done");
+        return true;
+    }
+
     // يستدعي API ليجلب آخر gameId نشطة للمستخدم userId
     bool fetchLastActiveGame() {
         HTTPClient http;
@@ -1858,10 +1854,8 @@
         http.addHeader("Authorization", "Bearer " + userToken);
         int code = http.GET();
         if (code == HTTP_CODE_OK) {
-            String payload = http.getString();
-            DynamicJsonDocument doc(1024);
-            if (deserializeJson(doc, payload)==DeserializationError::Ok
-                && doc["success"] == true) {
+            StaticJsonDocument<RESPONSE_DOC_SIZE> doc;
+            if (readServerResponse(http, activeGameFilter, doc)) {
                 JsonVariant data = doc["data"];
                 if (data.isNull()) {
                     http.end();
@@ -1891,50 +1885,3 @@
         http.end();
         return false;
     }
-
-    // دالة معالجة الـ capture
-    void handleCapture(int r, int c) {
-        Serial.println("🎯 Handling capture at: (" + String(r) + "," + String(c) + ")");
-        
-        // اقرأ القطعة من FEN
-        char board8[8][8];
-        fenToBoard(protectedOldFen, board8);
-        char capturedPiece = board8[r][c]; // r و c الآن من FEN مباشرة
-        
-        // تحديد عمود الخردة حسب لون القطعة
-        int scrapCol = isWhitePiece(capturedPiece) ? 0 : 9;
-        
-        Serial.println("🔍 Captured piece: " + String(capturedPiece) + " -> scrap column: " + String(scrapCol));
-        
-        // تحويل إحداثيات FEN إلى إحداثيات الحساسات (قلب الصفوف)
-        int sensorRow = 7 - r; // FEN row=0 (rank8) -> sensor row=7
-        int sensorCol = c;
-        
-        // 1) ارفع القطعة المأخوذة
-        moveServoSmooth(SERVO_RELEASE_HOME_ANGLE); // RELEASE
-        moveToCell(sensorRow, sensorCol + 1); // +1 offset for grid
-        moveServoSmooth(SERVO_ENGAGE_ANGLE); // ENGAGE — wait for servo to reach down
-        delay(200);
-
-        // 2) ارميها في scrap
-        moveToCell(sensorRow, scrapCol);
-        moveServoSmooth(SERVO_RELEASE_HOME_ANGLE); // RELEASE
-        delay(150);
-        
-        Serial.println("✅ Capture handled successfully!");
-    }// Returns (r,c) of any removed piece between prevFen and currentFen, or (-1,-1) if none.
-    std::pair<int,int> findCaptureFromFen(const String& prevFen, const String& currentFen) {
-        char prevB[8][8], curB[8][8];
-        parseFen(prevFen, prevB);
-        parseFen(currentFen, curB);
-
-        for (int r = 0; r < 8; ++r) {
-            for (int c = 0; c < 8; ++c) {
-                if (prevB[r][c] != '.' && curB[r][c] == '.') {
-                    return {r, c};
-                }
-            }
-        }
-        return {-1, -1};
-    }
-
@@ -0,0 +1,79 @@
+#include "chess_move_table.h"
+#include <algorithm>
+
+namespace {
+
+const uint32_t NO_SIGNATURE = 0xFFFFFFFFu;
+
+// Up to two squares of a bitboard as two 7-bit fields (square + 1, 0 = none), lowest square first.
+bool packSquares(Bitboard bb, uint32_t &packed) {
+    packed = 0;
+    for (int i = 0; bb; i++) {
+        if (i == 2) return false;
+        packed |= uint32_t(__builtin_ctzll(bb) + 1) << (7 * i);
+        bb &= bb - 1;
+    }
+    return true;
+}
+
+bool keyLess(const MoveSignature &a, const MoveSignature &b) { return a.key < b.key; }
+
+} // namespace
+
+uint32_t moveSignatureKey(Bitboard removed, Bitboard added) {
+    uint32_t rem, add;
+    if (!packSquares(removed, rem) || !packSquares(added, add)) return NO_SIGNATURE;
+    return rem | (add << 14);
+}
+
+void buildMoveSignatureTable(const Position &pos, uint8_t sensorMask, MoveSignatureTable &table) {
+    MoveList list;
+    generateLegalMoves(pos, list);
+
+    table.count = 0;
+    for (int i = 0; i < list.count; i++) {
+        Move m = list.moves[i];
+        if (moveIsPromotion(m) && movePromotionType(m) != QUEEN) continue;
+
+        int from = moveFrom(m), to = moveTo(m);
+        Bitboard removed = squareBit(chessToSensorSquare(from, sensorMask));
+        Bitboard added = 0;
+        uint8_t flags = moveFlags(m);
+        if (flags == MF_KING_CASTLE || flags == MF_QUEEN_CASTLE) {
+            int rookFrom = flags == MF_KING_CASTLE ? to + 1 : to - 2;
+            int rookTo = flags == MF_KING_CASTLE ? to - 1 : to + 1;
+            removed |= squareBit(chessToSensorSquare(rookFrom, sensorMask));
+            added = squareBit(chessToSensorSquare(to, sensorMask)) | squareBit(chessToSensorSquare(rookTo, sensorMask));
+        } else if (flags == MF_EP_CAPTURE) {
+            int capSq = squareOf(squareRow(from), squareCol(to));
+            removed |= squareBit(chessToSensorSquare(capSq, sensorMask));
+            added = squareBit(chessToSensorSquare(to, sensorMask));
+        } else if (!moveIsCapture(m)) {
+            added = squareBit(chessToSensorSquare(to, sensorMask));
+        }
+
+        MoveSignature &entry = table.entries[table.count++];
+        entry.key = moveSignatureKey(removed, added);
+        entry.move = m;
+    }
+    std::sort(table.entries, table.entries + table.count, keyLess);
+}
+
+int lookupMoveSignature(const MoveSignatureTable &table, Bitboard removed, Bitboard added, const MoveSignature **first) {
+    MoveSignature probe;
+    probe.key = moveSignatureKey(removed, added);
+    probe.move = MOVE_NONE;
+    const MoveSignature *begin = table.entries, *end = table.entries + table.count;
+    std::pair<const MoveSignature *, const MoveSignature *> range = std::equal_range(begin, end, probe, keyLess);
+    if (first) *first = range.first;
+    return probe.key == NO_SIGNATURE ? 0 : int(range.second - range.first);
+}
+
+Bitboard moveSignatureSquares(const MoveSignature &entry, uint8_t sensorMask) {
+    Bitboard squares = squareBit(chessToSensorSquare(moveTo(entry.move), sensorMask));
+    for (int field = 0; field < 4; field++) {
+        uint32_t packed = (entry.key >> (7 * field)) & 0x7F;
+        if (packed) squares |= squareBit(int(packed) - 1);
+    }
+    return squares;
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+// Legal moves indexed by the reed-sensor change they produce.
+// Reed switches only see occupancy, so a move is identified by the squares that empty
+// (removed) and fill (added) when it is played:
+//   quiet / promotion      removed {from}            added {to}
+//   capture                removed {from}            added {}        (to stays occupied)
+//   en passant             removed {from, captured}  added {to}
+//   castling               removed {king, rook}      added {king, rook}
+// The table is built once per position; resolving a scan is a binary search.
+
+#include "chess_position.h"
+#include "chess_movegen.h"
+
+// Sensor square for a chess square is (chessSq ^ mask): 0 = identity, 56 = rows mirrored,
+// 7 = columns mirrored, 63 = both. The mirrors are self-inverse, so the same mask maps back.
+inline int chessToSensorSquare(int sq, uint8_t sensorMask) { return sq ^ sensorMask; }
+
+struct MoveSignature {
+    uint32_t key;
+    Move move;
+};
+
+struct MoveSignatureTable {
+    MoveSignature entries[MAX_MOVES];
+    int count;
+};
+
+// Key for a sensor delta; removed / added are sensor-coordinate bitboards.
+// Deltas with more than two removed or two added squares get a key no move has.
+uint32_t moveSignatureKey(Bitboard removed, Bitboard added);
+
+// Enumerates the legal moves of pos and sorts them by signature. Underpromotions are skipped:
+// the board always promotes to a queen, and they would only duplicate the queen's signature.
+void buildMoveSignatureTable(const Position &pos, uint8_t sensorMask, MoveSignatureTable &table);
+
+// Number of legal moves matching the delta; *first points at the first of them (entries are contiguous).
+// More than one match means the delta alone cannot tell the moves apart (same piece, several captures).
+int lookupMoveSignature(const MoveSignatureTable &table, Bitboard removed, Bitboard added, const MoveSignature **first);
+
+// Sensor squares the entry's move touches: its whole delta plus the square it captures on
+// (a capture leaves that square occupied, so it is not part of the delta).
+Bitboard moveSignatureSquares(const MoveSignature &entry, uint8_t sensorMask);
@@ -0,0 +1,178 @@
+#include "chess_movegen.h"
+#include <string.h>
+
+namespace {
+
+inline int popLsb(Bitboard &bb) {
+    int sq = __builtin_ctzll(bb);
+    bb &= bb - 1;
+    return sq;
+}
+
+void addMove(MoveList &list, int from, int to, uint8_t flags) {
+    if (list.count < MAX_MOVES) list.moves[list.count++] = encodeMove(from, to, flags);
+}
+
+void addPawnMoves(MoveList &list, int from, int to, bool capture) {
+    int toRow = squareRow(to);
+    if (toRow == 0 || toRow == 7) {
+        uint8_t base = capture ? MF_PROMO_CAPTURE : MF_PROMO;
+        for (int t = QUEEN; t >= KNIGHT; t--) addMove(list, from, to, uint8_t(base + (t - KNIGHT)));
+    } else {
+        addMove(list, from, to, capture ? MF_CAPTURE : MF_QUIET);
+    }
+}
+
+void addTargets(MoveList &list, const Position &pos, int from, Bitboard targets) {
+    while (targets) {
+        int to = popLsb(targets);
+        addMove(list, from, to, (pos.occupiedAll & squareBit(to)) ? MF_CAPTURE : MF_QUIET);
+    }
+}
+
+// Every move that obeys piece movement rules; moves leaving the own king in check are filtered later.
+void generatePseudoLegal(const Position &pos, MoveList &list) {
+    uint8_t us = pos.sideToMove, them = uint8_t(us ^ 1);
+    Bitboard own = pos.occupied[us];
+    Bitboard enemy = pos.occupied[them];
+    Bitboard empty = ~pos.occupiedAll;
+    int forward = us == PIECE_WHITE ? 8 : -8;
+    int startRow = us == PIECE_WHITE ? 1 : 6;
+
+    Bitboard pawns = pos.pieces[us][PAWN];
+    while (pawns) {
+        int from = popLsb(pawns);
+        int one = from + forward;
+        if (empty & squareBit(one)) {
+            addPawnMoves(list, from, one, false);
+            int two = one + forward;
+            if (squareRow(from) == startRow && (empty & squareBit(two))) addMove(list, from, two, MF_DOUBLE_PUSH);
+        }
+        Bitboard captures = pawnAttacks(us, from) & enemy;
+        while (captures) addPawnMoves(list, from, popLsb(captures), true);
+        if (pos.epSquare != NO_SQUARE && (pawnAttacks(us, from) & squareBit(pos.epSquare))) {
+            addMove(list, from, pos.epSquare, MF_EP_CAPTURE);
+        }
+    }
+
+    Bitboard knights = pos.pieces[us][KNIGHT];
+    while (knights) {
+        int from = popLsb(knights);
+        addTargets(list, pos, from, knightAttacks(from) & ~own);
+    }
+
+    Bitboard diagonals = pos.pieces[us][BISHOP] | pos.pieces[us][QUEEN];
+    while (diagonals) {
+        int from = popLsb(diagonals);
+        addTargets(list, pos, from, bishopAttacks(from, pos.occupiedAll) & ~own);
+    }
+
+    Bitboard straights = pos.pieces[us][ROOK] | pos.pieces[us][QUEEN];
+    while (straights) {
+        int from = popLsb(straights);
+        addTargets(list, pos, from, rookAttacks(from, pos.occupiedAll) & ~own);
+    }
+
+    Bitboard kings = pos.pieces[us][KING];
+    if (!kings) return;
+    int king = __builtin_ctzll(kings);
+    addTargets(list, pos, king, kingAttacks(king) & ~own);
+
+    // Castling: rights, empty path, king not in check and not passing through an attacked square.
+    int homeRow = us == PIECE_WHITE ? 0 : 7;
+    if (king != squareOf(homeRow, 4) || isSquareAttacked(pos, king, them)) return;
+    uint8_t kingSide = us == PIECE_WHITE ? CASTLE_WHITE_KING : CASTLE_BLACK_KING;
+    uint8_t queenSide = us == PIECE_WHITE ? CASTLE_WHITE_QUEEN : CASTLE_BLACK_QUEEN;
+    Bitboard rooks = pos.pieces[us][ROOK];
+    if ((pos.castling & kingSide) && (rooks & squareBit(king + 3)) &&
+        !(pos.occupiedAll & (squareBit(king + 1) | squareBit(king + 2))) &&
+        !isSquareAttacked(pos, king + 1, them) && !isSquareAttacked(pos, king + 2, them)) {
+        addMove(list, king, king + 2, MF_KING_CASTLE);
+    }
+    if ((pos.castling & queenSide) && (rooks & squareBit(king - 4)) &&
+        !(pos.occupiedAll & (squareBit(king - 1) | squareBit(king - 2) | squareBit(king - 3))) &&
+        !isSquareAttacked(pos, king - 1, them) && !isSquareAttacked(pos, king - 2, them)) {
+        addMove(list, king, king - 2, MF_QUEEN_CASTLE);
+    }
+}
+
+bool leavesKingSafe(Position &pos, Move m) {
+    uint8_t us = pos.sideToMove;
+    UndoInfo undo;
+    makeMove(pos, m, undo);
+    Bitboard kings = pos.pieces[us][KING];
+    bool safe = !kings || !isSquareAttacked(pos, __builtin_ctzll(kings), uint8_t(us ^ 1));
+    unmakeMove(pos, m, undo);
+    return safe;
+}
+
+} // namespace
+
+bool isSquareAttacked(const Position &pos, int sq, uint8_t byColor) {
+    const Bitboard *p = pos.pieces[byColor];
+    if (pawnAttacks(uint8_t(byColor ^ 1), sq) & p[PAWN]) return true;
+    if (knightAttacks(sq) & p[KNIGHT]) return true;
+    if (kingAttacks(sq) & p[KING]) return true;
+    if (bishopAttacks(sq, pos.occupiedAll) & (p[BISHOP] | p[QUEEN])) return true;
+    if (rookAttacks(sq, pos.occupiedAll) & (p[ROOK] | p[QUEEN])) return true;
+    return false;
+}
+
+bool inCheck(const Position &pos) {
+    Bitboard kings = pos.pieces[pos.sideToMove][KING];
+    return kings && isSquareAttacked(pos, __builtin_ctzll(kings), uint8_t(pos.sideToMove ^ 1));
+}
+
+void generateLegalMoves(const Position &pos, MoveList &list) {
+    MoveList pseudo;
+    pseudo.count = 0;
+    generatePseudoLegal(pos, pseudo);
+
+    Position scratch = pos;
+    list.count = 0;
+    for (int i = 0; i < pseudo.count; i++) {
+        if (leavesKingSafe(scratch, pseudo.moves[i])) list.moves[list.count++] = pseudo.moves[i];
+    }
+}
+
+Move findLegalMove(const Position &pos, int from, int to, uint8_t promoType) {
+    MoveList list;
+    generateLegalMoves(pos, list);
+    Move found = MOVE_NONE;
+    for (int i = 0; i < list.count; i++) {
+        Move m = list.moves[i];
+        if (moveFrom(m) != from || moveTo(m) != to) continue;
+        if (!moveIsPromotion(m) || movePromotionType(m) == promoType) return m;
+        if (found == MOVE_NONE) found = m;
+    }
+    return found;
+}
+
+Move findMoveBetween(const Position &prev, const Position &next) {
+    MoveList list;
+    generateLegalMoves(prev, list);
+    Position scratch = prev;
+    for (int i = 0; i < list.count; i++) {
+        UndoInfo undo;
+        makeMove(scratch, list.moves[i], undo);
+        bool same = memcmp(scratch.pieces, next.pieces, sizeof(scratch.pieces)) == 0;
+        unmakeMove(scratch, list.moves[i], undo);
+        if (same) return list.moves[i];
+    }
+    return MOVE_NONE;
+}
+
+uint64_t perft(Position &pos, int depth) {
+    MoveList list;
+    generateLegalMoves(pos, list);
+    if (depth <= 1) return depth == 1 ? uint64_t(list.count) : 1;
+
+    uint64_t nodes = 0;
+    for (int i = 0; i < list.count; i++) {
+        UndoInfo undo;
+        makeMove(pos, list.moves[i], undo);
+        nodes += perft(pos, depth - 1);
+        unmakeMove(pos, list.moves[i], undo);
+    }
+    return nodes;
+}
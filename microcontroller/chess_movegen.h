@@ -0,0 +1,31 @@
+#pragma once
+
+// Legal move generation on top of the bitboard Position (chess_position.h).
+// Handles check, pins, castling, en passant and all four promotions.
+
+#include "chess_position.h"
+#include "chess_attacks.h"
+
+const int MAX_MOVES = 256;
+
+struct MoveList {
+    Move moves[MAX_MOVES];
+    int count;
+};
+
+// True if any piece of byColor attacks sq in pos.
+bool isSquareAttacked(const Position &pos, int sq, uint8_t byColor);
+// True if the side to move is in check.
+bool inCheck(const Position &pos);
+
+// Fills list with every legal move for the side to move.
+void generateLegalMoves(const Position &pos, MoveList &list);
+
+// Legal move from -> to, or MOVE_NONE. promoType picks the piece when several promotions match.
+Move findLegalMove(const Position &pos, int from, int to, uint8_t promoType = QUEEN);
+
+// The legal move that turns prev into next (compared by piece placement), or MOVE_NONE.
+Move findMoveBetween(const Position &prev, const Position &next);
+
+// Leaf-node count to the given depth (move-generator correctness and speed check).
+uint64_t perft(Position &pos, int depth);
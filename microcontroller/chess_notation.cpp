@@ -0,0 +1,127 @@
+#include "chess_notation.h"
+#include "chess_movegen.h"
+#include <string.h>
+
+namespace {
+
+const char PROMO_LETTERS[] = "nbrq"; // indexed by promotion type - KNIGHT
+
+// SAN without the check suffix; list holds every legal move of pos. buf needs SAN_MAX_LEN bytes.
+size_t sanBody(const Position &pos, Move m, const MoveList &list, char *buf) {
+    int from = moveFrom(m), to = moveTo(m);
+    size_t n = 0;
+
+    if (moveIsCastle(m)) {
+        const char *text = moveFlags(m) == MF_KING_CASTLE ? "O-O" : "O-O-O";
+        n = strlen(text);
+        memcpy(buf, text, n);
+        buf[n] = '\0';
+        return n;
+    }
+
+    uint8_t code = pos.board[from];
+    uint8_t type = pieceTypeOf(code);
+    if (type == PAWN) {
+        if (moveIsCapture(m)) {
+            buf[n++] = char('a' + squareCol(from));
+            buf[n++] = 'x';
+        }
+    } else {
+        buf[n++] = pieceChar(pieceCode(PIECE_WHITE, type));
+        bool ambiguous = false, sameFile = false, sameRank = false;
+        for (int i = 0; i < list.count && type != KING; i++) {
+            Move other = list.moves[i];
+            int otherFrom = moveFrom(other);
+            if (moveTo(other) != to || otherFrom == from || pos.board[otherFrom] != code) continue;
+            ambiguous = true;
+            if (squareCol(otherFrom) == squareCol(from)) sameFile = true;
+            if (squareRow(otherFrom) == squareRow(from)) sameRank = true;
+        }
+        if (ambiguous && (!sameFile || sameRank)) buf[n++] = char('a' + squareCol(from));
+        if (ambiguous && sameFile) buf[n++] = char('1' + squareRow(from));
+        if (moveIsCapture(m)) buf[n++] = 'x';
+    }
+
+    squareName(to, &buf[n]);
+    n += 2;
+    if (moveIsPromotion(m)) {
+        buf[n++] = '=';
+        buf[n++] = char(PROMO_LETTERS[movePromotionType(m) - KNIGHT] - 'a' + 'A');
+    }
+    buf[n] = '\0';
+    return n;
+}
+
+} // namespace
+
+size_t moveToUci(Move m, char *out, size_t outSize) {
+    char buf[UCI_MAX_LEN];
+    squareName(moveFrom(m), buf);
+    squareName(moveTo(m), buf + 2);
+    size_t n = 4;
+    if (moveIsPromotion(m)) buf[n++] = PROMO_LETTERS[movePromotionType(m) - KNIGHT];
+
+    if (n + 1 > outSize) return 0;
+    memcpy(out, buf, n);
+    out[n] = '\0';
+    return n;
+}
+
+Move moveFromUci(const Position &pos, const char *text) {
+    if (!text || strlen(text) < 4) return MOVE_NONE;
+    int from = parseSquare(text);
+    int to = parseSquare(text + 2);
+    if (from == NO_SQUARE || to == NO_SQUARE) return MOVE_NONE;
+
+    uint8_t promoType = QUEEN;
+    if (text[4]) {
+        const char *letter = strchr(PROMO_LETTERS, text[4] | 0x20);
+        if (!letter || text[5]) return MOVE_NONE;
+        promoType = uint8_t(KNIGHT + (letter - PROMO_LETTERS));
+    }
+    Move m = findLegalMove(pos, from, to, promoType);
+    if (m != MOVE_NONE && moveIsPromotion(m) && movePromotionType(m) != promoType) return MOVE_NONE;
+    return m;
+}
+
+size_t moveToSan(const Position &pos, Move m, char *out, size_t outSize) {
+    MoveList list;
+    generateLegalMoves(pos, list);
+    char buf[SAN_MAX_LEN];
+    size_t n = sanBody(pos, m, list, buf);
+
+    Position next = pos;
+    UndoInfo undo;
+    makeMove(next, m, undo);
+    if (inCheck(next)) {
+        MoveList replies;
+        generateLegalMoves(next, replies);
+        buf[n++] = replies.count ? '+' : '#';
+    }
+
+    if (n + 1 > outSize) return 0;
+    memcpy(out, buf, n);
+    out[n] = '\0';
+    return n;
+}
+
+Move moveFromSan(const Position &pos, const char *text) {
+    if (!text) return MOVE_NONE;
+    char wanted[SAN_MAX_LEN];
+    size_t n = 0;
+    for (; text[n] && !strchr("+#!?", text[n]); n++) {
+        if (n + 1 >= sizeof(wanted)) return MOVE_NONE;
+        wanted[n] = text[n] == '0' ? 'O' : text[n];
+    }
+    wanted[n] = '\0';
+    if (!n) return MOVE_NONE;
+
+    MoveList list;
+    generateLegalMoves(pos, list);
+    char san[SAN_MAX_LEN];
+    for (int i = 0; i < list.count; i++) {
+        sanBody(pos, list.moves[i], list, san);
+        if (strcmp(san, wanted) == 0) return list.moves[i];
+    }
+    return MOVE_NONE;
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+// Move text codec (UCI "e7e8q" and SAN "exd8=Q+") for the board firmware.
+// Encoders write into caller buffers and decoders read plain C strings — nothing here allocates,
+// so FEN / move text can be rebuilt on every move without fragmenting the ESP32 heap.
+// FEN itself is positionFromFen / positionToFen in chess_position.h.
+
+#include "chess_position.h"
+
+const size_t UCI_MAX_LEN = 6; // "e7e8q" + terminator
+const size_t SAN_MAX_LEN = 8; // "Qa1xb2+" / "exd8=Q#" + terminator
+
+// Writes m as UCI; returns the length written or 0 if outSize is too small.
+size_t moveToUci(Move m, char *out, size_t outSize);
+// Legal move matching the UCI text in pos, or MOVE_NONE. A missing promotion letter means queen.
+Move moveFromUci(const Position &pos, const char *text);
+
+// Writes m (legal in pos) as SAN with minimal disambiguation and a +/# suffix;
+// returns the length written or 0 if outSize is too small.
+size_t moveToSan(const Position &pos, Move m, char *out, size_t outSize);
+// Legal move matching the SAN text in pos, or MOVE_NONE. Check marks and annotations
+// (+ # ! ?) are optional and "0-0" is accepted for "O-O".
+Move moveFromSan(const Position &pos, const char *text);
@@ -0,0 +1,382 @@
+#include "chess_position.h"
+#include "chess_attacks.h"
+#include <string.h>
+
+namespace {
+
+const char PIECE_LETTERS[] = "PNBRQKpnbrqk";
+
+// Zobrist keys are splitmix64 of the key index, so the server can derive the same table
+// (server/src/utils/zobrist.js). Layout: piece code * 64 + square, castling rights, en-passant file, black to move.
+const int ZOBRIST_CASTLING = 768;
+const int ZOBRIST_EP_FILE = 784;
+const int ZOBRIST_BLACK_TO_MOVE = 792;
+
+constexpr uint64_t splitmixFinal(uint64_t z) { return z ^ (z >> 31); }
+constexpr uint64_t splitmixMix2(uint64_t z) { return splitmixFinal((z ^ (z >> 27)) * 0x94D049BB133111EBULL); }
+constexpr uint64_t splitmixMix1(uint64_t z) { return splitmixMix2((z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL); }
+constexpr uint64_t zobristKey(int index) { return splitmixMix1((uint64_t(index) + 1) * 0x9E3779B97F4A7C15ULL); }
+
+#define ZOBRIST_ROW8(base) zobristKey(base + 0), zobristKey(base + 1), zobristKey(base + 2), zobristKey(base + 3), \
+                           zobristKey(base + 4), zobristKey(base + 5), zobristKey(base + 6), zobristKey(base + 7)
+#define ZOBRIST_BLOCK64(base) ZOBRIST_ROW8(base), ZOBRIST_ROW8(base + 8), ZOBRIST_ROW8(base + 16), ZOBRIST_ROW8(base + 24), \
+                              ZOBRIST_ROW8(base + 32), ZOBRIST_ROW8(base + 40), ZOBRIST_ROW8(base + 48), ZOBRIST_ROW8(base + 56)
+
+constexpr uint64_t ZOBRIST_KEYS[ZOBRIST_BLACK_TO_MOVE + 1] = {
+    ZOBRIST_BLOCK64(0), ZOBRIST_BLOCK64(64), ZOBRIST_BLOCK64(128), ZOBRIST_BLOCK64(192),
+    ZOBRIST_BLOCK64(256), ZOBRIST_BLOCK64(320), ZOBRIST_BLOCK64(384), ZOBRIST_BLOCK64(448),
+    ZOBRIST_BLOCK64(512), ZOBRIST_BLOCK64(576), ZOBRIST_BLOCK64(640), ZOBRIST_BLOCK64(704),
+    ZOBRIST_ROW8(ZOBRIST_CASTLING), ZOBRIST_ROW8(ZOBRIST_CASTLING + 8), ZOBRIST_ROW8(ZOBRIST_EP_FILE),
+    zobristKey(ZOBRIST_BLACK_TO_MOVE)
+};
+
+#undef ZOBRIST_BLOCK64
+#undef ZOBRIST_ROW8
+
+inline uint64_t pieceKey(uint8_t code, int sq) { return ZOBRIST_KEYS[code * 64 + sq]; }
+inline uint64_t castlingKey(uint8_t rights) { return ZOBRIST_KEYS[ZOBRIST_CASTLING + rights]; }
+
+// En-passant key only while a pawn of the side to move stands next to the target square.
+uint64_t epKey(const Position &pos) {
+    if (pos.epSquare == NO_SQUARE) return 0;
+    uint8_t us = pos.sideToMove;
+    if (!(pawnAttacks(uint8_t(us ^ 1), pos.epSquare) & pos.pieces[us][PAWN])) return 0;
+    return ZOBRIST_KEYS[ZOBRIST_EP_FILE + squareCol(pos.epSquare)];
+}
+
+// Castling rights that survive a move touching each square (king / rook home squares clear bits).
+uint8_t castlingMaskFor(int sq) {
+    switch (sq) {
+        case 0:  return uint8_t(~CASTLE_WHITE_QUEEN);                      // a1
+        case 4:  return uint8_t(~(CASTLE_WHITE_KING | CASTLE_WHITE_QUEEN)); // e1
+        case 7:  return uint8_t(~CASTLE_WHITE_KING);                       // h1
+        case 56: return uint8_t(~CASTLE_BLACK_QUEEN);                      // a8
+        case 60: return uint8_t(~(CASTLE_BLACK_KING | CASTLE_BLACK_QUEEN)); // e8
+        case 63: return uint8_t(~CASTLE_BLACK_KING);                       // h8
+        default: return 0xFF;
+    }
+}
+
+void putPiece(Position &pos, int sq, uint8_t code) {
+    Bitboard bit = squareBit(sq);
+    uint8_t color = pieceColor(code);
+    pos.pieces[color][pieceTypeOf(code)] |= bit;
+    pos.occupied[color] |= bit;
+    pos.occupiedAll |= bit;
+    pos.board[sq] = code;
+    pos.hash ^= pieceKey(code, sq);
+}
+
+void removePiece(Position &pos, int sq) {
+    uint8_t code = pos.board[sq];
+    if (code == NO_PIECE) return;
+    Bitboard bit = squareBit(sq);
+    uint8_t color = pieceColor(code);
+    pos.pieces[color][pieceTypeOf(code)] &= ~bit;
+    pos.occupied[color] &= ~bit;
+    pos.occupiedAll &= ~bit;
+    pos.board[sq] = NO_PIECE;
+    pos.hash ^= pieceKey(code, sq);
+}
+
+void movePiece(Position &pos, int from, int to) {
+    uint8_t code = pos.board[from];
+    removePiece(pos, from);
+    putPiece(pos, to, code);
+}
+
+uint8_t codeFromLetter(char ch) {
+    const char *p = strchr(PIECE_LETTERS, ch);
+    return (p && ch) ? uint8_t(p - PIECE_LETTERS) : NO_PIECE;
+}
+
+const char *skipSpaces(const char *s) {
+    while (*s == ' ') s++;
+    return s;
+}
+
+// Reads an unsigned decimal field; leaves value untouched when no digits are present.
+const char *readNumber(const char *s, uint16_t &value) {
+    if (*s < '0' || *s > '9') return s;
+    uint32_t v = 0;
+    while (*s >= '0' && *s <= '9') {
+        v = v * 10 + uint32_t(*s - '0');
+        s++;
+    }
+    value = uint16_t(v > 0xFFFF ? 0xFFFF : v);
+    return s;
+}
+
+} // namespace
+
+uint64_t computePositionHash(const Position &pos) {
+    uint64_t hash = castlingKey(pos.castling) ^ epKey(pos);
+    for (int sq = 0; sq < 64; sq++) {
+        if (pos.board[sq] != NO_PIECE) hash ^= pieceKey(pos.board[sq], sq);
+    }
+    if (pos.sideToMove == PIECE_BLACK) hash ^= ZOBRIST_KEYS[ZOBRIST_BLACK_TO_MOVE];
+    return hash;
+}
+
+char pieceChar(uint8_t code) {
+    return code < NO_PIECE ? PIECE_LETTERS[code] : '.';
+}
+
+char pieceCharAt(const Position &pos, int sq) {
+    return pieceChar(pos.board[sq]);
+}
+
+int parseSquare(const char *text) {
+    if (!text || text[0] < 'a' || text[0] > 'h' || text[1] < '1' || text[1] > '8') return NO_SQUARE;
+    return squareOf(text[1] - '1', text[0] - 'a');
+}
+
+void squareName(int sq, char out[3]) {
+    out[0] = char('a' + squareCol(sq));
+    out[1] = char('1' + squareRow(sq));
+    out[2] = '\0';
+}
+
+bool positionFromFen(Position &pos, const char *fen) {
+    if (!fen) return false;
+    Position p;
+    memset(&p, 0, sizeof(p));
+    memset(p.board, NO_PIECE, sizeof(p.board));
+    p.epSquare = NO_SQUARE;
+    p.fullmoveNumber = 1;
+
+    const char *s = skipSpaces(fen);
+
+    // 1) Placement: FEN starts at rank 8 (row 7)
+    int row = 7, col = 0;
+    for (; *s && *s != ' '; s++) {
+        char ch = *s;
+        if (ch == '/') {
+            if (col != 8 || row == 0) return false;
+            row--;
+            col = 0;
+        } else if (ch >= '1' && ch <= '8') {
+            col += ch - '0';
+            if (col > 8) return false;
+        } else {
+            uint8_t code = codeFromLetter(ch);
+            if (code == NO_PIECE || col >= 8) return false;
+            putPiece(p, squareOf(row, col), code);
+            col++;
+        }
+    }
+    if (row != 0 || col != 8) return false;
+
+    // 2) Side to move
+    s = skipSpaces(s);
+    if (*s == 'w') p.sideToMove = PIECE_WHITE;
+    else if (*s == 'b') p.sideToMove = PIECE_BLACK;
+    else return false;
+    s++;
+
+    // 3) Castling rights
+    s = skipSpaces(s);
+    for (; *s && *s != ' '; s++) {
+        switch (*s) {
+            case 'K': p.castling |= CASTLE_WHITE_KING; break;
+            case 'Q': p.castling |= CASTLE_WHITE_QUEEN; break;
+            case 'k': p.castling |= CASTLE_BLACK_KING; break;
+            case 'q': p.castling |= CASTLE_BLACK_QUEEN; break;
+            case '-': break;
+            default: return false;
+        }
+    }
+
+    // 4) En passant target
+    s = skipSpaces(s);
+    if (*s == '-') {
+        s++;
+    } else if (*s) {
+        int sq = parseSquare(s);
+        if (sq == NO_SQUARE) return false;
+        p.epSquare = int8_t(sq);
+        s += 2;
+    }
+
+    // 5) Clocks (optional — some servers trim them)
+    s = skipSpaces(s);
+    s = readNumber(s, p.halfmoveClock);
+    s = skipSpaces(s);
+    readNumber(s, p.fullmoveNumber);
+    if (p.fullmoveNumber == 0) p.fullmoveNumber = 1;
+
+    p.hash = computePositionHash(p);
+    pos = p;
+    return true;
+}
+
+size_t positionToFen(const Position &pos, char *out, size_t outSize) {
+    char buf[FEN_MAX_LEN];
+    size_t n = 0;
+
+    for (int row = 7; row >= 0; row--) {
+        int empty = 0;
+        for (int col = 0; col < 8; col++) {
+            uint8_t code = pos.board[squareOf(row, col)];
+            if (code == NO_PIECE) {
+                empty++;
+                continue;
+            }
+            if (empty) {
+                buf[n++] = char('0' + empty);
+                empty = 0;
+            }
+            buf[n++] = pieceChar(code);
+        }
+        if (empty) buf[n++] = char('0' + empty);
+        if (row) buf[n++] = '/';
+    }
+
+    buf[n++] = ' ';
+    buf[n++] = pos.sideToMove == PIECE_WHITE ? 'w' : 'b';
+    buf[n++] = ' ';
+    if (!pos.castling) {
+        buf[n++] = '-';
+    } else {
+        if (pos.castling & CASTLE_WHITE_KING) buf[n++] = 'K';
+        if (pos.castling & CASTLE_WHITE_QUEEN) buf[n++] = 'Q';
+        if (pos.castling & CASTLE_BLACK_KING) buf[n++] = 'k';
+        if (pos.castling & CASTLE_BLACK_QUEEN) buf[n++] = 'q';
+    }
+    buf[n++] = ' ';
+    if (pos.epSquare == NO_SQUARE) {
+        buf[n++] = '-';
+    } else {
+        squareName(pos.epSquare, &buf[n]);
+        n += 2;
+    }
+
+    uint16_t clocks[2] = { pos.halfmoveClock, pos.fullmoveNumber };
+    for (int i = 0; i < 2; i++) {
+        buf[n++] = ' ';
+        char digits[6];
+        int d = 0;
+        uint16_t v = clocks[i];
+        do {
+            digits[d++] = char('0' + v % 10);
+            v /= 10;
+        } while (v);
+        while (d) buf[n++] = digits[--d];
+    }
+
+    if (n + 1 > outSize) return 0;
+    memcpy(out, buf, n);
+    out[n] = '\0';
+    return n;
+}
+
+Move buildMove(const Position &pos, int from, int to, uint8_t promoType) {
+    if (from < 0 || from > 63 || to < 0 || to > 63 || from == to) return MOVE_NONE;
+    uint8_t code = pos.board[from];
+    if (code == NO_PIECE) return MOVE_NONE;
+
+    uint8_t type = pieceTypeOf(code);
+    bool capture = pos.board[to] != NO_PIECE;
+
+    if (type == KING && squareCol(from) == 4 && squareRow(from) == squareRow(to)) {
+        if (squareCol(to) == 6) return encodeMove(from, to, MF_KING_CASTLE);
+        if (squareCol(to) == 2) return encodeMove(from, to, MF_QUEEN_CASTLE);
+    }
+
+    if (type == PAWN) {
+        int toRow = squareRow(to);
+        if (toRow == 0 || toRow == 7) {
+            if (promoType < KNIGHT || promoType > QUEEN) promoType = QUEEN;
+            uint8_t base = capture ? MF_PROMO_CAPTURE : MF_PROMO;
+            return encodeMove(from, to, uint8_t(base + (promoType - KNIGHT)));
+        }
+        if (!capture && to == pos.epSquare && squareCol(from) != squareCol(to)) {
+            return encodeMove(from, to, MF_EP_CAPTURE);
+        }
+        int rowDiff = toRow - squareRow(from);
+        if (rowDiff == 2 || rowDiff == -2) return encodeMove(from, to, MF_DOUBLE_PUSH);
+    }
+
+    return encodeMove(from, to, capture ? MF_CAPTURE : MF_QUIET);
+}
+
+void makeMove(Position &pos, Move m, UndoInfo &undo) {
+    int from = moveFrom(m), to = moveTo(m);
+    uint8_t flags = moveFlags(m);
+    uint8_t code = pos.board[from];
+    uint8_t us = pos.sideToMove;
+
+    undo.castling = pos.castling;
+    undo.epSquare = pos.epSquare;
+    undo.halfmoveClock = pos.halfmoveClock;
+    undo.captured = NO_PIECE;
+    undo.hash = pos.hash;
+
+    // Piece keys follow put/remove below; side, castling and en-passant keys are swapped here and at the end.
+    pos.hash ^= castlingKey(pos.castling) ^ epKey(pos);
+    pos.epSquare = NO_SQUARE;
+    pos.halfmoveClock++;
+
+    if (flags == MF_EP_CAPTURE) {
+        int capSq = us == PIECE_WHITE ? to - 8 : to + 8;
+        undo.captured = pos.board[capSq];
+        removePiece(pos, capSq);
+    } else if (flags & MF_CAPTURE) {
+        undo.captured = pos.board[to];
+        removePiece(pos, to);
+    }
+
+    movePiece(pos, from, to);
+
+    if (flags == MF_KING_CASTLE) {
+        movePiece(pos, to + 1, to - 1);
+    } else if (flags == MF_QUEEN_CASTLE) {
+        movePiece(pos, to - 2, to + 1);
+    } else if (flags == MF_DOUBLE_PUSH) {
+        pos.epSquare = int8_t((from + to) / 2);
+    }
+
+    if (flags & MF_PROMO) {
+        removePiece(pos, to);
+        putPiece(pos, to, pieceCode(us, movePromotionType(m)));
+    }
+
+    if (pieceTypeOf(code) == PAWN || undo.captured != NO_PIECE) pos.halfmoveClock = 0;
+    pos.castling &= castlingMaskFor(from) & castlingMaskFor(to);
+    if (us == PIECE_BLACK) pos.fullmoveNumber++;
+    pos.sideToMove = uint8_t(us ^ 1);
+    pos.hash ^= castlingKey(pos.castling) ^ epKey(pos) ^ ZOBRIST_KEYS[ZOBRIST_BLACK_TO_MOVE];
+}
+
+void unmakeMove(Position &pos, Move m, const UndoInfo &undo) {
+    int from = moveFrom(m), to = moveTo(m);
+    uint8_t flags = moveFlags(m);
+    uint8_t us = uint8_t(pos.sideToMove ^ 1);
+
+    pos.sideToMove = us;
+    if (us == PIECE_BLACK) pos.fullmoveNumber--;
+
+    if (flags & MF_PROMO) {
+        removePiece(pos, to);
+        putPiece(pos, to, pieceCode(us, PAWN));
+    }
+
+    movePiece(pos, to, from);
+
+    if (flags == MF_KING_CASTLE) {
+        movePiece(pos, to - 1, to + 1);
+    } else if (flags == MF_QUEEN_CASTLE) {
+        movePiece(pos, to + 1, to - 2);
+    }
+
+    if (undo.captured != NO_PIECE) {
+        int capSq = to;
+        if (flags == MF_EP_CAPTURE) capSq = us == PIECE_WHITE ? to - 8 : to + 8;
+        putPiece(pos, capSq, undo.captured);
+    }
+
+    pos.castling = undo.castling;
+    pos.epSquare = undo.epSquare;
+    pos.halfmoveClock = undo.halfmoveClock;
+    pos.hash = undo.hash;
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+// Bitboard position core shared by the board firmware.
+// Square index: sq = row * 8 + col, row 0 = rank 1, col 0 = file a (same row/col as the sketch board arrays).
+// Pure C++ — no Arduino headers — so it can be reused off-device.
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint64_t Bitboard;
+typedef uint16_t Move; // from | to << 6 | flags << 12
+
+enum PieceColor : uint8_t {
+    PIECE_WHITE = 0,
+    PIECE_BLACK = 1
+};
+
+enum PieceType : uint8_t {
+    PAWN = 0,
+    KNIGHT = 1,
+    BISHOP = 2,
+    ROOK = 3,
+    QUEEN = 4,
+    KING = 5,
+    NO_PIECE_TYPE = 6
+};
+
+// Mailbox piece code: color * 6 + type, or NO_PIECE for an empty square.
+const uint8_t NO_PIECE = 12;
+
+enum CastlingRight : uint8_t {
+    CASTLE_WHITE_KING = 1,
+    CASTLE_WHITE_QUEEN = 2,
+    CASTLE_BLACK_KING = 4,
+    CASTLE_BLACK_QUEEN = 8
+};
+
+// Move flags (upper 4 bits of Move)
+enum MoveFlag : uint8_t {
+    MF_QUIET = 0,
+    MF_DOUBLE_PUSH = 1,
+    MF_KING_CASTLE = 2,
+    MF_QUEEN_CASTLE = 3,
+    MF_CAPTURE = 4,
+    MF_EP_CAPTURE = 5,
+    MF_PROMO = 8,          // + (promotion type - KNIGHT)
+    MF_PROMO_CAPTURE = 12  // + (promotion type - KNIGHT)
+};
+
+const Move MOVE_NONE = 0;
+const int NO_SQUARE = -1;
+const size_t FEN_MAX_LEN = 92; // longest legal FEN + terminator
+
+struct Position {
+    Bitboard pieces[2][6];   // [color][type]
+    Bitboard occupied[2];    // [color]
+    Bitboard occupiedAll;
+    uint8_t board[64];       // mailbox piece codes for O(1) lookups
+    uint8_t sideToMove;      // PieceColor
+    uint8_t castling;        // CastlingRight bits
+    int8_t epSquare;         // NO_SQUARE when unavailable
+    uint16_t halfmoveClock;
+    uint16_t fullmoveNumber;
+    uint64_t hash;           // Zobrist key, kept current by positionFromFen / makeMove / unmakeMove
+};
+
+// State that makeMove() cannot recover on its own; filled by makeMove, consumed by unmakeMove.
+struct UndoInfo {
+    uint8_t captured;        // mailbox code of the captured piece or NO_PIECE
+    uint8_t castling;
+    int8_t epSquare;
+    uint16_t halfmoveClock;
+    uint64_t hash;
+};
+
+inline int squareOf(int row, int col) { return row * 8 + col; }
+inline int squareRow(int sq) { return sq >> 3; }
+inline int squareCol(int sq) { return sq & 7; }
+inline Bitboard squareBit(int sq) { return Bitboard(1) << sq; }
+
+inline uint8_t pieceCode(uint8_t color, uint8_t type) { return uint8_t(color * 6 + type); }
+inline uint8_t pieceColor(uint8_t code) { return code >= 6 ? PIECE_BLACK : PIECE_WHITE; }
+inline uint8_t pieceTypeOf(uint8_t code) { return code == NO_PIECE ? uint8_t(NO_PIECE_TYPE) : uint8_t(code % 6); }
+
+inline Move encodeMove(int from, int to, uint8_t flags) { return Move(from | (to << 6) | (flags << 12)); }
+inline int moveFrom(Move m) { return m & 63; }
+inline int moveTo(Move m) { return (m >> 6) & 63; }
+inline uint8_t moveFlags(Move m) { return uint8_t(m >> 12); }
+inline bool moveIsCapture(Move m) { return (moveFlags(m) & MF_CAPTURE) != 0; }
+inline bool moveIsPromotion(Move m) { return (moveFlags(m) & MF_PROMO) != 0; }
+inline bool moveIsCastle(Move m) { return moveFlags(m) == MF_KING_CASTLE || moveFlags(m) == MF_QUEEN_CASTLE; }
+inline uint8_t movePromotionType(Move m) { return moveIsPromotion(m) ? uint8_t(KNIGHT + (moveFlags(m) & 3)) : uint8_t(NO_PIECE_TYPE); }
+
+// Parses a full FEN (placement, side, castling, en passant, clocks). Missing clock fields default to 0 / 1.
+bool positionFromFen(Position &pos, const char *fen);
+// Writes the FEN into out; returns the length written or 0 if outSize is too small.
+size_t positionToFen(const Position &pos, char *out, size_t outSize);
+
+// Full Zobrist recompute (makeMove keeps pos.hash current incrementally; this is for setup and checks).
+// Covers placement, side to move, castling rights, and the en-passant file only when a pawn can
+// actually capture there, so FENs that differ just in a dead en-passant field hash the same.
+uint64_t computePositionHash(const Position &pos);
+
+// FEN letter of the piece on sq, or '.' for an empty square.
+char pieceCharAt(const Position &pos, int sq);
+char pieceChar(uint8_t code);
+
+// Builds a Move from two squares, deriving capture / double push / castling / en-passant flags
+// from the position. promoType is only used when a pawn reaches the last rank (defaults to queen).
+Move buildMove(const Position &pos, int from, int to, uint8_t promoType = QUEEN);
+
+void makeMove(Position &pos, Move m, UndoInfo &undo);
+void unmakeMove(Position &pos, Move m, const UndoInfo &undo);
+
+// Square helpers for "e4"-style text. parseSquare returns NO_SQUARE on bad input.
+int parseSquare(const char *text);
+void squareName(int sq, char out[3]);
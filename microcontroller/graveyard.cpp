@@ -0,0 +1,69 @@
+#include "graveyard.h"
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// Row of the slot nearest to `row` in one column whose content is `want`; -1 if none.
+int nearestRow(const Graveyard &g, int side, uint8_t want, int row) {
+    int best = -1;
+    for (int r = 0; r < CARRIAGE_ROWS; r++) {
+        if (g.piece[side][r] != want) continue;
+        if (best < 0 || abs(r - row) < abs(best - row)) best = r;
+    }
+    return best;
+}
+
+} // namespace
+
+void graveyardClear(Graveyard &g) {
+    memset(g.piece, NO_PIECE, sizeof(g.piece));
+}
+
+bool graveyardFreeSlot(const Graveyard &g, uint8_t piece, int row, int &outRow, int &outCol) {
+    int own = pieceColor(piece) == PIECE_WHITE ? 0 : 1;
+    for (int pass = 0; pass < 2; pass++) {
+        int side = pass ? 1 - own : own;
+        int r = nearestRow(g, side, NO_PIECE, row);
+        if (r < 0) continue;
+        outRow = r;
+        outCol = graveyardColumn(side);
+        return true;
+    }
+    return false;
+}
+
+bool graveyardFind(const Graveyard &g, uint8_t piece, int row, int &outRow, int &outCol) {
+    int bestSide = -1, bestRow = -1;
+    for (int side = 0; side < 2; side++) {
+        int r = nearestRow(g, side, piece, row);
+        if (r < 0) continue;
+        if (bestRow < 0 || abs(r - row) < abs(bestRow - row)) {
+            bestSide = side;
+            bestRow = r;
+        }
+    }
+    if (bestRow < 0) return false;
+    outRow = bestRow;
+    outCol = graveyardColumn(bestSide);
+    return true;
+}
+
+void graveyardPut(Graveyard &g, int row, int col, uint8_t piece) {
+    g.piece[graveyardSide(col)][row] = piece;
+}
+
+uint8_t graveyardTake(Graveyard &g, int row, int col) {
+    uint8_t piece = g.piece[graveyardSide(col)][row];
+    g.piece[graveyardSide(col)][row] = NO_PIECE;
+    return piece;
+}
+
+void graveyardObstacles(const Graveyard &g, CarriageObstacles &out) {
+    for (int side = 0; side < 2; side++) {
+        out.capture[side] = 0;
+        for (int r = 0; r < CARRIAGE_ROWS; r++) {
+            if (g.piece[side][r] != NO_PIECE) out.capture[side] |= uint8_t(1 << r);
+        }
+    }
+}
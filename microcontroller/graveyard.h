@@ -0,0 +1,33 @@
+#pragma once
+
+// What stands in the capture columns: column 0 takes the white pieces, column 9 the black ones, one
+// piece per row. A captured piece goes to the free slot of its colour's column nearest to the rank
+// it was taken on (the other column once its own is full), and a given piece can be fetched back,
+// e.g. a queen for a promotion or every piece the start position needs when the board is reset.
+// No sensor covers these cells, so the inventory is what the robot itself put there and took out;
+// it starts empty at power-up.
+
+#include <stdint.h>
+#include "chess_position.h"
+#include "carriage_path.h"
+
+struct Graveyard {
+    uint8_t piece[2][CARRIAGE_ROWS];   // [0] = column 0, [1] = column 9; piece code or NO_PIECE
+};
+
+inline int graveyardColumn(int side) { return side ? CARRIAGE_COLS - 1 : 0; }
+inline int graveyardSide(int col) { return col == 0 ? 0 : 1; }
+
+void graveyardClear(Graveyard &g);
+
+// Free slot nearest to `row` for `piece` (motor row / col). False if both columns are full.
+bool graveyardFreeSlot(const Graveyard &g, uint8_t piece, int row, int &outRow, int &outCol);
+// Slot holding `piece` nearest to `row`, either column. False if there is none.
+bool graveyardFind(const Graveyard &g, uint8_t piece, int row, int &outRow, int &outCol);
+
+void graveyardPut(Graveyard &g, int row, int col, uint8_t piece);
+// Empties a slot and returns what stood there.
+uint8_t graveyardTake(Graveyard &g, int row, int col);
+
+// Occupied slots as carriage obstacles (out.capture; out.board is left alone).
+void graveyardObstacles(const Graveyard &g, CarriageObstacles &out);
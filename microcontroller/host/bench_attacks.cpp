@@ -0,0 +1,220 @@
+// Host-side micro-benchmark: the old char-board isValidMove (ray loops) against the
+// precomputed attack tables, in cycles per query over every from/to pair of a few positions.
+//
+//   g++ -O2 -std=c++11 -I.. bench_attacks.cpp ../chess_position.cpp ../chess_movegen.cpp ../chess_attacks.cpp -o bench_attacks
+//   ./bench_attacks              # exit code 1 if the two geometry checks ever disagree
+//
+// Both geometry checks ignore castling, en passant and king safety (as the old function did);
+// the "legal" row is the full findLegalMove() the sketch now uses, for scale.
+
+#include "chess_position.h"
+#include "chess_movegen.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+const char *FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R b KQ - 1 8",
+};
+
+const int ROUNDS = 2000;
+
+// ---- Old sketch implementation, kept verbatim apart from std::string for String ----
+
+bool isValidSquare(int row, int col) {
+    return row >= 0 && row < 8 && col >= 0 && col < 8;
+}
+
+bool isCurrentPlayerPiece(char piece, const std::string &currentTurn) {
+    if (piece == '.') return false;
+    if (currentTurn == "white") return (piece >= 'A' && piece <= 'Z');
+    else return (piece >= 'a' && piece <= 'z');
+}
+
+bool legacyIsValidMove(char board[8][8], int fromRow, int fromCol, int toRow, int toCol, const std::string &currentTurn) {
+    if (!isValidSquare(fromRow, fromCol) || !isValidSquare(toRow, toCol)) return false;
+    char piece = board[fromRow][fromCol];
+    char target = board[toRow][toCol];
+    if (piece == '.') return false;
+    if (!isCurrentPlayerPiece(piece, currentTurn)) return false;
+    if (target != '.' && isCurrentPlayerPiece(target, currentTurn)) return false;
+
+    char p = (piece >= 'a' && piece <= 'z') ? piece - 32 : piece;
+    switch (p) {
+        case 'P': {
+            int dir = (currentTurn == "white") ? 1 : -1;
+            int startRow = (currentTurn == "white") ? 1 : 6;
+            if (fromCol == toCol && toRow - fromRow == dir && board[toRow][toCol] == '.') return true;
+            if (fromCol == toCol && fromRow == startRow && toRow - fromRow == 2*dir && board[fromRow+dir][fromCol] == '.' && board[toRow][toCol] == '.') return true;
+            if (abs(toCol - fromCol) == 1 && toRow - fromRow == dir && board[toRow][toCol] != '.' && !isCurrentPlayerPiece(board[toRow][toCol], currentTurn)) return true;
+            return false;
+        }
+        case 'N': {
+            int dr = abs(toRow - fromRow), dc = abs(toCol - fromCol);
+            return (dr == 2 && dc == 1) || (dr == 1 && dc == 2);
+        }
+        case 'B': {
+            int dr = toRow - fromRow, dc = toCol - fromCol;
+            if (abs(dr) != abs(dc)) return false;
+            int rStep = (dr > 0) ? 1 : -1, cStep = (dc > 0) ? 1 : -1;
+            for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow; r += rStep, c += cStep)
+                if (board[r][c] != '.') return false;
+            return true;
+        }
+        case 'R': {
+            if (fromRow != toRow && fromCol != toCol) return false;
+            int rStep = (toRow == fromRow) ? 0 : ((toRow > fromRow) ? 1 : -1);
+            int cStep = (toCol == fromCol) ? 0 : ((toCol > fromCol) ? 1 : -1);
+            for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow || c != toCol; r += rStep, c += cStep)
+                if (board[r][c] != '.') return false;
+            return true;
+        }
+        case 'Q': {
+            int dr = toRow - fromRow, dc = toCol - fromCol;
+            if (abs(dr) == abs(dc)) {
+                int rStep = (dr > 0) ? 1 : -1, cStep = (dc > 0) ? 1 : -1;
+                for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow; r += rStep, c += cStep)
+                    if (board[r][c] != '.') return false;
+                return true;
+            } else if (fromRow == toRow || fromCol == toCol) {
+                int rStep = (toRow == fromRow) ? 0 : ((toRow > fromRow) ? 1 : -1);
+                int cStep = (toCol == fromCol) ? 0 : ((toCol > fromCol) ? 1 : -1);
+                for (int r = fromRow + rStep, c = fromCol + cStep; r != toRow || c != toCol; r += rStep, c += cStep)
+                    if (board[r][c] != '.') return false;
+                return true;
+            }
+            return false;
+        }
+        case 'K': {
+            int dr = abs(toRow - fromRow), dc = abs(toCol - fromCol);
+            return dr <= 1 && dc <= 1;
+        }
+        default:
+            return false;
+    }
+}
+
+// ---- Same question answered with the attack tables ----
+
+bool tableIsValidMove(const Position &pos, int from, int to) {
+    uint8_t us = pos.sideToMove;
+    Bitboard own = pos.occupied[us];
+    if (!(own & squareBit(from)) || (own & squareBit(to))) return false;
+
+    Bitboard occ = pos.occupiedAll;
+    Bitboard targets;
+    switch (pieceTypeOf(pos.board[from])) {
+        case PAWN: {
+            int forward = us == PIECE_WHITE ? 8 : -8;
+            int startRow = us == PIECE_WHITE ? 1 : 6;
+            targets = pawnAttacks(us, from) & pos.occupied[us ^ 1];
+            if (!(occ & squareBit(from + forward))) {
+                targets |= squareBit(from + forward);
+                if (squareRow(from) == startRow && !(occ & squareBit(from + 2 * forward))) targets |= squareBit(from + 2 * forward);
+            }
+            break;
+        }
+        case KNIGHT: targets = knightAttacks(from); break;
+        case BISHOP: targets = bishopAttacks(from, occ); break;
+        case ROOK:   targets = rookAttacks(from, occ); break;
+        case QUEEN:  targets = queenAttacks(from, occ); break;
+        case KING:   targets = kingAttacks(from); break;
+        default:     return false;
+    }
+    return (targets & squareBit(to)) != 0;
+}
+
+struct Query {
+    int position;
+    int from;
+    int to;
+};
+
+inline uint64_t cycleCount() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+const char *CYCLE_UNIT = "cycles";
+#else
+const char *CYCLE_UNIT = "ns";
+#endif
+
+template <typename F>
+void report(const char *name, size_t queries, int rounds, F run, int &sink) {
+    uint64_t start = cycleCount();
+    for (int round = 0; round < rounds; round++) sink += run();
+    uint64_t elapsed = cycleCount() - start;
+    std::printf("%-8s %10.1f %s/query\n", name, double(elapsed) / (double(queries) * rounds), CYCLE_UNIT);
+}
+
+} // namespace
+
+int main() {
+    const int count = int(sizeof(FENS) / sizeof(FENS[0]));
+    std::vector<Position> positions(count);
+    std::vector<std::string> turns(count);
+    static char boards[sizeof(FENS) / sizeof(FENS[0])][8][8];
+
+    for (int i = 0; i < count; i++) {
+        positionFromFen(positions[i], FENS[i]);
+        turns[i] = positions[i].sideToMove == PIECE_WHITE ? "white" : "black";
+        for (int sq = 0; sq < 64; sq++) boards[i][squareRow(sq)][squareCol(sq)] = pieceCharAt(positions[i], sq);
+    }
+
+    // Every target square for every piece of the side to move: the mix inferMoveTransform produces.
+    std::vector<Query> queries;
+    for (int i = 0; i < count; i++) {
+        for (int from = 0; from < 64; from++) {
+            if (!(positions[i].occupied[positions[i].sideToMove] & squareBit(from))) continue;
+            for (int to = 0; to < 64; to++) queries.push_back(Query{ i, from, to });
+        }
+    }
+
+    int mismatches = 0;
+    for (const Query &q : queries) {
+        bool legacy = legacyIsValidMove(boards[q.position], squareRow(q.from), squareCol(q.from),
+                                        squareRow(q.to), squareCol(q.to), turns[q.position]);
+        if (legacy != tableIsValidMove(positions[q.position], q.from, q.to)) mismatches++;
+    }
+
+    int sink = 0;
+    std::printf("%zu queries x %d rounds\n", queries.size(), ROUNDS);
+    report("legacy", queries.size(), ROUNDS, [&]() {
+        int valid = 0;
+        for (const Query &q : queries) {
+            valid += legacyIsValidMove(boards[q.position], squareRow(q.from), squareCol(q.from),
+                                       squareRow(q.to), squareCol(q.to), turns[q.position]);
+        }
+        return valid;
+    }, sink);
+    report("tables", queries.size(), ROUNDS, [&]() {
+        int valid = 0;
+        for (const Query &q : queries) valid += tableIsValidMove(positions[q.position], q.from, q.to);
+        return valid;
+    }, sink);
+    report("legal", queries.size(), ROUNDS / 100, [&]() {
+        int valid = 0;
+        for (const Query &q : queries) valid += findLegalMove(positions[q.position], q.from, q.to) != MOVE_NONE;
+        return valid;
+    }, sink);
+
+    std::printf("mismatches %d (checksum %d)\n", mismatches, sink);
+    return mismatches ? 1 : 0;
+}
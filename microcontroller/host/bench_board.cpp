@@ -0,0 +1,620 @@
+// Host-side latency benchmark for the board logic, with a sanity check on every measured function.
+// Built by microcontroller/CMakeLists.txt:
+//
+//   cmake -S microcontroller -B build && cmake --build build && ./build/bench_board
+//
+// Prints ns/call per function; exit code 1 if any check fails. The reed scan runs against a
+// simulated mux (hal_host.cpp), so its figure is logic cost only — the settle delays are
+// reported separately as the time the firmware would wait, and folded into scans/s.
+
+#include "chess_position.h"
+#include "chess_movegen.h"
+#include "chess_attacks.h"
+#include "chess_move_table.h"
+#include "chess_notation.h"
+#include "board_sensors.h"
+#include "sensor_stream.h"
+#include "sensor_snapshot.h"
+#include "sensor_filter.h"
+#include "move_tracker.h"
+#include "move_inference.h"
+#include "scan_scheduler.h"
+#include "motion_queue.h"
+#include "hal_host.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+// Same wiring as the firmware sketch
+const ReedMuxPins PINS = { 34, { 25, 33, 32, 13 }, { 26, 27, 14, 12 } };
+const BoardTransform SENSOR_MAP = MAP_MIRROR_COLS;
+
+const char *FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+};
+const int FEN_COUNT = int(sizeof(FENS) / sizeof(FENS[0]));
+
+// SIG keeps showing the previous channel for this long after an address / enable change
+const uint32_t SIM_SETTLE_US = 5;
+
+bool simBoard[8][8];
+bool simSig = true;
+int failures = 0;
+volatile uint32_t sink = 0;
+
+// Reed mux model: SIG is pulled LOW when the selected channel of the enabled mux sees a magnet.
+bool simulatedRead(int pin) {
+    if (pin != PINS.sig) return halHostPinLevel(pin);
+    if (halMicros() - halHostLastWriteMicros() < SIM_SETTLE_US) return simSig;
+    simSig = true;
+    for (int mux = 0; mux < 4; mux++) {
+        if (halHostPinLevel(PINS.enable[mux])) continue;
+        int ch = 0;
+        for (int b = 0; b < 4; b++) ch |= (halHostPinLevel(PINS.select[b]) ? 1 : 0) << b;
+        simSig = !simBoard[ch % 8][mux * 2 + (ch < 8 ? 0 : 1)];
+        break;
+    }
+    return simSig;
+}
+
+void check(bool ok, const char *what) {
+    if (ok) return;
+    failures++;
+    std::printf("  FAIL: %s\n", what);
+}
+
+template <typename F>
+double nsPerCall(int iterations, F fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) fn(i);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    return ns / iterations;
+}
+
+void report(const char *name, double ns) {
+    std::printf("%-28s %10.1f ns/call\n", name, ns);
+}
+
+} // namespace
+
+int main() {
+    halHostSetReadHook(simulatedRead);
+    Position positions[FEN_COUNT];
+    for (int i = 0; i < FEN_COUNT; i++) check(positionFromFen(positions[i], FENS[i]), "parse suite FEN");
+
+    // FEN handling
+    for (int i = 0; i < FEN_COUNT; i++) {
+        char fen[FEN_MAX_LEN];
+        check(positionToFen(positions[i], fen, sizeof(fen)) && std::strcmp(fen, FENS[i]) == 0, "FEN round trip");
+    }
+    report("positionFromFen", nsPerCall(200000, [&](int i) {
+        Position p;
+        sink += positionFromFen(p, FENS[i % FEN_COUNT]);
+    }));
+    report("positionToFen", nsPerCall(200000, [&](int i) {
+        char fen[FEN_MAX_LEN];
+        sink += uint32_t(positionToFen(positions[i % FEN_COUNT], fen, sizeof(fen)));
+    }));
+
+    // Legality (what isValidMove answers)
+    const Position &start = positions[0];
+    check(findLegalMove(start, parseSquare("e2"), parseSquare("e4")) != MOVE_NONE, "e2e4 legal");
+    check(findLegalMove(start, parseSquare("e2"), parseSquare("e5")) == MOVE_NONE, "e2e5 illegal");
+    check(findLegalMove(positions[1], parseSquare("e1"), parseSquare("g1")) != MOVE_NONE, "kiwipete O-O legal");
+    report("findLegalMove", nsPerCall(20000, [&](int i) {
+        const Position &p = positions[i % FEN_COUNT];
+        sink += findLegalMove(p, i & 63, (i >> 6) & 63);
+    }));
+
+    // Sensor-delta inference (what inferMoveTransform did): every legal move must be found from
+    // the occupancy change it produces, and be the only match unless occupancy cannot tell.
+    uint8_t mask = sensorSquareMask(SENSOR_MAP);
+    MoveSignatureTable table;
+    int resolved = 0, ambiguous = 0;
+    for (int i = 0; i < FEN_COUNT; i++) {
+        buildMoveSignatureTable(positions[i], mask, table);
+        MoveList list;
+        generateLegalMoves(positions[i], list);
+        bool before[8][8], after[8][8];
+        positionToSensorBoard(positions[i], SENSOR_MAP, before);
+        for (int m = 0; m < list.count; m++) {
+            Move mv = list.moves[m];
+            if (moveIsPromotion(mv) && movePromotionType(mv) != QUEEN) continue;
+            Position next = positions[i];
+            UndoInfo undo;
+            makeMove(next, mv, undo);
+            positionToSensorBoard(next, SENSOR_MAP, after);
+            Bitboard oldBits = sensorBoardBits(before), newBits = sensorBoardBits(after);
+            const MoveSignature *first = nullptr;
+            int n = lookupMoveSignature(table, oldBits & ~newBits, newBits & ~oldBits, &first);
+            bool found = false;
+            for (int k = 0; k < n; k++) found = found || first[k].move == mv;
+            check(found, "legal move recovered from its sensor delta");
+            if (n == 1) resolved++;
+            else if (!moveIsCapture(mv)) check(false, "non-capture delta is unique");
+            else ambiguous++;
+        }
+    }
+    std::printf("sensor deltas: %d unique, %d capture deltas shared by several moves\n", resolved, ambiguous);
+    report("buildMoveSignatureTable", nsPerCall(20000, [&](int i) {
+        buildMoveSignatureTable(positions[i % FEN_COUNT], mask, table);
+        sink += uint32_t(table.count);
+    }));
+    buildMoveSignatureTable(start, mask, table);
+    report("lookupMoveSignature", nsPerCall(2000000, [&](int i) {
+        const MoveSignature *first = nullptr;
+        sink += uint32_t(lookupMoveSignature(table, squareBit(i & 63), squareBit((i >> 6) & 63), &first));
+    }));
+
+    // computeMove core
+    bool oldB[8][8], newB[8][8];
+    positionToSensorBoard(start, SENSOR_MAP, oldB);
+    std::memcpy(newB, oldB, sizeof(oldB));
+    int e2 = parseSquare("e2") ^ mask, e4 = parseSquare("e4") ^ mask;
+    newB[squareRow(e2)][squareCol(e2)] = false;
+    newB[squareRow(e4)][squareCol(e4)] = true;
+    Move e2e4 = moveFromSensorDelta(oldB, newB, start, SENSOR_MAP);
+    check(e2e4 == encodeMove(parseSquare("e2"), parseSquare("e4"), MF_DOUBLE_PUSH), "moveFromSensorDelta e2e4");
+    report("moveFromSensorDelta", nsPerCall(200000, [&](int) {
+        sink += moveFromSensorDelta(oldB, newB, start, SENSOR_MAP);
+    }));
+
+    // buildFenAfterMove core
+    {
+        Position next = start;
+        UndoInfo undo;
+        makeMove(next, e2e4, undo);
+        char fen[FEN_MAX_LEN];
+        positionToFen(next, fen, sizeof(fen));
+        check(std::strcmp(fen, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1") == 0, "FEN after e2e4");
+    }
+    report("FEN after move", nsPerCall(200000, [&](int) {
+        Position next = start;
+        UndoInfo undo;
+        makeMove(next, e2e4, undo);
+        char fen[FEN_MAX_LEN];
+        sink += uint32_t(positionToFen(next, fen, sizeof(fen)));
+    }));
+
+    // Button-free detection: scripted lift / place sequences fed at the 10 ms scan rate; an
+    // illegal report falls back to the error model as the firmware does
+    {
+        SensorErrorModel floorModel;
+        sensorErrorModelDefaults(floorModel);
+        struct Step { uint32_t atMs; const char *square; bool place; };
+        uint32_t commitMs = 0;
+        auto play = [&](const char *fen, const Step *steps, int count, uint32_t endMs) {
+            Position pos;
+            positionFromFen(pos, fen);
+            buildMoveSignatureTable(pos, mask, table);
+            bool b[8][8];
+            positionToSensorBoard(pos, SENSOR_MAP, b);
+            Bitboard occ = sensorBoardBits(b);
+            MoveTracker tracker;
+            moveTrackerReset(tracker, occ, mask, 0);
+            int next = 0;
+            for (uint32_t t = 0; t <= endMs; t += 10) {
+                for (; next < count && steps[next].atMs <= t; next++) {
+                    Bitboard bit = squareBit(parseSquare(steps[next].square) ^ mask);
+                    occ = steps[next].place ? (occ | bit) : (occ & ~bit);
+                }
+                MoveTrackerEvent e = moveTrackerUpdate(tracker, table, occ, t);
+                if (e.kind == MOVE_EVENT_COMMIT) {
+                    commitMs = t;
+                    return e.move;
+                }
+                if (e.kind == MOVE_EVENT_ILLEGAL) {
+                    MoveInference inference = inferMostLikelyMove(pos, occ, mask, floorModel, tracker.lifted);
+                    if (moveInferenceAccepted(inference)) {
+                        commitMs = t;
+                        return inference.best;
+                    }
+                }
+            }
+            return Move(MOVE_NONE);
+        };
+        auto isUci = [&](Move m, const char *uci) {
+            char text[UCI_MAX_LEN];
+            return m != MOVE_NONE && moveToUci(m, text, sizeof(text)) && std::strcmp(text, uci) == 0;
+        };
+        const char *KNIGHT_FORK = "4k3/8/8/4p1p1/8/5N2/8/4K3 w - - 0 1";   // Nf3 can take e5 or g5
+        const char *EP = "4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1";
+
+        const Step push[] = { { 0, "e2", false }, { 400, "e4", true } };
+        check(isUci(play(FENS[0], push, 2, 2000), "e2e4") && commitMs == 700, "pawn push committed after the dwell");
+        uint32_t pushLatency = commitMs - 400;
+        const Step victimFirst[] = { { 0, "g5", false }, { 300, "f3", false }, { 600, "g5", true } };
+        check(isUci(play(KNIGHT_FORK, victimFirst, 3, 2000), "f3g5"), "capture: victim lifted first");
+        const Step attackerFirst[] = { { 0, "f3", false }, { 500, "e5", false }, { 800, "e5", true } };
+        check(isUci(play(KNIGHT_FORK, attackerFirst, 3, 2000), "f3e5"), "capture: attacker lifted first");
+        const Step inTheAir[] = { { 0, "f3", false } };
+        check(play(KNIGHT_FORK, inTheAir, 1, 3000) == MOVE_NONE, "piece held in the air is not a capture");
+        const char *ONE_CAPTURE = "4k3/8/8/3p4/8/2N5/8/4K3 w - - 0 1";   // Nc3's only capture is d5
+        const Step liftAndHold[] = { { 0, "c3", false } };
+        check(play(ONE_CAPTURE, liftAndHold, 1, 8000) == MOVE_NONE, "lift and hold past the illegal report is not a capture");
+        const Step strayReed[] = { { 0, "g5", false }, { 300, "f3", false }, { 600, "g5", true }, { 600, "h1", true } };
+        check(isUci(play(KNIGHT_FORK, strayReed, 4, 5000), "f3g5"), "capture with a stray reed, found by the error model");
+        const Step touched[] = { { 0, "e5", false }, { 200, "e5", true }, { 400, "f3", false } };
+        check(play(KNIGHT_FORK, touched, 3, 3000) == MOVE_NONE, "a touched-and-replaced piece does not vouch for a capture");
+        const Step castle[] = { { 0, "e1", false }, { 200, "g1", true }, { 400, "h1", false }, { 600, "f1", true } };
+        check(isUci(play(FENS[1], castle, 4, 2000), "e1g1"), "castling, king first");
+        const Step enPassant[] = { { 0, "e5", false }, { 200, "d6", true }, { 500, "d5", false } };
+        check(isUci(play(EP, enPassant, 3, 2000), "e5d6"), "en passant");
+        std::printf("move tracker: place-to-commit %u ms (dwell %u ms) vs a button press\n",
+                    unsigned(pushLatency), unsigned(MOVE_TRACKER_DEFAULTS.dwellMs));
+
+        buildMoveSignatureTable(start, mask, table);
+        MoveTracker tracker;
+        Bitboard startOcc = sensorBoardBits(oldB);
+        moveTrackerReset(tracker, startOcc, mask, 0);
+        report("moveTrackerUpdate", nsPerCall(1000000, [&](int i) {
+            sink += moveTrackerUpdate(tracker, table, startOcc ^ squareBit((i >> 4) & 63), uint32_t(i)).kind;
+        }));
+    }
+
+    // Move inference under sensor noise: random games, every move read through noisy reeds
+    // (stray / missed reads anywhere, plus coupling next to where the piece landed).
+    // Old firmware: exact delta lookup plus the rem=1/add=2 retry; new: maximum likelihood.
+    struct NoiseCase { const char *name; int anyPerMille; int coupledPerMille; };
+    const NoiseCase NOISE[2] = { { "light", 2, 50 }, { "heavy", 10, 150 } };
+    for (int nc = 0; nc < 2; nc++) {
+        uint32_t rng = 2024;
+        auto random = [&](uint32_t n) {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            return rng % n;
+        };
+        SensorErrorModel model;
+        sensorErrorModelDefaults(model);
+        int moves = 0, oldOk = 0, oldWrong = 0, mlOk = 0, mlWrong = 0;
+        for (int game = 0; game < 200; game++) {
+            Position pos = start;
+            for (int ply = 0; ply < 80; ply++) {
+                MoveList list;
+                generateLegalMoves(pos, list);
+                if (list.count == 0) break;
+                Move mv = list.moves[random(uint32_t(list.count))];
+                if (moveIsPromotion(mv) && movePromotionType(mv) != QUEEN) continue;
+                Position next = pos;
+                UndoInfo undo;
+                makeMove(next, mv, undo);
+
+                bool b[8][8];
+                positionToSensorBoard(pos, SENSOR_MAP, b);
+                Bitboard before = sensorBoardBits(b);
+                positionToSensorBoard(next, SENSOR_MAP, b);
+                Bitboard after = sensorBoardBits(b), reading = after;
+                int landed = moveTo(mv) ^ mask;
+                for (int sq = 0; sq < 64; sq++) {
+                    Bitboard bit = squareBit(sq);
+                    bool coupled = !(after & bit) && (kingAttacks(landed) & bit);
+                    if (int(random(1000)) < (coupled ? NOISE[nc].coupledPerMille : NOISE[nc].anyPerMille)) reading ^= bit;
+                }
+                moves++;
+
+                buildMoveSignatureTable(pos, mask, table);
+                const MoveSignature *first = nullptr;
+                Bitboard removed = before & ~reading, added = reading & ~before;
+                Move oldMove = MOVE_NONE;
+                if (lookupMoveSignature(table, removed, added, &first) == 1) oldMove = first->move;
+                else if (__builtin_popcountll(removed) == 1 && __builtin_popcountll(added) == 2) {
+                    for (Bitboard rest = added; rest && oldMove == MOVE_NONE; rest &= rest - 1) {
+                        if (lookupMoveSignature(table, removed, rest & (0 - rest), &first) == 1) oldMove = first->move;
+                    }
+                }
+                if (oldMove == mv) oldOk++;
+                else if (oldMove != MOVE_NONE) oldWrong++;
+
+                MoveInference inference = inferMostLikelyMove(pos, reading, mask, model);
+                if (moveInferenceAccepted(inference)) {
+                    if (inference.best == mv) mlOk++;
+                    else mlWrong++;
+                }
+                pos = next;
+            }
+        }
+        int oldRejected = moves - oldOk - oldWrong, mlRejected = moves - mlOk - mlWrong;
+        std::printf("%s noise, %d moves: exact+retry %d rejected / %d wrong, max-likelihood %d rejected / %d wrong\n",
+                    NOISE[nc].name, moves, oldRejected, oldWrong, mlRejected, mlWrong);
+        check(mlRejected < oldRejected, "max-likelihood rejects fewer noisy moves");
+        check(mlWrong < oldWrong, "max-likelihood accepts fewer wrong moves");
+        if (nc == 0) continue;
+        Position p = positions[1];
+        bool b[8][8];
+        positionToSensorBoard(p, SENSOR_MAP, b);
+        Bitboard reading = sensorBoardBits(b);
+        report("inferMostLikelyMove", nsPerCall(2000, [&](int i) {
+            sink += inferMostLikelyMove(p, reading ^ squareBit(i & 63), mask, model).best;
+        }));
+    }
+
+    // sendBoardSensorUpdate: occupancy packing and the change-driven stream
+    Bitboard occ = sensorOccupancy(oldB, SENSOR_MAP);
+    check(occ == start.occupiedAll, "sensorOccupancy matches the position");
+    report("sensorOccupancy", nsPerCall(1000000, [&](int) {
+        sink += uint32_t(sensorOccupancy(oldB, SENSOR_MAP));
+    }));
+    {
+        // Ten minutes of play scanned every 60 ms: a move every 20 s, each a lift, ~300 ms of
+        // carry with the origin reed bouncing, then the place. The old firmware sent
+        // one frame per 120 ms regardless.
+        SensorStream stream = SensorStream();
+        const uint32_t SCAN_MS = 60, DURATION_MS = 600000, MOVE_EVERY_MS = 20000;
+        const int E2 = parseSquare("e2"), E4 = parseSquare("e4");
+        Bitboard board = start.occupiedAll;
+        int frames = 0, keyframes = 0;
+        uint16_t lastSeq = 0;
+        bool seqOk = true, placedSent = true;
+        for (uint32_t t = 0; t < DURATION_MS; t += SCAN_MS) {
+            uint32_t phase = t % MOVE_EVERY_MS;
+            bool forward = (t / MOVE_EVERY_MS) % 2 == 0; // e2-e4, then back
+            int from = forward ? E2 : E4, to = forward ? E4 : E2;
+            if (phase >= 1300 && phase < 1300 + SCAN_MS) board = (board & ~squareBit(from)) | squareBit(to);
+
+            Bitboard reading = board;
+            if (phase >= 1000 && phase < 1300 && (phase / SCAN_MS) % 3 != 0) reading &= ~squareBit(from);
+
+            SensorFrame frame = sensorStreamUpdate(stream, reading, t);
+            if (frame.kind != SENSOR_FRAME_NONE) {
+                frames++;
+                if (frame.kind == SENSOR_FRAME_KEYFRAME) keyframes++;
+                seqOk = seqOk && uint16_t(frame.seq - lastSeq) == 1;
+                lastSeq = frame.seq;
+            }
+            // half a second after the place the live view must show it
+            if (phase >= 1800 && phase < 1800 + SCAN_MS) placedSent = placedSent && stream.sent == board;
+        }
+        int legacyFrames = int(DURATION_MS / 120);
+        std::printf("sensor stream: %d frames (%d keyframes) in 10 min vs %d at a fixed 120 ms (%.1fx fewer)\n",
+                    frames, keyframes, legacyFrames, double(legacyFrames) / frames);
+        check(seqOk, "sensor frames are numbered consecutively");
+        check(placedSent, "every placed piece reaches the live view");
+        check(frames * 10 <= legacyFrames, "sensor stream sends at least 10x fewer frames");
+    }
+
+    // Sensor task: per-square filter calibrated on a noisy board
+    {
+        // start position with a few bad reeds: three empty squares glitch closed 10% of the time,
+        // one occupied square drops out 5% of the time, one empty reed is stuck closed
+        uint32_t rng = 12345;
+        auto chance = [&](int percent) {
+            rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+            return int(rng % 100) < percent;
+        };
+        Bitboard expected = sensorBoardBits(oldB);
+        const int NOISY[3] = { 20, 35, 42 }, DROPOUT = 9, STUCK = 30;
+        Bitboard board = expected;
+        auto noisyScan = [&]() {
+            Bitboard raw = board | squareBit(STUCK);
+            for (int i = 0; i < 3; i++) if (!(board & squareBit(NOISY[i])) && chance(10)) raw |= squareBit(NOISY[i]);
+            if ((board & squareBit(DROPOUT)) && chance(5)) raw &= ~squareBit(DROPOUT);
+            return raw;
+        };
+
+        SensorCalibration calibration = SensorCalibration();
+        for (int i = 0; i < 100; i++) sensorCalibrationAdd(calibration, noisyScan());
+        SensorFilterConfig config;
+        int suppressed = sensorFilterFromCalibration(calibration, expected, config);
+        check(suppressed == 1 && config.suppressed == squareBit(STUCK), "stuck reed is suppressed");
+        check(config.onScans[NOISY[0]] > SENSOR_FILTER_DEFAULT_SCANS && config.offScans[DROPOUT] > SENSOR_FILTER_DEFAULT_SCANS,
+              "noisy reeds get longer thresholds");
+        check(config.onScans[parseSquare("e4") ^ mask] <= 3, "clean reeds flip within three scans");
+        check(config.offScans[parseSquare("e4") ^ mask] == SENSOR_FILTER_DEFAULT_SCANS &&
+              config.onScans[parseSquare("e2") ^ mask] == SENSOR_FILTER_DEFAULT_SCANS,
+              "the direction calibration cannot measure keeps the default");
+
+        // ten minutes of 10 ms scans with no move: the filtered board must never change
+        SensorFilter filter = SensorFilter();
+        SensorSnapshot snap;
+        int falseChanges = 0;
+        Bitboard lastOut = 0;
+        for (uint32_t t = 0; t < 600000; t += 10) {
+            sensorFilterUpdate(filter, config, noisyScan(), t, snap);
+            if (t > 0 && snap.occupancy != lastOut) falseChanges++;
+            lastOut = snap.occupancy;
+        }
+        check(snap.occupancy == expected, "filtered board matches the position");
+        std::printf("sensor filter: %d false changes in 10 min of noisy scans\n", falseChanges);
+        check(falseChanges == 0, "no false changes from glitching reeds");
+
+        // latency of a place onto a clean and onto a noisy square, against the old 200 ms + 15 x 8 ms vote
+        const int TARGETS[2] = { parseSquare("e4") ^ mask, NOISY[2] };
+        for (int k = 0; k < 2; k++) {
+            board |= squareBit(TARGETS[k]);
+            uint32_t placedAt = 700000 + uint32_t(k) * 10000, t = placedAt;
+            while (!(snap.occupancy & squareBit(TARGETS[k])) && t < placedAt + 1000) {
+                sensorFilterUpdate(filter, config, noisyScan(), t, snap);
+                t += 10;
+            }
+            std::printf("  place on %s reed: seen after %u ms (old vote window 320 ms)\n",
+                        k == 0 ? "clean" : "noisy", unsigned(t - placedAt));
+            check(t - placedAt < 320, "filter reports a place faster than the vote window");
+        }
+        report("sensorFilterUpdate", nsPerCall(1000000, [&](int i) {
+            sensorFilterUpdate(filter, config, board ^ squareBit(i & 63), uint32_t(i), snap);
+            sink += uint32_t(snap.occupancy);
+        }));
+    }
+
+    // Sensor task snapshots: the lock-free hand-over to readers on another core
+    {
+        SensorSnapshot snap;
+        // Writer thread publishes snapshots whose fields all derive from the scan number;
+        // a torn copy would mix two of them.
+        static SensorSnapshotChannel channel;
+        check(!sensorSnapshotRead(channel, snap), "no snapshot before the first publish");
+        std::atomic<bool> stop(false);
+        std::thread writer([&] {
+            SensorSnapshot out = SensorSnapshot();
+            for (uint32_t n = 1; !stop.load(std::memory_order_relaxed); n++) {
+                out.scan = n;
+                out.occupancy = Bitboard(n) * 0x9E3779B97F4A7C15ULL;
+                out.raw = ~out.occupancy;
+                out.scannedAtMs = out.changedAtMs = n * 10;
+                sensorSnapshotPublish(channel, out);
+            }
+        });
+        long reads = 0, torn = 0;
+        uint32_t lastScan = 0;
+        bool monotonic = true;
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+        while (std::chrono::steady_clock::now() < until) {
+            if (!sensorSnapshotRead(channel, snap)) continue;
+            reads++;
+            if (snap.occupancy != Bitboard(snap.scan) * 0x9E3779B97F4A7C15ULL || snap.raw != ~snap.occupancy ||
+                snap.scannedAtMs != snap.scan * 10 || snap.changedAtMs != snap.scan * 10) torn++;
+            monotonic = monotonic && snap.scan >= lastScan;
+            lastScan = snap.scan;
+        }
+        stop = true;
+        writer.join();
+        std::printf("snapshot race: %ld reads against a busy writer, %ld torn\n", reads, torn);
+        check(reads > 0 && torn == 0, "snapshot reads are never torn");
+        check(monotonic, "snapshot reads never go back in time");
+        report("sensorSnapshotRead", nsPerCall(1000000, [&](int) {
+            sensorSnapshotRead(channel, snap);
+            sink += snap.scan;
+        }));
+    }
+
+    // Motion queue: loop() pushes commands while the motion task executes them on another core
+    {
+        static MotionQueue queue;
+        MotionCommand command;
+        check(motionQueueIdle(queue) && !motionQueueFront(queue, command), "motion queue starts idle");
+        const uint32_t COMMANDS = 200000;
+        std::atomic<uint32_t> executed(0), outOfOrder(0);
+        std::thread consumer([&] {
+            for (uint32_t n = 0; n < COMMANDS;) {
+                MotionCommand front;
+                if (!motionQueueFront(queue, front)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                if (front.kind != MOTION_SEGMENT || front.dxMm != float(n % 1000) || front.dyMm != -float(n % 1000)) {
+                    outOfOrder++;
+                }
+                motionQueuePop(queue);
+                executed = ++n;
+            }
+        });
+        uint32_t fullRetries = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t n = 0; n < COMMANDS; n++) {
+            while (!motionQueuePush(queue, motionSegment(float(n % 1000), -float(n % 1000)))) {
+                fullRetries++;
+                std::this_thread::yield();
+            }
+        }
+        consumer.join();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::printf("motion queue: %u commands across threads, %u out of order, %u pushes retried on a full queue\n",
+                    unsigned(executed.load()), unsigned(outOfOrder.load()), unsigned(fullRetries));
+        check(executed == COMMANDS && outOfOrder == 0, "motion commands run once each, in order");
+        check(motionQueueIdle(queue) && motionQueueFree(queue) == MOTION_QUEUE_CAPACITY, "motion queue idle when drained");
+        report("motionQueue push+pop", ns / COMMANDS);
+
+        // an opponent move is queued in one go and the queue is busy until its last command is done
+        for (int i = 0; i < 40; i++) check(motionQueuePush(queue, motionDwell(uint16_t(i))), "opponent move fits the queue");
+        for (int i = 0; i < 39; i++) {
+            motionQueueFront(queue, command);
+            motionQueuePop(queue);
+        }
+        check(motionQueueFront(queue, command) && command.dwellMs == 39 && !motionQueueIdle(queue),
+              "queue stays busy while its last command runs");
+        motionQueuePop(queue);
+        check(motionQueueIdle(queue), "queue idle after the last command");
+    }
+
+    // Reed scan through the HAL against the simulated mux
+    std::memcpy(simBoard, oldB, sizeof(oldB));
+    bool scanned[8][8];
+    scanBoardTo(PINS, scanned);
+    check(std::memcmp(scanned, simBoard, sizeof(scanned)) == 0, "scanBoardTo reads the simulated board");
+    {
+        // The old scan: every square through readReed at the fixed 100 us
+        uint64_t delayedBefore = halHostDelayedMicros();
+        const int SCANS = 200;
+        double ns = nsPerCall(SCANS, [&](int) {
+            for (int mux = 0; mux < 4; mux++)
+                for (int ch = 0; ch < 16; ch++) scanned[ch % 8][mux * 2 + (ch < 8 ? 0 : 1)] = readReed(PINS, mux, ch);
+        });
+        double settleUs = double(halHostDelayedMicros() - delayedBefore) / SCANS;
+        std::printf("%-28s %10.1f scans/s (%.0f us settle per scan)\n", "readReed x64 @100 us",
+                    1e6 / (settleUs + ns / 1000), settleUs);
+    }
+    uint32_t settle = measureReedSettleMicros(PINS, 20);
+    std::printf("measured settle: %u us (simulated mux needs %u us)\n", unsigned(settle), unsigned(SIM_SETTLE_US));
+    check(settle >= SIM_SETTLE_US && settle < REED_SETTLE_SAFE_US, "measureReedSettleMicros finds the mux settle time");
+    setReedSettleMicros(settle);
+    bool stable = true;
+    for (int i = 0; i < 100; i++) {
+        scanBoardTo(PINS, scanned);
+        stable = stable && std::memcmp(scanned, simBoard, sizeof(scanned)) == 0;
+    }
+    check(stable, "scans at the measured settle time read the simulated board");
+    uint64_t delayedBefore = halHostDelayedMicros();
+    const int SCANS = 20000;
+    double scanNs = nsPerCall(SCANS, [&](int) {
+        scanBoardTo(PINS, scanned);
+        sink += scanned[0][0];
+    });
+    report("scanBoardTo (logic only)", scanNs);
+    double settleUs = double(halHostDelayedMicros() - delayedBefore) / SCANS;
+    std::printf("%-28s %10.1f us/scan simulated settle time\n", "", settleUs);
+    std::printf("%-28s %10.1f scans/s\n", "scanBoardTo", 1e6 / (settleUs + scanNs / 1000));
+
+    // Scan scheduling: e2-e4 played on the simulated mux (lift, 150 ms in the air, place), read by
+    // the old fixed 10 ms full scan and by the scheduler on a 2 ms tick; reed time is the settle
+    // time the scans spend on the mux.
+    {
+        ScanRoiMap roiMap;
+        MoveSignatureTable startTable;
+        buildMoveSignatureTable(start, mask, startTable);
+        buildScanRoiMap(startTable, mask, roiMap);
+        check((roiMap.relevant[e2] & squareBit(e4)) && (roiMap.relevant[e4] & squareBit(e2)),
+              "rescan region of a square covers the moves through it");
+        SensorFilterConfig config;
+        sensorFilterDefaults(config);
+        const uint32_t LIFT_MS = 1000, PLACE_MS = 1150, END_MS = 2000;
+        for (int scheduled = 0; scheduled < 2; scheduled++) {
+            std::memcpy(simBoard, oldB, sizeof(oldB));
+            SensorFilter filter = SensorFilter();
+            ScanScheduler scheduler = ScanScheduler();
+            SensorSnapshot snap = SensorSnapshot();
+            Bitboard raw = 0;
+            uint64_t idleUs = 0, activeUs = 0;
+            uint32_t liftSeen = 0, placeSeen = 0;
+            for (uint32_t t = 0; t < END_MS; t += scheduled ? 2 : 10) {
+                if (t == LIFT_MS) simBoard[squareRow(e2)][squareCol(e2)] = false;
+                if (t == PLACE_MS) simBoard[squareRow(e4)][squareCol(e4)] = true;
+                Bitboard squares = scheduled ? scanSchedulerNext(scheduler, t) : ALL_SENSOR_SQUARES;
+                if (!squares) continue;
+                uint64_t before = halHostDelayedMicros();
+                raw = (raw & ~squares) | scanSensorSquares(PINS, squares);
+                (t < LIFT_MS ? idleUs : activeUs) += halHostDelayedMicros() - before;
+                sensorFilterUpdate(filter, config, raw, t, snap, squares);
+                if (scheduled) scanSchedulerObserve(scheduler, roiMap, (raw ^ snap.occupancy) & squares, t);
+                if (!liftSeen && t >= LIFT_MS && !(snap.occupancy & squareBit(e2))) liftSeen = t;
+                if (!placeSeen && t >= PLACE_MS && (snap.occupancy & squareBit(e4))) placeSeen = t;
+            }
+            check(snap.occupancy == sensorBoardBits(oldB) - squareBit(e2) + squareBit(e4), "scans end on the played move");
+            check(liftSeen && placeSeen, "lift and place are both seen");
+            std::printf("%-28s lift seen after %2u ms, place after %2u ms; reed time idle %4.1f%%, "
+                        "during the move %4.1f%%\n", scheduled ? "scheduled 2 ms region" : "fixed 10 ms full scan",
+                        unsigned(liftSeen - LIFT_MS), unsigned(placeSeen - PLACE_MS),
+                        idleUs / (LIFT_MS * 10.0), activeUs / ((END_MS - LIFT_MS) * 10.0));
+            if (scheduled) check(placeSeen - PLACE_MS < 20, "region rescan confirms a place within 20 ms");
+        }
+    }
+
+    std::printf("%d check failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,338 @@
+// Heap-watermark benchmark for the per-move text path (FEN / SAN / UCI / move frames).
+// Plays deterministic pseudo-random games and, for every move, does what the firmware does:
+// rebuild the sensor move table, resolve the move, write SAN + FEN + the WebSocket and HTTP
+// move bodies, re-parse the FEN as if it came back from the server, and write a sensor frame.
+// Every heap allocation is counted and the run fails unless the steady state makes none.
+//
+//   cmake -S microcontroller -B build && cmake --build build && ./build/bench_codec
+//
+// Also checks SAN / UCI round trips, a few hand-written SAN cases and the Socket.IO packet parser
+// (hand-written frames of every packet type, plus every truncation of them and of the move frames);
+// exit code 1 on any failure.
+
+#include "chess_notation.h"
+#include "chess_movegen.h"
+#include "chess_move_table.h"
+#include "board_protocol.h"
+#include "socketio_packet.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace {
+
+size_t allocCount = 0;
+size_t liveBytes = 0;
+size_t peakBytes = 0;
+
+void noteAlloc(void *p) {
+    if (!p) return;
+    allocCount++;
+#if defined(__GLIBC__)
+    liveBytes += malloc_usable_size(p);
+    if (liveBytes > peakBytes) peakBytes = liveBytes;
+#endif
+}
+
+void noteFree(void *p) {
+#if defined(__GLIBC__)
+    if (p) liveBytes -= malloc_usable_size(p);
+#else
+    (void)p;
+#endif
+}
+
+} // namespace
+
+#if defined(__GLIBC__)
+// Count C allocations too (snprintf and friends would show up here), forwarding to glibc.
+extern "C" {
+void *__libc_malloc(size_t);
+void *__libc_calloc(size_t, size_t);
+void *__libc_realloc(void *, size_t);
+void __libc_free(void *);
+
+void *malloc(size_t size) { void *p = __libc_malloc(size); noteAlloc(p); return p; }
+void *calloc(size_t n, size_t size) { void *p = __libc_calloc(n, size); noteAlloc(p); return p; }
+void *realloc(void *old, size_t size) {
+    noteFree(old);
+    void *p = __libc_realloc(old, size);
+    noteAlloc(p);
+    return p;
+}
+void free(void *p) { noteFree(p); __libc_free(p); }
+}
+
+void *operator new(size_t size) {
+    void *p = malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+#else
+void *operator new(size_t size) {
+    void *p = std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    noteAlloc(p);
+    return p;
+}
+#endif
+
+void operator delete(void *p) noexcept {
+#if !defined(__GLIBC__)
+    noteFree(p);
+#endif
+    std::free(p);
+}
+void operator delete(void *p, size_t) noexcept { operator delete(p); }
+
+namespace {
+
+int failures = 0;
+volatile uint32_t sink = 0;
+
+void check(bool ok, const char *what) {
+    if (ok) return;
+    failures++;
+    std::printf("  FAIL: %s\n", what);
+}
+
+uint64_t rngState = 0x9E3779B97F4A7C15ULL;
+uint32_t nextRandom() {
+    rngState ^= rngState << 13;
+    rngState ^= rngState >> 7;
+    rngState ^= rngState << 17;
+    return uint32_t(rngState);
+}
+
+const char *START_FEN = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+struct SanCase {
+    const char *fen;
+    const char *uci;
+    const char *san;
+};
+
+const SanCase SAN_CASES[] = {
+    { START_FEN, "g1f3", "Nf3" },
+    { "4k3/8/8/8/8/2N3N1/8/4K3 w - - 0 1", "c3e4", "Nce4" },
+    { "4k3/8/8/R7/8/8/8/R3K3 w - - 0 1", "a1a3", "R1a3" },
+    { "4k3/8/8/8/8/8/8/R3K2R w KQ - 0 1", "e1c1", "O-O-O" },
+    { "rnbqkbnr/pppp1ppp/8/4p3/6P1/5P2/PPPPP2P/RNBQKBNR b KQkq - 0 2", "d8h4", "Qh4#" },
+    { "3r1k2/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7d8n", "exd8=N" },
+    { "3r1k2/4P3/8/8/8/8/8/4K3 w - - 0 1", "e7d8q", "exd8=Q+" },
+    { "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3", "e5f6", "exf6" },
+};
+
+struct PacketCase {
+    const char *text;
+    bool ok;
+    uint8_t engineType, socketType;
+    const char *nsp;
+    int32_t ackId;
+    const char *event, *args;
+};
+
+const PacketCase PACKET_CASES[] = {
+    { "2", true, EIO_PING, SIO_NONE, "", -1, "", "" },
+    { "3probe", true, EIO_PONG, SIO_NONE, "", -1, "", "probe" },
+    { "0{\"sid\":\"abc\",\"pingInterval\":25000}", true, EIO_OPEN, SIO_NONE, "", -1, "",
+      "{\"sid\":\"abc\",\"pingInterval\":25000}" },
+    { "40", true, EIO_MESSAGE, SIO_CONNECT, "", -1, "", "" },
+    { "40/friends,{\"sid\":\"x1\"}", true, EIO_MESSAGE, SIO_CONNECT, "/friends", -1, "", "{\"sid\":\"x1\"}" },
+    { "41/friends,", true, EIO_MESSAGE, SIO_DISCONNECT, "/friends", -1, "", "" },
+    { "44/friends,{\"message\":\"nope\"}", true, EIO_MESSAGE, SIO_CONNECT_ERROR, "/friends", -1, "",
+      "{\"message\":\"nope\"}" },
+    { "42[\"gameEnd\"]", true, EIO_MESSAGE, SIO_EVENT, "", -1, "gameEnd", "" },
+    { "42/friends,[\"moveMade\",{\"fen\":\"8/8 w\"}]", true, EIO_MESSAGE, SIO_EVENT, "/friends", -1, "moveMade",
+      "{\"fen\":\"8/8 w\"}" },
+    { "42/friends,12[\"ping\", 1, [2, 3] ]", true, EIO_MESSAGE, SIO_EVENT, "/friends", 12, "ping", "1, [2, 3]" },
+    { "427[\"a\\\"b\",\"]\"]", true, EIO_MESSAGE, SIO_EVENT, "", 7, "a\\\"b", "\"]\"" },
+    { "4313[{\"ok\":true}]", true, EIO_MESSAGE, SIO_ACK, "", 13, "", "{\"ok\":true}" },
+    { "43/friends,5[]", true, EIO_MESSAGE, SIO_ACK, "/friends", 5, "", "" },
+    { "451-[\"upload\",{\"_placeholder\":true,\"num\":0}]", true, EIO_MESSAGE, SIO_BINARY_EVENT, "", -1, "upload",
+      "{\"_placeholder\":true,\"num\":0}" },
+    { "4612-/friends,3[{\"_placeholder\":true,\"num\":0}]", true, EIO_MESSAGE, SIO_BINARY_ACK, "/friends", 3, "",
+      "{\"_placeholder\":true,\"num\":0}" },
+    { "", false, 0, 0, "", -1, "", "" },
+    { "7", false, 0, 0, "", -1, "", "" },
+    { "4", false, 0, 0, "", -1, "", "" },
+    { "49", false, 0, 0, "", -1, "", "" },
+    { "42", false, 0, 0, "", -1, "", "" },
+    { "42[1,2]", false, 0, 0, "", -1, "", "" },
+    { "42[\"a\" 1]", false, 0, 0, "", -1, "", "" },
+    { "42[\"a\\\"]", false, 0, 0, "", -1, "", "" },
+    { "42[\"a\",1", false, 0, 0, "", -1, "", "" },
+    { "4299999999999[\"a\"]", false, 0, 0, "", -1, "", "" },
+    { "451[\"upload\"]", false, 0, 0, "", -1, "", "" },
+};
+
+// A parse of text[0, len) whose spans all stay inside it.
+bool spansInside(const SocketIoPacket &packet, const char *text, size_t len) {
+    const PacketSpan spans[] = { packet.nsp, packet.event, packet.args };
+    for (const PacketSpan &span : spans) {
+        if (span.ptr < text || span.ptr + span.len > text + len) return false;
+    }
+    return true;
+}
+
+// Every proper prefix of an event / ack frame lacks its closing ']' and must be rejected;
+// any other prefix may parse, but only within its own bytes. Counts the prefixes accepted.
+int checkTruncations(const char *frame, bool framed) {
+    char buf[MOVE_FRAME_MAX];
+    size_t len = std::strlen(frame);
+    int accepted = 0;
+    for (size_t n = 0; n < len; n++) {
+        std::memcpy(buf, frame, n);
+        SocketIoPacket packet;
+        if (!parseSocketIoPacket(buf, n, packet)) continue;
+        accepted++;
+        check(!framed && spansInside(packet, buf, n), frame);
+    }
+    return accepted;
+}
+
+// One firmware move: everything from "button pressed" to "frames written", minus the I/O.
+size_t firmwareMove(Position &pos, Move m, MoveSignatureTable &table, Position &echo) {
+    buildMoveSignatureTable(pos, 7, table);
+
+    char fromSq[3], toSq[3], san[SAN_MAX_LEN], fen[FEN_MAX_LEN];
+    squareName(moveFrom(m), fromSq);
+    squareName(moveTo(m), toSq);
+    size_t total = moveToSan(pos, m, san, sizeof(san));
+    UndoInfo undo;
+    makeMove(pos, m, undo);
+    total += positionToFen(pos, fen, sizeof(fen));
+
+    MoveMessage msg = { "1234", fromSq, toSq, moveIsPromotion(m) ? "q" : "", san, fen,
+                        pos.sideToMove == PIECE_WHITE ? "black" : "white",
+                        pos.sideToMove == PIECE_WHITE ? "white" : "black", pos.hash };
+    char frame[MOVE_FRAME_MAX], body[MOVE_FRAME_MAX], sensors[SENSOR_FRAME_MAX];
+    total += writeMoveFrame(msg, frame, sizeof(frame));
+    total += writeMoveHttpBody(msg, 42, body, sizeof(body));
+
+    positionFromFen(echo, fen); // server echo of the move
+    total += writeSensorFrame(pos.occupiedAll, uint16_t(pos.fullmoveNumber), false, sensors, sizeof(sensors));
+    return total;
+}
+
+} // namespace
+
+int main() {
+    // Hand-checked SAN / UCI cases
+    for (const SanCase &c : SAN_CASES) {
+        Position pos;
+        check(positionFromFen(pos, c.fen), "parse SAN case FEN");
+        Move m = moveFromUci(pos, c.uci);
+        char san[SAN_MAX_LEN], uci[UCI_MAX_LEN];
+        check(m != MOVE_NONE && moveToSan(pos, m, san, sizeof(san)) && std::strcmp(san, c.san) == 0, c.san);
+        check(moveFromSan(pos, c.san) == m, "SAN decodes back to the move");
+        check(moveToUci(m, uci, sizeof(uci)) && std::strcmp(uci, c.uci) == 0, "UCI encodes back to the text");
+    }
+    {
+        Position pos;
+        positionFromFen(pos, START_FEN);
+        char tiny[3];
+        check(moveFromSan(pos, "e5") == MOVE_NONE, "illegal SAN rejected");
+        check(moveFromUci(pos, "e2e5") == MOVE_NONE, "illegal UCI rejected");
+        check(moveToSan(pos, moveFromUci(pos, "g1f3"), tiny, sizeof(tiny)) == 0, "SAN overflow reports 0");
+        check(positionToFen(pos, tiny, sizeof(tiny)) == 0, "FEN overflow reports 0");
+    }
+
+    // Socket.IO packets: every type by hand, then every truncation of them
+    int packetsOk = 0, truncationsAccepted = 0;
+    for (const PacketCase &c : PACKET_CASES) {
+        char buf[MOVE_FRAME_MAX];
+        size_t len = std::strlen(c.text);
+        std::memcpy(buf, c.text, len);
+        SocketIoPacket packet;
+        bool ok = parseSocketIoPacket(buf, len, packet);
+        bool expected = ok == c.ok;
+        if (ok && c.ok) {
+            expected = packet.engineType == c.engineType && packet.socketType == c.socketType && packet.nsp.equals(c.nsp) &&
+                       packet.ackId == c.ackId && packet.event.equals(c.event) && packet.args.equals(c.args) &&
+                       spansInside(packet, buf, len);
+        }
+        check(expected, c.text[0] ? c.text : "(empty frame)");
+        if (expected) packetsOk++;
+        if (c.ok) {
+            bool framed = c.socketType == SIO_EVENT || c.socketType == SIO_ACK || c.socketType == SIO_BINARY_EVENT ||
+                          c.socketType == SIO_BINARY_ACK;
+            truncationsAccepted += checkTruncations(c.text, framed);
+        }
+    }
+    {
+        SocketIoPacket packet;
+        char def[] = "42[\"x\"]", friends[] = "42/friends,[\"x\"]";
+        check(parseSocketIoPacket(def, std::strlen(def), packet) && packetInNamespace(packet, "/") &&
+              packetInNamespace(packet, "") && !packetInNamespace(packet, "/friends"), "default namespace");
+        check(parseSocketIoPacket(friends, std::strlen(friends), packet) && packetInNamespace(packet, "/friends") &&
+              !packetInNamespace(packet, "/") && !packetInNamespace(packet, "/friend"), "named namespace");
+    }
+    {
+        // the frames the board writes itself, as the server's parser would see them
+        Position pos;
+        positionFromFen(pos, START_FEN);
+        MoveMessage msg = { "1234", "e2", "e4", "", "e4", START_FEN, "white", "black", pos.hash };
+        char frame[MOVE_FRAME_MAX], sensors[SENSOR_FRAME_MAX];
+        size_t len = writeMoveFrame(msg, frame, sizeof(frame));
+        SocketIoPacket packet;
+        check(len && parseSocketIoPacket(frame, len, packet) && packet.event.equals("move") &&
+              packetInNamespace(packet, "/friends"), "move frame parses");
+        truncationsAccepted += checkTruncations(frame, true);
+        len = writeSensorFrame(pos.occupiedAll, 1, true, sensors, sizeof(sensors));
+        check(len && parseSocketIoPacket(sensors, len, packet) && packet.event.equals("boardSensorUpdate"),
+              "sensor frame parses");
+        truncationsAccepted += checkTruncations(sensors, true);
+    }
+    std::printf("socket.io packets: %d/%zu parsed as expected, %d truncated prefixes accepted (none framed)\n",
+                packetsOk, sizeof(PACKET_CASES) / sizeof(PACKET_CASES[0]), truncationsAccepted);
+
+    // Deterministic random games: round trips on every move, then the allocation count.
+    const int GAMES = 200, MAX_PLIES = 160;
+    static MoveSignatureTable table;
+    static MoveList list;
+    Position pos, echo;
+    int moves = 0, measured = 0, roundTrips = 0;
+    size_t written = 0;
+    size_t allocsBefore = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int game = 0; game < GAMES; game++) {
+        if (game == 1) {
+            // Game 0 is the warm-up (lazy stdio / locale set-up); measure from here on.
+            allocsBefore = allocCount;
+            start = std::chrono::steady_clock::now();
+        }
+        positionFromFen(pos, START_FEN);
+        for (int ply = 0; ply < MAX_PLIES; ply++) {
+            generateLegalMoves(pos, list);
+            if (!list.count) break;
+            Move m = list.moves[nextRandom() % list.count];
+
+            char san[SAN_MAX_LEN], uci[UCI_MAX_LEN];
+            moveToSan(pos, m, san, sizeof(san));
+            moveToUci(m, uci, sizeof(uci));
+            if (moveFromSan(pos, san) == m && moveFromUci(pos, uci) == m) roundTrips++;
+            else check(false, san);
+
+            written += firmwareMove(pos, m, table, echo);
+            check(echo.hash == pos.hash, "server echo FEN parses to the same position");
+            moves++;
+            if (game > 0) measured++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    size_t allocs = allocCount - allocsBefore;
+    sink += uint32_t(written);
+
+    std::printf("moves %d (round trips ok %d), %.2f us/move\n", moves, roundTrips, seconds * 1e6 / measured);
+    std::printf("heap allocations after warm-up: %zu (%.3f per move), peak live heap %zu bytes\n",
+                allocs, double(allocs) / measured, peakBytes);
+    check(allocs == 0, "per-move path is allocation free");
+    std::printf("%d check failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
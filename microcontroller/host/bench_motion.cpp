@@ -0,0 +1,725 @@
+// Carriage motion benchmark: every square-to-square lane path on the board (64 x 64), timed the
+// way the firmware used to run it and through the look-ahead planner, plus the same trips with the
+// magnet released (straight across instead of along the lanes), and every legal move of a few
+// positions carried along the fixed lanes vs the clear path around the pieces actually there.
+//
+//   cmake -S microcontroller -B build && cmake --build build && ./build/bench_motion
+//
+// "Before" models runSegment: every leg an AccelStepper trapezoid from rest to rest, its top
+// speed scaled by leg length between 1100 and 1500 steps/s, ramp 0.2 s, plus the 10 ms pause.
+// Each planned path is also integrated to check that its speed profile covers the path's length
+// without exceeding the limits, and run tick by tick through the step generator (what the step
+// timer interrupt executes) to check the pulses: exact step counts, pulses at least two ticks
+// apart, no pulse on a direction change, and the run time against the planned one. Last, the robot
+// time of whole opponent moves (capture, carry, castling rook) with the old fixed servo waits vs
+// the pick-and-place timing that overlaps the arm with the carriage, and the motion tuner run
+// against simulated boards where a piece slips above a given acceleration. Board setup: resets to
+// the start position (after the suite's positions with the captured pieces in the capture columns,
+// and after random shuffles) and set-ups of the suite's positions, replayed to check every step
+// and compared with assigning pieces first-fit in square order. Graveyard: random games with every
+// capture and promotion through the slot allocator against the old fixed cell per rank, each reset
+// to the start position from the board plus the graveyard; exit code 1 on any failure.
+
+#include "carriage_path.h"
+#include "motion_planner.h"
+#include "step_generator.h"
+#include "pick_place.h"
+#include "motion_tuning.h"
+#include "board_setup.h"
+#include "graveyard.h"
+#include "chess_movegen.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+// Same geometry and drive as the firmware sketch
+const float STEPS_PER_MM = 50.0f;
+const float CELL_SIZE_MM = 5.29f;
+const float GAP_MM = 1.5f * CELL_SIZE_MM;
+const float MIN_END_SPEED = 1100.0f, MAX_END_SPEED = 1500.0f, RAMP_TIME = 0.2f;
+const float SEGMENT_PAUSE_S = 0.010f;
+
+const char *FENS[] = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+};
+
+int failures = 0;
+volatile float sink = 0;
+
+void check(bool ok, const char *what) {
+    if (ok) return;
+    failures++;
+    std::printf("  FAIL: %s\n", what);
+}
+
+// runSegment: both motors step |dx| + |dy| (axis-aligned legs), accelerating from and to rest.
+float legacyLegSeconds(float dxMm, float dyMm) {
+    float sx = std::round(dxMm * STEPS_PER_MM), sy = std::round(dyMm * STEPS_PER_MM);
+    float steps = std::fabs(sx) + std::fabs(sy);
+    if (steps == 0.0f) return SEGMENT_PAUSE_S;
+    float minDist = CELL_SIZE_MM * STEPS_PER_MM;
+    float maxDist = std::sqrt(float(CARRIAGE_ROWS * CARRIAGE_ROWS + CARRIAGE_COLS * CARRIAGE_COLS)) * minDist;
+    float norm = std::fmin(std::fmax((std::sqrt(sx * sx + sy * sy) - minDist) / (maxDist - minDist), 0.0f), 1.0f);
+    float speed = MIN_END_SPEED + norm * (MAX_END_SPEED - MIN_END_SPEED);
+    float accel = speed / RAMP_TIME;
+    float seconds = steps >= speed * speed / accel ? steps / speed + speed / accel : 2.0f * std::sqrt(steps / accel);
+    return seconds + SEGMENT_PAUSE_S;
+}
+
+void planPath(const CarriagePath &path, const MotionLimits &limits, MotionPlan &plan) {
+    motionPlanBegin(plan, limits);
+    for (int i = 0; i < path.count; i++) motionPlanAdd(plan, path.dxMm[i], path.dyMm[i]);
+    motionPlanFinish(plan);
+}
+
+// Integrates the planned speed; false if it leaves the limits, jumps at a block boundary or
+// does not add up to the block lengths.
+bool profileCoversPath(const MotionPlan &plan) {
+    const float DT = 0.0002f;
+    float lastSpeed = 0.0f;
+    for (int i = 0; i < plan.count; i++) {
+        const MotionBlock &block = plan.blocks[i];
+        float duration = motionBlockDuration(block), distance = 0.0f;
+        if (std::fabs(block.entrySpeed - lastSpeed) > 0.01f) return false;
+        for (float t = 0.0f; t < duration; t += DT) {
+            float v = motionBlockSpeedAt(plan, block, t + 0.5f * DT);
+            if (v < -0.001f || v > plan.limits.maxSpeed + 0.001f) return false;
+            distance += v * (t + DT <= duration ? DT : duration - t);
+        }
+        if (std::fabs(distance - block.length) > 0.01f * block.length + 0.005f) return false;
+        lastSpeed = block.exitSpeed;
+    }
+    return std::fabs(lastSpeed) < 1e-6f;
+}
+
+struct StepRun {
+    long a, b;                    // net steps per motor
+    long expectA, expectB;        // what the path adds up to
+    uint32_t ticks;
+    uint32_t minGap;              // fewest ticks between two pulses of one motor
+    uint32_t peakStepsPerSecond;  // busiest 1 ms of either motor
+    bool pulseOnDirChange;
+};
+
+StepGenerator stepGen;   // idle between runs, like the firmware's
+
+// Cuts a plan into segments and runs the generator until the last step, as the motion task and
+// the step timer do.
+StepRun runSteps(const MotionPlan &plan) {
+    StepRun run = { 0, 0, 0, 0, 0, ~0u, 0, false };
+    float x = 0, y = 0;
+    for (int i = 0; i < plan.count; i++) { x += plan.blocks[i].dxMm; y += plan.blocks[i].dyMm; }
+    run.expectA = std::lround((x + y) * STEPS_PER_MM);
+    run.expectB = std::lround((x - y) * STEPS_PER_MM);
+    StepPathCursor cursor;
+    stepPathBegin(cursor, plan, STEPS_PER_MM, 2.0f);
+    StepSegment segment;
+    bool more = stepPathNext(cursor, segment);
+    uint32_t lastA = 0, lastB = 0, windowA = 0, windowB = 0;
+    bool seenA = false, seenB = false;
+    uint8_t reverse = stepGen.reverse;
+    while (more || !stepGeneratorIdle(stepGen)) {
+        while (more && stepGeneratorPush(stepGen, segment)) more = stepPathNext(cursor, segment);
+        StepOutput out = stepGeneratorTick(stepGen);
+        if (out.reverse != reverse && out.step) run.pulseOnDirChange = true;
+        reverse = out.reverse;
+        if (out.step & STEP_MOTOR_A) {
+            run.a += (out.reverse & STEP_MOTOR_A) ? -1 : 1;
+            if (seenA && run.ticks - lastA < run.minGap) run.minGap = run.ticks - lastA;
+            lastA = run.ticks;
+            seenA = true;
+            windowA++;
+        }
+        if (out.step & STEP_MOTOR_B) {
+            run.b += (out.reverse & STEP_MOTOR_B) ? -1 : 1;
+            if (seenB && run.ticks - lastB < run.minGap) run.minGap = run.ticks - lastB;
+            lastB = run.ticks;
+            seenB = true;
+            windowB++;
+        }
+        if (++run.ticks % (1000 / STEP_TICK_US) == 0) {
+            uint32_t busiest = (windowA > windowB ? windowA : windowB) * 1000;
+            if (busiest > run.peakStepsPerSecond) run.peakStepsPerSecond = busiest;
+            windowA = windowB = 0;
+        }
+    }
+    return run;
+}
+
+bool stepRunExact(const StepRun &run) {
+    return run.a == run.expectA && run.b == run.expectB && run.minGap >= 2 && !run.pulseOnDirChange;
+}
+
+// What the firmware's executeOpponentMove queues for one carry, timed the old way (fixed servo
+// waits around every write) and the way the motion task runs the pick-and-place commands.
+struct CarryTimer {
+    const CarriageGeometry &geometry;
+    CarriageObstacles obstacles;
+    PickPlace pickPlace;
+    int row, col;
+    double before, after;   // s
+};
+
+double pathSeconds(const CarriagePath &path, MotionPlan &plan) {
+    planPath(path, MOTION_LIMITS_DEFAULTS, plan);
+    return motionPlanDuration(plan) + SEGMENT_PAUSE_S;
+}
+
+// The servo commands between two paths; `plan` is the path before them.
+double servoSeconds(const MotionCommand *commands, int count, const MotionPlan *plan) {
+    double seconds = 0;
+    for (int i = 0; i < count; i++) {
+        const MotionCommand &command = commands[i];
+        if (command.kind == MOTION_DWELL) seconds += command.dwellMs * 1e-3;
+        if (command.kind != MOTION_SERVO || command.leadMs == 0) continue;
+        uint16_t overlapped = (i == 0 && plan) ? pickPlaceLeadMs(*plan, command.leadMs) : 0;
+        seconds += (command.leadMs - overlapped) * 1e-3;
+    }
+    return seconds;
+}
+
+void timeCarry(CarryTimer &timer, int fromRow, int fromCol, int toRow, int toCol) {
+    MotionPlan travelPlan, carryPlan;
+    MotionCommand servo[PICK_PLACE_MAX_COMMANDS];
+    CarriagePath travel, carry;
+    carriageDirectPath(timer.geometry, timer.row, timer.col, fromRow, fromCol, travel);
+    if (!carriageClearPath(timer.geometry, timer.obstacles, MOTION_LIMITS_DEFAULTS, fromRow, fromCol, toRow, toCol, carry)) {
+        carriageLanePath(timer.geometry, fromRow, fromCol, toRow, toCol, carry);
+    }
+    double travelSeconds = travel.count ? pathSeconds(travel, travelPlan) : 0;
+    double carrySeconds = pathSeconds(carry, carryPlan);
+    timer.before += 0.400 + travelSeconds + 0.150 + carrySeconds + 0.080 + 0.150;
+    timer.after += servoSeconds(servo, pickPlaceRaise(timer.pickPlace, servo), nullptr) + travelSeconds;
+    timer.after += servoSeconds(servo, pickPlaceGrip(timer.pickPlace, servo), travel.count ? &travelPlan : nullptr);
+    timer.after += carrySeconds + servoSeconds(servo, pickPlaceDrop(timer.pickPlace, servo), &carryPlan);
+    timer.row = toRow;
+    timer.col = toCol;
+}
+
+float cellDistanceMm(const CarriageGeometry &geometry, int a, int b) {
+    return std::fabs((setupCellRow(a) - setupCellRow(b)) * geometry.cellMm) +
+           std::fabs(geometry.colOffsets[setupCellCol(a)] - geometry.colOffsets[setupCellCol(b)]);
+}
+
+// Carriage mm (travel and carries) of a setup plan from home; false if a step is impossible or the
+// board does not end up as target, short of the plan's missing pieces.
+bool replaySetup(const CarriageGeometry &geometry, const SetupCells &start, const Position &target,
+                 const SetupPlan &plan, float &mm) {
+    SetupCells cells = start;
+    int carriage = setupCell(0, 0);
+    mm = 0;
+    for (int i = 0; i < plan.count; i++) {
+        const SetupStep &step = plan.steps[i];
+        if (cells.piece[step.from] != step.piece || step.piece == NO_PIECE || cells.piece[step.to] != NO_PIECE) return false;
+        mm += cellDistanceMm(geometry, carriage, step.from) + cellDistanceMm(geometry, step.from, step.to);
+        setupApply(cells, step);
+        carriage = step.to;
+    }
+    int missing[NO_PIECE] = {};
+    for (int sq = 0; sq < 64; sq++) {
+        uint8_t piece = cells.piece[setupCellOfSquare(sq)];
+        if (piece == target.board[sq]) continue;
+        if (piece != NO_PIECE || ++missing[target.board[sq]] > plan.missing[target.board[sq]]) return false;
+    }
+    return true;
+}
+
+// Baseline: target squares in order, each taking the first piece of its kind in cell order,
+// surplus pieces cleared to their column at the end; blocking ignored (it only flatters this).
+float firstFitSetupMm(const CarriageGeometry &geometry, const SetupCells &start, const Position &target) {
+    SetupCells cells = start;
+    bool taken[SETUP_CELLS] = {};
+    int carriage = setupCell(0, 0);
+    float mm = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        int to = setupCellOfSquare(sq);
+        if (target.board[sq] == NO_PIECE) continue;
+        if (cells.piece[to] == target.board[sq] && !taken[to]) { taken[to] = true; continue; }
+        for (int from = 0; from < SETUP_CELLS; from++) {
+            if (cells.piece[from] != target.board[sq] || taken[from]) continue;
+            bool needed = false;   // a piece already on one of its own targets stays
+            for (int t = 0; t < 64; t++) needed = needed || (setupCellOfSquare(t) == from && target.board[t] == cells.piece[from]);
+            if (needed) continue;
+            mm += cellDistanceMm(geometry, carriage, from) + cellDistanceMm(geometry, from, to);
+            carriage = to;
+            taken[to] = true;
+            break;
+        }
+    }
+    for (int cell = 0; cell < SETUP_CELLS; cell++) {
+        int col = setupCellCol(cell);
+        if (cells.piece[cell] == NO_PIECE || taken[cell] || col == 0 || col == CARRIAGE_COLS - 1) continue;
+        bool used = false;
+        for (int sq = 0; sq < 64; sq++) used = used || (setupCellOfSquare(sq) == cell && target.board[sq] == cells.piece[cell]);
+        if (used) continue;
+        int park = setupCell(setupCellRow(cell), pieceColor(cells.piece[cell]) == PIECE_WHITE ? 0 : CARRIAGE_COLS - 1);
+        mm += cellDistanceMm(geometry, carriage, cell) + cellDistanceMm(geometry, cell, park);
+        carriage = park;
+    }
+    return mm;
+}
+
+bool cellOccupied(const CarriageObstacles &obstacles, int row, int col) {
+    if (col == 0) return obstacles.capture[0] & (1 << row);
+    if (col == CARRIAGE_COLS - 1) return obstacles.capture[1] & (1 << row);
+    return obstacles.board & squareBit(squareOf(row, col - 1));
+}
+
+// Walks a path in small steps and counts the half-cell grid points it touches that cross an
+// occupied cell centre or pass between two occupied cells.
+int tightPoints(const CarriageGeometry &geometry, const CarriageObstacles &obstacles, int fromRow, int fromCol,
+                const CarriagePath &path) {
+    int tight = 0, lastR = -1, lastC = -1;
+    float x = fromRow * geometry.cellMm, y = geometry.colOffsets[fromCol];
+    for (int i = 0; i < path.count; i++) {
+        const int STEPS = 400;
+        for (int k = 1; k <= STEPS; k++) {
+            float px = x + path.dxMm[i] * k / STEPS, py = y + path.dyMm[i] * k / STEPS;
+            int r = int(std::lround(px / geometry.halfRow));
+            if (std::fabs(r * geometry.halfRow - px) > 0.02f) continue;
+            int c = -1;
+            for (int cc = 0; cc < 2 * CARRIAGE_COLS - 1; cc++) {
+                float cy = (cc & 1) ? 0.5f * (geometry.colOffsets[cc / 2] + geometry.colOffsets[cc / 2 + 1])
+                                    : geometry.colOffsets[cc / 2];
+                if (std::fabs(cy - py) <= 0.02f) c = cc;
+            }
+            if (c < 0 || (r == lastR && c == lastC)) continue;
+            lastR = r; lastC = c;
+            if (!(r & 1) && !(c & 1) && cellOccupied(obstacles, r / 2, c / 2)) tight++;
+            if ((r & 1) && !(c & 1) && cellOccupied(obstacles, r / 2, c / 2) && cellOccupied(obstacles, r / 2 + 1, c / 2)) tight++;
+            if (!(r & 1) && (c & 1) && cellOccupied(obstacles, r / 2, c / 2) && cellOccupied(obstacles, r / 2, c / 2 + 1)) tight++;
+        }
+        x += path.dxMm[i];
+        y += path.dyMm[i];
+    }
+    return tight;
+}
+
+} // namespace
+
+int main() {
+    CarriageGeometry geometry;
+    carriageGeometryInit(geometry, CELL_SIZE_MM, GAP_MM);
+    MotionLimits trapezoid = MOTION_LIMITS_DEFAULTS;
+    trapezoid.jerk = 0.0f;
+
+    double legacy = 0, planned = 0, plannedTrapezoid = 0;
+    int moves = 0, legs = 0, badProfiles = 0;
+    MotionPlan plan;
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            if (from == to) continue;
+            CarriagePath path;
+            carriageLanePath(geometry, from / 8, from % 8 + 1, to / 8, to % 8 + 1, path);
+            moves++;
+            legs += path.count;
+            for (int i = 0; i < path.count; i++) legacy += legacyLegSeconds(path.dxMm[i], path.dyMm[i]);
+
+            planPath(path, MOTION_LIMITS_DEFAULTS, plan);
+            if (!profileCoversPath(plan)) badProfiles++;
+            planned += motionPlanDuration(plan) + SEGMENT_PAUSE_S;
+            planPath(path, trapezoid, plan);
+            if (!profileCoversPath(plan)) badProfiles++;
+            plannedTrapezoid += motionPlanDuration(plan) + SEGMENT_PAUSE_S;
+        }
+    }
+    std::printf("%d square-to-square moves, %d legs\n", moves, legs);
+    std::printf("%-36s %8.1f s total %6.0f ms/move\n", "before: runSegment per leg", legacy, 1000 * legacy / moves);
+    std::printf("%-36s %8.1f s total %6.0f ms/move\n", "planned, trapezoid corners", plannedTrapezoid,
+                1000 * plannedTrapezoid / moves);
+    std::printf("%-36s %8.1f s total %6.0f ms/move (%.2fx faster)\n", "planned, S-curve (jerk limited)", planned,
+                1000 * planned / moves, legacy / planned);
+    check(badProfiles == 0, "planned speed profiles cover their paths within the limits");
+    check(planned < legacy, "planned paths are faster than stop-at-every-leg");
+    check(plannedTrapezoid <= planned, "jerk limiting only ever adds time");
+
+    // unloaded travel (to the piece to pick up, home, the captured piece): lanes vs straight across
+    double unloadedLanes = 0, unloadedDirect = 0;
+    bool capped = true;
+    for (int from = 0; from < 64; from++) {
+        for (int to = 0; to < 64; to++) {
+            if (from == to) continue;
+            CarriagePath path;
+            carriageLanePath(geometry, from / 8, from % 8 + 1, to / 8, to % 8 + 1, path);
+            planPath(path, MOTION_LIMITS_DEFAULTS, plan);
+            unloadedLanes += motionPlanDuration(plan) + SEGMENT_PAUSE_S;
+            carriageDirectPath(geometry, from / 8, from % 8 + 1, to / 8, to % 8 + 1, path);
+            planPath(path, MOTION_LIMITS_DEFAULTS, plan);
+            if (path.count != 1 || !profileCoversPath(plan)) badProfiles++;
+            // neither CoreXY motor may go faster than maxSpeed, diagonal or not
+            const MotionBlock &leg = plan.blocks[0];
+            float motor = leg.peakSpeed * std::fmax(std::fabs(leg.dxMm + leg.dyMm), std::fabs(leg.dxMm - leg.dyMm)) / leg.length;
+            capped = capped && motor <= MOTION_LIMITS_DEFAULTS.maxSpeed + 0.01f;
+            unloadedDirect += motionPlanDuration(plan) + SEGMENT_PAUSE_S;
+        }
+    }
+    std::printf("%-36s %8.1f s total %6.0f ms/move\n", "unloaded travel along the lanes", unloadedLanes,
+                1000 * unloadedLanes / moves);
+    std::printf("%-36s %8.1f s total %6.0f ms/move (%.2fx faster)\n", "unloaded travel straight across", unloadedDirect,
+                1000 * unloadedDirect / moves, unloadedLanes / unloadedDirect);
+    check(badProfiles == 0, "direct paths are single legs with valid profiles");
+    check(capped, "diagonal legs keep both motors within the speed limit");
+    check(unloadedDirect < unloadedLanes, "straight travel beats the lanes");
+
+    // carried pieces: the fixed lanes vs the clear path, for every legal move of the suite
+    {
+        int carries = 0, laneTight = 0, laneTightMoves = 0, clearTight = 0, clearTightMoves = 0, noPath = 0, wrongEnd = 0;
+        double laneSeconds = 0, clearSeconds = 0, searchNs = 0;
+        for (const char *fen : FENS) {
+            Position pos;
+            check(positionFromFen(pos, fen), "parse suite FEN");
+            MoveList list;
+            generateLegalMoves(pos, list);
+            for (int i = 0; i < list.count; i++) {
+                Move m = list.moves[i];
+                int from = moveFrom(m), to = moveTo(m);
+                CarriageObstacles obstacles = { pos.occupiedAll & ~squareBit(from), { 0, 0 } };
+                if (moveIsCapture(m)) obstacles.board &= ~squareBit(moveFlags(m) == MF_EP_CAPTURE
+                                                                     ? squareOf(squareRow(from), squareCol(to)) : to);
+                int fr = squareRow(from), fc = squareCol(from) + 1, tr = squareRow(to), tc = squareCol(to) + 1;
+                CarriagePath lanes, clear;
+                carriageLanePath(geometry, fr, fc, tr, tc, lanes);
+                auto searchStart = std::chrono::steady_clock::now();
+                bool found = carriageClearPath(geometry, obstacles, MOTION_LIMITS_DEFAULTS, fr, fc, tr, tc, clear);
+                searchNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - searchStart).count();
+                carries++;
+                int tight = tightPoints(geometry, obstacles, fr, fc, lanes);
+                laneTight += tight;
+                laneTightMoves += tight > 0;
+                if (!found) {
+                    noPath++;
+                    continue;
+                }
+                float ex = 0, ey = 0;
+                for (int k = 0; k < clear.count; k++) { ex += clear.dxMm[k]; ey += clear.dyMm[k]; }
+                if (std::fabs(ex - (tr - fr) * geometry.cellMm) > 0.01f ||
+                    std::fabs(ey - (geometry.colOffsets[tc] - geometry.colOffsets[fc])) > 0.01f) wrongEnd++;
+                tight = tightPoints(geometry, obstacles, fr, fc, clear);
+                clearTight += tight;
+                clearTightMoves += tight > 0;
+                planPath(lanes, MOTION_LIMITS_DEFAULTS, plan);
+                laneSeconds += motionPlanDuration(plan);
+                planPath(clear, MOTION_LIMITS_DEFAULTS, plan);
+                clearSeconds += motionPlanDuration(plan);
+            }
+        }
+        std::printf("carried moves: %d; tight points passed: lanes %d (%d moves), clear path %d (%d moves); %d without a path\n",
+                    carries, laneTight, laneTightMoves, clearTight, clearTightMoves, noPath);
+        std::printf("%-36s %8.0f ms/move along the lanes, %.0f ms/move clear path (%.0f us search)\n", "carried moves",
+                    1000 * laneSeconds / (carries - noPath), 1000 * clearSeconds / (carries - noPath),
+                    searchNs / carries / 1000);
+        check(wrongEnd == 0, "clear paths end on the target cell");
+        check(noPath == 0, "every carried move has a path");
+        check(clearTightMoves < laneTightMoves && clearTight < laneTight, "clear paths squeeze between fewer pieces");
+        check(clearSeconds <= laneSeconds, "clear paths are no slower than the lanes");
+    }
+
+    // step pulses: every lane path at the default limits, then the longest paths at five times the speed
+    {
+        int exact = 0, runs = 0;
+        double runSeconds = 0, plannedSeconds = 0, worstOver = 0;
+        for (int from = 0; from < 64; from++) {
+            for (int to = 0; to < 64; to++) {
+                if (from == to) continue;
+                CarriagePath path;
+                carriageLanePath(geometry, from / 8, from % 8 + 1, to / 8, to % 8 + 1, path);
+                planPath(path, MOTION_LIMITS_DEFAULTS, plan);
+                StepRun run = runSteps(plan);
+                runs++;
+                exact += stepRunExact(run);
+                double seconds = run.ticks * STEP_TICK_US * 1e-6, duration = motionPlanDuration(plan);
+                runSeconds += seconds;
+                plannedSeconds += duration;
+                if (seconds - duration > worstOver) worstOver = seconds - duration;
+            }
+        }
+        std::printf("step generator: %d/%d lane paths exact, run %.1f s vs planned %.1f s (worst %.1f ms over)\n",
+                    exact, runs, runSeconds, plannedSeconds, 1000 * worstOver);
+        check(exact == runs, "step counts, pulse spacing and directions are exact on every lane path");
+        // a block ends on its last step, which is half a step before the profile comes to rest
+        check(runSeconds > 0.97 * plannedSeconds && worstOver < STEP_SEGMENT_TICKS * STEP_TICK_US * 1e-6,
+              "step runs keep to the planned time");
+
+        MotionLimits fast = { 5 * MOTION_LIMITS_DEFAULTS.maxSpeed, 10 * MOTION_LIMITS_DEFAULTS.accel,
+                              100 * MOTION_LIMITS_DEFAULTS.jerk, MOTION_LIMITS_DEFAULTS.junctionDeviation };
+        CarriagePath far;
+        carriageLanePath(geometry, 0, 0, 7, CARRIAGE_COLS - 1, far);
+        planPath(far, fast, plan);
+        StepRun lanes = runSteps(plan);
+        carriageDirectPath(geometry, 0, 0, 7, CARRIAGE_COLS - 1, far);
+        planPath(far, fast, plan);
+        StepRun direct = runSteps(plan);
+        std::printf("step generator at %.0f mm/s: peak %u steps/s along the lanes, %u steps/s straight across "
+                    "(old follower: 1500)\n", fast.maxSpeed, lanes.peakStepsPerSecond, direct.peakStepsPerSecond);
+        check(stepRunExact(lanes) && stepRunExact(direct), "fast runs are exact");
+        check(lanes.peakStepsPerSecond > 3 * 1500 && direct.peakStepsPerSecond > 3 * 1500,
+              "fast runs step well beyond the old follower's 1500 steps/s");
+
+        StepPathCursor cursor;
+        stepPathBegin(cursor, plan, STEPS_PER_MM, 2.0f);
+        StepSegment segment;
+        bool more = stepPathNext(cursor, segment);
+        uint32_t ticks = 0;
+        auto tickStart = std::chrono::steady_clock::now();
+        while (more || !stepGeneratorIdle(stepGen)) {
+            while (more && stepGeneratorPush(stepGen, segment)) more = stepPathNext(cursor, segment);
+            sink += stepGeneratorTick(stepGen).step;
+            ticks++;
+        }
+        double tickNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - tickStart).count() / ticks;
+        std::printf("%-36s %8.1f ns/tick (incl. cutting segments; tick period %u us)\n", "step generator",
+                    tickNs, unsigned(STEP_TICK_US));
+    }
+
+    // whole opponent moves from home: the captured piece to its scrap column, the piece, the rook
+    {
+        CarryTimer timer = { geometry, { 0, { 0, 0 } }, PickPlace(), 0, 0, 0, 0 };
+        int moveCount = 0, captureCount = 0;
+        double captureSaved = 0;
+        for (const char *fen : FENS) {
+            Position pos;
+            check(positionFromFen(pos, fen), "parse suite FEN");
+            MoveList list;
+            generateLegalMoves(pos, list);
+            for (int i = 0; i < list.count; i++) {
+                Move m = list.moves[i];
+                int from = moveFrom(m), to = moveTo(m);
+                double savedBefore = timer.before - timer.after;
+                pickPlaceInit(timer.pickPlace);
+                timer.row = timer.col = 0;
+                timer.obstacles.board = pos.occupiedAll;
+                if (moveIsCapture(m)) {
+                    int capSq = moveFlags(m) == MF_EP_CAPTURE ? squareOf(squareRow(from), squareCol(to)) : to;
+                    int scrapCol = pieceColor(pos.board[capSq]) == PIECE_WHITE ? 0 : CARRIAGE_COLS - 1;
+                    timer.obstacles.board &= ~squareBit(capSq);
+                    timeCarry(timer, squareRow(capSq), squareCol(capSq) + 1, squareRow(capSq), scrapCol);
+                }
+                timer.obstacles.board &= ~squareBit(from);
+                timeCarry(timer, squareRow(from), squareCol(from) + 1, squareRow(to), squareCol(to) + 1);
+                timer.obstacles.board |= squareBit(to);
+                if (moveIsCastle(m)) {
+                    int rookFrom = moveFlags(m) == MF_KING_CASTLE ? to + 1 : to - 2;
+                    int rookTo = moveFlags(m) == MF_KING_CASTLE ? to - 1 : to + 1;
+                    timer.obstacles.board &= ~squareBit(rookFrom);
+                    timeCarry(timer, squareRow(rookFrom), squareCol(rookFrom) + 1, squareRow(rookTo), squareCol(rookTo) + 1);
+                }
+                moveCount++;
+                if (moveIsCapture(m)) {
+                    captureCount++;
+                    captureSaved += timer.before - timer.after - savedBefore;
+                }
+            }
+        }
+        double saved = (timer.before - timer.after) / moveCount;
+        std::printf("%-36s %8.0f ms/move fixed servo waits, %.0f ms/move overlapped (%.0f ms saved)\n",
+                    "opponent moves (robot time)", 1000 * timer.before / moveCount, 1000 * timer.after / moveCount,
+                    1000 * saved);
+        std::printf("%-36s %8.0f ms saved per capture (two carries)\n", "", 1000 * captureSaved / captureCount);
+        check(saved > 0.5, "overlapping the arm with the carriage saves at least half a second per move");
+    }
+
+    // tuning: a board whose magnet loses the piece above slipAccel must settle one step below the
+    // fastest trial at or below it (or on the range's end), whether the start passes or not
+    {
+        const float SLIPS[] = { 60.0f, 140.0f, 400.0f, 5000.0f, 10.0f };
+        bool converged = true;
+        for (float slipAccel : SLIPS) {
+            MotionTuner tuner;
+            motionTunerBegin(tuner, MOTION_PROFILES_DEFAULTS.limits[MOTION_LOAD_HEAVY]);
+            while (!tuner.done) motionTunerResult(tuner, tuner.trial.accel <= slipAccel);
+            bool ok = slipAccel < TUNE_MIN.accel
+                ? !tuner.passed
+                : tuner.passed && (tuner.safe.accel >= TUNE_MAX.accel ||
+                                   (tuner.safe.accel * TUNE_STEP <= slipAccel * 1.001f &&
+                                    (tuner.safe.accel * TUNE_STEP * TUNE_STEP > slipAccel || tuner.safe.accel <= TUNE_MIN.accel)));
+            std::printf("tuning against slip at %6.0f mm/s^2: %s %.0f mm/s, %.0f mm/s^2 after %d trials\n", slipAccel,
+                        tuner.passed ? "kept" : "nothing passed,", tuner.safe.maxSpeed, tuner.safe.accel, tuner.trials);
+            converged = converged && ok;
+        }
+        check(converged, "the tuner keeps a step below the fastest trial under the slip point");
+        MotionProfiles profiles = MOTION_PROFILES_DEFAULTS;
+        check(motionProfilesValid(profiles), "default profiles are valid");
+        profiles.limits[MOTION_LOAD_EMPTY].accel = 0.0f;
+        check(!motionProfilesValid(profiles), "out-of-range stored profiles are rejected");
+        check(motionLoadOf(pieceCode(PIECE_BLACK, QUEEN)) == MOTION_LOAD_HEAVY &&
+              motionLoadOf(pieceCode(PIECE_WHITE, PAWN)) == MOTION_LOAD_LIGHT && motionLoadOf(NO_PIECE) == MOTION_LOAD_EMPTY,
+              "load classes");
+    }
+
+    // board setup: back to the start position, and from the start position to the suite's positions
+    {
+        Position startPos;
+        check(positionFromFen(startPos, FENS[0]), "parse start FEN");
+        int setups = 0, valid = 0, parked = 0, missing = 0, steps = 0;
+        double plannedMm = 0, firstFitMm = 0, seconds = 0, planNs = 0;
+        SetupPlan setup;
+        auto runSetup = [&](const SetupCells &cells, const Position &target) {
+            auto t0 = std::chrono::steady_clock::now();
+            bool ok = planBoardSetup(geometry, MOTION_LIMITS_DEFAULTS, cells, target, 0, 0, setup);
+            planNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+            float mm = 0;
+            setups++;
+            if (!ok || !replaySetup(geometry, cells, target, setup, mm)) return;
+            valid++;
+            steps += setup.count;
+            missing += setup.missingCount;
+            for (int i = 0; i < setup.count; i++) parked += setup.steps[i].parking;
+            plannedMm += mm;
+            firstFitMm += firstFitSetupMm(geometry, cells, target);
+            seconds += setup.seconds;
+        };
+        // after a game: the suite's positions, their captured pieces down the capture columns
+        for (const char *fen : FENS) {
+            Position pos;
+            check(positionFromFen(pos, fen), "parse suite FEN");
+            SetupCells cells;
+            setupCellsFromPosition(pos, cells);
+            int counts[NO_PIECE] = {}, rows[2] = { 0, 0 };
+            for (int sq = 0; sq < 64; sq++) {
+                if (startPos.board[sq] != NO_PIECE) counts[startPos.board[sq]]++;
+                if (pos.board[sq] != NO_PIECE) counts[pos.board[sq]]--;
+            }
+            for (uint8_t piece = 0; piece < NO_PIECE; piece++) {
+                for (int k = 0; k < counts[piece]; k++) {
+                    int side = pieceColor(piece) == PIECE_WHITE ? 0 : 1;
+                    if (rows[side] < CARRIAGE_ROWS) cells.piece[setupCell(rows[side]++, side ? CARRIAGE_COLS - 1 : 0)] = piece;
+                }
+            }
+            runSetup(cells, startPos);
+            setupCellsFromPosition(startPos, cells);
+            runSetup(cells, pos);
+        }
+        // the start position's pieces shuffled over the board
+        uint32_t seed = 12345;
+        for (int round = 0; round < 20; round++) {
+            uint8_t pieces[64];
+            for (int sq = 0; sq < 64; sq++) pieces[sq] = startPos.board[sq];
+            for (int sq = 63; sq > 0; sq--) {
+                seed = seed * 1664525u + 1013904223u;
+                int other = int((seed >> 8) % uint32_t(sq + 1));
+                uint8_t t = pieces[sq]; pieces[sq] = pieces[other]; pieces[other] = t;
+            }
+            SetupCells cells;
+            setupCellsFromPosition(startPos, cells);
+            for (int sq = 0; sq < 64; sq++) cells.piece[setupCellOfSquare(sq)] = pieces[sq];
+            runSetup(cells, startPos);
+        }
+        std::printf("board setups: %d/%d valid, %d steps (%d parked), %d pieces missing\n", valid, setups, steps, parked,
+                    missing);
+        std::printf("%-36s %8.0f mm first-fit, %.0f mm assigned (%.2fx less); %.1f s/setup planned, %.1f ms to plan\n",
+                    "board setup travel", firstFitMm, plannedMm, firstFitMm / plannedMm, seconds / valid,
+                    planNs / setups / 1e6);
+        check(valid == setups && missing == 0, "every setup plan is valid and complete");
+        check(plannedMm < firstFitMm, "assigned setups travel less than first-fit ones");
+    }
+
+    // graveyard: random games where the robot makes every capture and promotion, then a reset
+    {
+        Position startPos;
+        positionFromFen(startPos, FENS[0]);
+        int games = 0, captures = 0, collisions = 0, misplaced = 0, overflow = 0, promotions = 0, fetched = 0;
+        int resetsValid = 0, missing = 0, badMissing = 0;
+        double slotMm = 0, fixedMm = 0;
+        uint32_t seed = 777;
+        for (int game = 0; game < 200; game++) {
+            Position pos = startPos;
+            Graveyard g;
+            graveyardClear(g);
+            bool fixedUsed[2][CARRIAGE_ROWS] = {};
+            for (int ply = 0; ply < 120; ply++) {
+                MoveList list;
+                generateLegalMoves(pos, list);
+                if (list.count == 0) break;
+                seed = seed * 1664525u + 1013904223u;
+                Move move = list.moves[(seed >> 8) % uint32_t(list.count)];
+                int from = moveFrom(move), to = moveTo(move), row, col;
+                if (moveIsCapture(move)) {
+                    int capSq = moveFlags(move) == MF_EP_CAPTURE ? squareOf(squareRow(from), squareCol(to)) : to;
+                    uint8_t piece = pos.board[capSq];
+                    int own = pieceColor(piece) == PIECE_WHITE ? 0 : 1;
+                    captures++;
+                    if (fixedUsed[own][squareRow(capSq)]) collisions++;
+                    fixedUsed[own][squareRow(capSq)] = true;
+                    fixedMm += cellDistanceMm(geometry, setupCellOfSquare(capSq), setupCell(squareRow(capSq), graveyardColumn(own)));
+                    if (graveyardFreeSlot(g, piece, squareRow(capSq), row, col)) {
+                        bool ownFull = true;
+                        for (int r = 0; r < CARRIAGE_ROWS; r++) ownFull = ownFull && g.piece[own][r] != NO_PIECE;
+                        if (g.piece[graveyardSide(col)][row] != NO_PIECE || (graveyardSide(col) != own && !ownFull)) misplaced++;
+                        graveyardPut(g, row, col, piece);
+                        slotMm += cellDistanceMm(geometry, setupCellOfSquare(capSq), setupCell(row, col));
+                    } else {
+                        overflow++;   // taken off by hand
+                    }
+                }
+                if (moveIsPromotion(move)) {
+                    uint8_t promoted = pieceCode(pos.sideToMove, movePromotionType(move));
+                    promotions++;
+                    if (graveyardFind(g, promoted, squareRow(to), row, col)) {
+                        fetched++;
+                        if (graveyardTake(g, row, col) != promoted) misplaced++;
+                        if (!graveyardFreeSlot(g, pos.board[from], squareRow(from), row, col)) misplaced++;
+                        else graveyardPut(g, row, col, pos.board[from]);
+                    }
+                }
+                UndoInfo undo;
+                makeMove(pos, move, undo);
+            }
+            // reset: what the board and the graveyard hold against what the start position needs
+            SetupCells cells;
+            setupCellsFromPosition(pos, cells);
+            setupCellsAddGraveyard(g, cells);
+            int have[NO_PIECE] = {}, expected = 0;
+            for (int cell = 0; cell < SETUP_CELLS; cell++) {
+                if (cells.piece[cell] != NO_PIECE) have[cells.piece[cell]]++;
+            }
+            for (int sq = 0; sq < 64; sq++) {
+                if (startPos.board[sq] != NO_PIECE && have[startPos.board[sq]]-- <= 0) expected++;
+            }
+            SetupPlan setup;
+            float mm;
+            games++;
+            if (planBoardSetup(geometry, MOTION_LIMITS_DEFAULTS, cells, startPos, 0, 0, setup) &&
+                replaySetup(geometry, cells, startPos, setup, mm)) {
+                resetsValid++;
+                missing += setup.missingCount;
+                if (setup.missingCount != expected) badMissing++;
+            }
+        }
+        std::printf("graveyard: %d games, %d captures: fixed cell per rank collided %d times, allocator %d "
+                    "(%d taken off with both columns full)\n", games, captures, collisions, misplaced, overflow);
+        std::printf("%-36s %8.1f mm fixed cell (stacking), %.1f mm free slot per capture; %d/%d promotions fetched\n",
+                    "graveyard carry", fixedMm / captures, slotMm / (captures - overflow), fetched, promotions);
+        std::printf("graveyard resets: %d/%d valid, %d pieces left for hand placement\n", resetsValid, games, missing);
+        check(misplaced == 0, "graveyard slots are free, own column first, promotions swap pieces");
+        check(resetsValid == games && badMissing == 0, "resets use the graveyard and miss only pieces taken off by hand");
+    }
+
+    // straight legs run through at full speed, a reversal stops
+    MotionPlan line;
+    motionPlanBegin(line);
+    motionPlanAdd(line, 10.0f, 0.0f);
+    motionPlanAdd(line, 10.0f, 0.0f);
+    motionPlanAdd(line, -5.0f, 0.0f);
+    motionPlanFinish(line);
+    check(line.blocks[1].entrySpeed > 0.9f * MOTION_LIMITS_DEFAULTS.maxSpeed, "straight junction keeps its speed");
+    check(line.blocks[2].entrySpeed == 0.0f, "reversal junction stops");
+
+    CarriagePath longest;
+    carriageLanePath(geometry, 0, 1, 7, 8, longest);
+    auto start = std::chrono::steady_clock::now();
+    const int PLANS = 20000;
+    for (int i = 0; i < PLANS; i++) {
+        planPath(longest, MOTION_LIMITS_DEFAULTS, plan);
+        sink += plan.blocks[0].peakSpeed;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / PLANS;
+    std::printf("%-36s %8.1f ns/call\n", "plan a 6-leg path", ns);
+
+    std::printf("%d check failure(s)\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,48 @@
+#include "hal_host.h"
+#include <chrono>
+
+namespace {
+
+const int MAX_PINS = 64;
+
+bool pinLevels[MAX_PINS];
+HalReadHook readHook = nullptr;
+uint64_t delayedMicros = 0;
+uint32_t lastWriteMicros = 0;
+const std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+uint64_t elapsedMicros() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - startTime).count()) + delayedMicros;
+}
+
+} // namespace
+
+void halHostSetReadHook(HalReadHook hook) { readHook = hook; }
+bool halHostPinLevel(int pin) { return pin >= 0 && pin < MAX_PINS && pinLevels[pin]; }
+uint32_t halHostLastWriteMicros() { return lastWriteMicros; }
+uint64_t halHostDelayedMicros() { return delayedMicros; }
+
+void halPinWrite(int pin, bool high) {
+    if (pin < 0 || pin >= MAX_PINS || pinLevels[pin] == high) return;
+    pinLevels[pin] = high;
+    lastWriteMicros = halMicros();
+}
+
+void halPinsWrite(uint64_t highMask, uint64_t lowMask) {
+    for (int pin = 0; pin < MAX_PINS; pin++) {
+        uint64_t bit = uint64_t(1) << pin;
+        if (highMask & bit) halPinWrite(pin, true);
+        else if (lowMask & bit) halPinWrite(pin, false);
+    }
+}
+
+bool halPinRead(int pin) {
+    if (readHook) return readHook(pin);
+    return halHostPinLevel(pin);
+}
+
+void halDelayMicros(uint32_t us) { delayedMicros += us; }
+void halDelayMillis(uint32_t ms) { delayedMicros += uint64_t(ms) * 1000; }
+uint32_t halMillis() { return uint32_t(elapsedMicros() / 1000); }
+uint32_t halMicros() { return uint32_t(elapsedMicros()); }
@@ -0,0 +1,17 @@
+#pragma once
+
+// Host-side hooks for the simulated HAL (hal_host.cpp).
+// Output pins just latch their level; input reads go to a hook so a program can model the hardware
+// (e.g. the reed muxes). Delays advance a virtual clock instead of sleeping, so host runs measure
+// logic cost only, while halMicros()/halMillis() still reflect the time the firmware would have waited.
+
+#include "board_hal.h"
+
+typedef bool (*HalReadHook)(int pin);
+
+void halHostSetReadHook(HalReadHook hook);
+bool halHostPinLevel(int pin);
+// halMicros() at the last output change, so a read hook can model signals that need time to settle.
+uint32_t halHostLastWriteMicros();
+// Total time spent in halDelayMicros / halDelayMillis since start-up, in microseconds.
+uint64_t halHostDelayedMicros();
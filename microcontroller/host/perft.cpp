@@ -0,0 +1,91 @@
+// Host-side perft: checks the legal move generator against published node counts
+// and reports nodes/second.
+//
+//   g++ -O2 -std=c++11 -I.. perft.cpp ../chess_position.cpp ../chess_movegen.cpp ../chess_attacks.cpp -o perft
+//   ./perft                      # standard suite, exit code 1 on any mismatch
+//   ./perft "<fen>" <depth>      # single position, per-move breakdown (divide)
+
+#include "chess_position.h"
+#include "chess_movegen.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+struct PerftCase {
+    const char *name;
+    const char *fen;
+    int depth;
+    uint64_t expected;
+};
+
+// Reference counts from the chessprogramming.org perft results page.
+const PerftCase SUITE[] = {
+    { "startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609ULL },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL },
+    { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 5, 674624ULL },
+    { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4, 422333ULL },
+    { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ULL },
+    { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL },
+};
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int runDivide(const char *fen, int depth) {
+    Position pos;
+    if (!positionFromFen(pos, fen)) {
+        std::fprintf(stderr, "bad FEN: %s\n", fen);
+        return 2;
+    }
+    MoveList list;
+    generateLegalMoves(pos, list);
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < list.count; i++) {
+        Move m = list.moves[i];
+        UndoInfo undo;
+        makeMove(pos, m, undo);
+        uint64_t nodes = depth > 1 ? perft(pos, depth - 1) : 1;
+        unmakeMove(pos, m, undo);
+        char from[3], to[3];
+        squareName(moveFrom(m), from);
+        squareName(moveTo(m), to);
+        const char promo[] = "nbrq";
+        std::printf("%s%s%c: %llu\n", from, to, moveIsPromotion(m) ? promo[movePromotionType(m) - KNIGHT] : ' ',
+                    (unsigned long long)nodes);
+        total += nodes;
+    }
+    double secs = secondsSince(start);
+    std::printf("\nnodes %llu  time %.3fs  %.0f nodes/s\n", (unsigned long long)total, secs, secs > 0 ? total / secs : 0.0);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc >= 3) return runDivide(argv[1], std::atoi(argv[2]));
+
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalSecs = 0;
+    for (const PerftCase &c : SUITE) {
+        Position pos;
+        positionFromFen(pos, c.fen);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t nodes = perft(pos, c.depth);
+        double secs = secondsSince(start);
+        bool ok = nodes == c.expected;
+        if (!ok) failures++;
+        totalNodes += nodes;
+        totalSecs += secs;
+        std::printf("%-10s depth %d  %10llu nodes  %s  %8.3fs  %12.0f nodes/s\n", c.name, c.depth,
+                    (unsigned long long)nodes, ok ? "ok  " : "FAIL", secs, secs > 0 ? nodes / secs : 0.0);
+        if (!ok) std::printf("           expected %llu\n", (unsigned long long)c.expected);
+    }
+    std::printf("total %llu nodes in %.3fs (%.0f nodes/s), %d failure(s)\n", (unsigned long long)totalNodes,
+                totalSecs, totalSecs > 0 ? totalNodes / totalSecs : 0.0, failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,152 @@
+#include "motion_planner.h"
+#include <math.h>
+
+namespace {
+
+const int SEARCH_STEPS = 24;
+
+float transitionDistance(const MotionLimits &limits, float v0, float v1) {
+    return 0.5f * (v0 + v1) * motionTransitionTime(limits, v0, v1);
+}
+
+// Highest speed up to cap reachable from v0 (up or down alike) within length.
+float reachableSpeed(const MotionLimits &limits, float v0, float length, float cap) {
+    if (cap <= v0 || transitionDistance(limits, v0, cap) <= length) return cap;
+    float lo = v0, hi = cap;
+    for (int i = 0; i < SEARCH_STEPS; i++) {
+        float mid = 0.5f * (lo + hi);
+        if (transitionDistance(limits, v0, mid) <= length) lo = mid;
+        else hi = mid;
+    }
+    return lo;
+}
+
+float junctionSpeed(const MotionLimits &limits, const MotionBlock &prev, const MotionBlock &next) {
+    // cosTheta is the cosine of the angle between the reversed entry direction and the exit direction
+    float cosTheta = -(prev.dxMm * next.dxMm + prev.dyMm * next.dyMm) / (prev.length * next.length);
+    if (cosTheta > 0.999f) return 0.0f;              // reversal
+    float cap = prev.maxSpeed < next.maxSpeed ? prev.maxSpeed : next.maxSpeed;
+    if (cosTheta < -0.999f) return cap;              // straight on
+    float sinHalf = sqrtf(0.5f * (1.0f - cosTheta));
+    float speed = sqrtf(limits.accel * limits.junctionDeviation * sinHalf / (1.0f - sinHalf));
+    return speed < cap ? speed : cap;
+}
+
+// Speed at t into a transition from v0 to v1 lasting duration.
+float transitionSpeed(const MotionLimits &limits, float v0, float v1, float duration, float t) {
+    float sign = v1 >= v0 ? 1.0f : -1.0f;
+    float dv = fabsf(v1 - v0);
+    float change;
+    if (limits.jerk <= 0.0f) {
+        change = limits.accel * t;
+    } else {
+        float rampTime = limits.accel / limits.jerk;
+        if (rampTime > 0.5f * duration) rampTime = 0.5f * duration;
+        float peakAccel = limits.jerk * rampTime;
+        if (t < rampTime) {
+            change = 0.5f * limits.jerk * t * t;
+        } else if (t < duration - rampTime) {
+            change = 0.5f * limits.jerk * rampTime * rampTime + peakAccel * (t - rampTime);
+        } else {
+            float left = duration - t;
+            change = dv - 0.5f * limits.jerk * left * left;
+        }
+    }
+    if (change > dv) change = dv;
+    return v0 + sign * change;
+}
+
+void profileBlock(const MotionLimits &limits, MotionBlock &block) {
+    float v0 = block.entrySpeed, v1 = block.exitSpeed;
+    float floor = v0 > v1 ? v0 : v1;
+    float peak = block.maxSpeed;
+    float need = transitionDistance(limits, v0, peak) + transitionDistance(limits, peak, v1);
+    if (need > block.length) {
+        float lo = floor, hi = block.maxSpeed;
+        for (int i = 0; i < SEARCH_STEPS; i++) {
+            float mid = 0.5f * (lo + hi);
+            if (transitionDistance(limits, v0, mid) + transitionDistance(limits, mid, v1) <= block.length) lo = mid;
+            else hi = mid;
+        }
+        peak = lo;
+        need = transitionDistance(limits, v0, peak) + transitionDistance(limits, peak, v1);
+    }
+    block.peakSpeed = peak;
+    block.accelTime = motionTransitionTime(limits, v0, peak);
+    block.decelTime = motionTransitionTime(limits, peak, v1);
+    float rest = block.length - need;
+    block.cruiseTime = (rest > 0.0f && peak > 0.0f) ? rest / peak : 0.0f;
+}
+
+} // namespace
+
+float motionTransitionTime(const MotionLimits &limits, float fromSpeed, float toSpeed) {
+    float dv = fabsf(toSpeed - fromSpeed);
+    if (limits.jerk <= 0.0f) return dv / limits.accel;
+    // full S-curve: ramp in, hold the acceleration, ramp out; too small a change never reaches it
+    if (dv * limits.jerk >= limits.accel * limits.accel) return dv / limits.accel + limits.accel / limits.jerk;
+    return 2.0f * sqrtf(dv / limits.jerk);
+}
+
+void motionPlanBegin(MotionPlan &plan, const MotionLimits &limits) {
+    plan.limits = limits;
+    plan.count = 0;
+}
+
+bool motionPlanAdd(MotionPlan &plan, float dxMm, float dyMm) {
+    float length = sqrtf(dxMm * dxMm + dyMm * dyMm);
+    if (length < 1e-4f) return true;
+    if (plan.count == MOTION_PLAN_MAX_BLOCKS) return false;
+    MotionBlock &block = plan.blocks[plan.count++];
+    block.dxMm = dxMm;
+    block.dyMm = dyMm;
+    block.length = length;
+    float fastest = fabsf(dxMm + dyMm) > fabsf(dxMm - dyMm) ? fabsf(dxMm + dyMm) : fabsf(dxMm - dyMm);
+    block.maxSpeed = plan.limits.maxSpeed * length / fastest;
+    return true;
+}
+
+void motionPlanFinish(MotionPlan &plan) {
+    const MotionLimits &limits = plan.limits;
+    int n = plan.count;
+    if (n == 0) return;
+    // corner limits as entry speeds; the path starts and ends at rest
+    plan.blocks[0].entrySpeed = 0.0f;
+    for (int i = 1; i < n; i++) plan.blocks[i].entrySpeed = junctionSpeed(limits, plan.blocks[i - 1], plan.blocks[i]);
+
+    // backward: every block must be able to slow down to the next block's entry
+    float exit = 0.0f;
+    for (int i = n - 1; i >= 0; i--) {
+        MotionBlock &block = plan.blocks[i];
+        block.exitSpeed = exit;
+        block.entrySpeed = reachableSpeed(limits, exit, block.length, block.entrySpeed);
+        exit = block.entrySpeed;
+    }
+    // forward: and to reach its exit from its entry
+    plan.blocks[0].entrySpeed = 0.0f;
+    for (int i = 0; i < n; i++) {
+        MotionBlock &block = plan.blocks[i];
+        block.exitSpeed = reachableSpeed(limits, block.entrySpeed, block.length, block.exitSpeed);
+        if (i + 1 < n) plan.blocks[i + 1].entrySpeed = block.exitSpeed;
+        profileBlock(limits, block);
+    }
+}
+
+float motionBlockDuration(const MotionBlock &block) {
+    return block.accelTime + block.cruiseTime + block.decelTime;
+}
+
+float motionPlanDuration(const MotionPlan &plan) {
+    float total = 0.0f;
+    for (int i = 0; i < plan.count; i++) total += motionBlockDuration(plan.blocks[i]);
+    return total;
+}
+
+float motionBlockSpeedAt(const MotionPlan &plan, const MotionBlock &block, float t) {
+    if (t < block.accelTime) return transitionSpeed(plan.limits, block.entrySpeed, block.peakSpeed, block.accelTime, t);
+    t -= block.accelTime;
+    if (t < block.cruiseTime) return block.peakSpeed;
+    t -= block.cruiseTime;
+    if (t < block.decelTime) return transitionSpeed(plan.limits, block.peakSpeed, block.exitSpeed, block.decelTime, t);
+    return block.exitSpeed;
+}
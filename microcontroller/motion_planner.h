@@ -0,0 +1,55 @@
+#pragma once
+
+// Look-ahead planning of one carriage path (a run of consecutive segments, e.g. a lane path).
+// The old runSegment started and stopped every leg; here the legs become blocks that run into
+// each other at a corner speed, as in the junction-deviation planners of grbl / Marlin:
+//   - the corner speed between two blocks is the one at which the change of direction is no worse
+//     than rounding the corner with radius set by junctionDeviation at the full acceleration
+//     (a straight continuation keeps full speed, a reversal has to stop);
+//   - a backward then a forward pass lower the corner speeds until every block can reach its exit
+//     speed from its entry speed within its length; the path starts and ends at rest;
+//   - every speed change is an S-curve: the acceleration ramps in and out at the jerk limit
+//     instead of stepping, which is what shakes a dragged piece loose (jerk 0 = trapezoidal).
+// Speeds are along the path, in mm/s. maxSpeed is what each CoreXY motor may do (A = x + y,
+// B = x - y): a leg on an axis moves both motors at the path speed, while on a diagonal one motor
+// does the work of both, so such a block is capped to keep that motor within maxSpeed.
+
+const int MOTION_PLAN_MAX_BLOCKS = 16;
+
+struct MotionLimits {
+    float maxSpeed;            // mm/s
+    float accel;               // mm/s^2
+    float jerk;                // mm/s^3, 0 = no jerk limit
+    float junctionDeviation;   // mm
+};
+
+// 30 mm/s and 150 mm/s^2 are the old runSegment's top speed and ramp (1500 steps/s over 0.2 s)
+const MotionLimits MOTION_LIMITS_DEFAULTS = { 30.0f, 150.0f, 3000.0f, 0.1f };
+
+struct MotionBlock {
+    float dxMm, dyMm;
+    float length;
+    float maxSpeed;                           // CoreXY cap for this block's direction
+    float entrySpeed, peakSpeed, exitSpeed;
+    float accelTime, cruiseTime, decelTime;   // s
+};
+
+struct MotionPlan {
+    MotionLimits limits;
+    MotionBlock blocks[MOTION_PLAN_MAX_BLOCKS];
+    int count;
+};
+
+void motionPlanBegin(MotionPlan &plan, const MotionLimits &limits = MOTION_LIMITS_DEFAULTS);
+// Appends a segment; zero-length ones are dropped. False when the plan is full.
+bool motionPlanAdd(MotionPlan &plan, float dxMm, float dyMm);
+// Corner speeds, look-ahead passes and every block's speed profile.
+void motionPlanFinish(MotionPlan &plan);
+
+float motionBlockDuration(const MotionBlock &block);
+float motionPlanDuration(const MotionPlan &plan);
+// Planned speed t seconds into the block (its exit speed once t is past the end).
+float motionBlockSpeedAt(const MotionPlan &plan, const MotionBlock &block, float t);
+
+// Time of one speed change under the limits; its distance is the mean speed times this.
+float motionTransitionTime(const MotionLimits &limits, float fromSpeed, float toSpeed);
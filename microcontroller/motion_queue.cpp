@@ -0,0 +1,50 @@
+#include "motion_queue.h"
+
+MotionCommand motionSegment(float dxMm, float dyMm, uint8_t load) {
+    MotionCommand command = { MOTION_SEGMENT, 0, 0, 0, load, dxMm, dyMm };
+    return command;
+}
+
+MotionCommand motionServo(int angle, uint16_t leadMs) {
+    MotionCommand command = { MOTION_SERVO, uint8_t(angle < 0 ? 0 : angle > 180 ? 180 : angle), 0, leadMs, 0, 0.0f, 0.0f };
+    return command;
+}
+
+MotionCommand motionDwell(uint16_t ms) {
+    MotionCommand command = { MOTION_DWELL, 0, ms, 0, 0, 0.0f, 0.0f };
+    return command;
+}
+
+bool motionQueuePush(MotionQueue &queue, const MotionCommand &command) {
+    uint32_t head = queue.head.load(std::memory_order_relaxed);
+    if (head - queue.tail.load(std::memory_order_acquire) >= MOTION_QUEUE_CAPACITY) return false;
+    queue.commands[head % MOTION_QUEUE_CAPACITY] = command;
+    queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+uint32_t motionQueueFree(const MotionQueue &queue) {
+    return MOTION_QUEUE_CAPACITY - (queue.head.load(std::memory_order_relaxed) -
+                                    queue.tail.load(std::memory_order_acquire));
+}
+
+bool motionQueueIdle(const MotionQueue &queue) {
+    return queue.head.load(std::memory_order_relaxed) == queue.tail.load(std::memory_order_acquire);
+}
+
+bool motionQueueFront(const MotionQueue &queue, MotionCommand &out) {
+    return motionQueuePeek(queue, 0, out);
+}
+
+bool motionQueuePeek(const MotionQueue &queue, uint32_t offset, MotionCommand &out) {
+    uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (queue.head.load(std::memory_order_acquire) - tail <= offset) return false;
+    out = queue.commands[(tail + offset) % MOTION_QUEUE_CAPACITY];
+    return true;
+}
+
+void motionQueuePop(MotionQueue &queue, uint32_t count) {
+    uint32_t tail = queue.tail.load(std::memory_order_relaxed);
+    uint32_t queued = queue.head.load(std::memory_order_acquire) - tail;
+    queue.tail.store(tail + (count < queued ? count : queued), std::memory_order_release);
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Bounded queue of carriage commands between loop() (which plans a whole opponent move at once)
+// and the motion task (which executes them one at a time). Single producer, single consumer, no
+// locks: the producer owns head, the consumer owns tail, each only ever advances its own index.
+// The consumer reads the command at the front, executes it and only then pops it, so the queue
+// is idle exactly when the carriage is: no command waiting and none in progress.
+
+#include <atomic>
+#include <stdint.h>
+
+const uint32_t MOTION_QUEUE_CAPACITY = 64;   // a capture + move + castling rook is about 40 commands
+
+enum MotionCommandKind : uint8_t {
+    MOTION_SEGMENT = 0,   // relative carriage move in mm (x = rows, y = columns)
+    MOTION_SERVO = 1,     // set the magnet arm angle
+    MOTION_DWELL = 2      // wait, e.g. for the servo to get there
+};
+
+struct MotionCommand {
+    uint8_t kind;         // MotionCommandKind
+    uint8_t servoAngle;   // MOTION_SERVO
+    uint16_t dwellMs;     // MOTION_DWELL
+    uint16_t leadMs;      // MOTION_SERVO: arm travel time; may start that early, while the path before it stops
+    uint8_t load;         // MOTION_SEGMENT: what the magnet carries, MotionLoad (motion_tuning.h)
+    float dxMm, dyMm;     // MOTION_SEGMENT
+};
+
+struct MotionQueue {
+    std::atomic<uint32_t> head;   // commands pushed so far (producer)
+    std::atomic<uint32_t> tail;   // commands finished so far (consumer)
+    MotionCommand commands[MOTION_QUEUE_CAPACITY];
+};
+
+MotionCommand motionSegment(float dxMm, float dyMm, uint8_t load = 0);
+// leadMs > 0: the write may go out up to leadMs before the preceding path stops (see pick_place.h);
+// whatever of leadMs is left once the carriage stands is waited out before the next command.
+MotionCommand motionServo(int angle, uint16_t leadMs = 0);
+MotionCommand motionDwell(uint16_t ms);
+
+// Producer side. False (and nothing queued) when the queue is full.
+bool motionQueuePush(MotionQueue &queue, const MotionCommand &command);
+uint32_t motionQueueFree(const MotionQueue &queue);
+// Nothing queued and nothing in progress.
+bool motionQueueIdle(const MotionQueue &queue);
+
+// Consumer side: copy of the oldest command, false if there is none; pop it once it has been executed.
+bool motionQueueFront(const MotionQueue &queue, MotionCommand &out);
+// Copy of the command `offset` places behind the front (look-ahead), false if it is not queued yet.
+bool motionQueuePeek(const MotionQueue &queue, uint32_t offset, MotionCommand &out);
+// Pops `count` executed commands (at most what is queued).
+void motionQueuePop(MotionQueue &queue, uint32_t count = 1);
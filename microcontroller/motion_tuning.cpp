@@ -0,0 +1,85 @@
+#include "motion_tuning.h"
+#include "chess_position.h"
+
+namespace {
+
+float clampTo(float value, float lo, float hi) {
+    return value < lo ? lo : value > hi ? hi : value;
+}
+
+MotionLimits scaled(const MotionLimits &limits, float factor) {
+    MotionLimits out = limits;
+    out.maxSpeed = clampTo(limits.maxSpeed * factor, TUNE_MIN.maxSpeed, TUNE_MAX.maxSpeed);
+    out.accel = clampTo(limits.accel * factor, TUNE_MIN.accel, TUNE_MAX.accel);
+    out.jerk = clampTo(limits.jerk * factor, TUNE_MIN.jerk, TUNE_MAX.jerk);
+    return out;
+}
+
+bool sameLimits(const MotionLimits &a, const MotionLimits &b) {
+    return a.maxSpeed == b.maxSpeed && a.accel == b.accel && a.jerk == b.jerk;
+}
+
+bool withinRange(const MotionLimits &limits) {
+    return limits.maxSpeed >= TUNE_MIN.maxSpeed && limits.maxSpeed <= TUNE_MAX.maxSpeed &&
+           limits.accel >= TUNE_MIN.accel && limits.accel <= TUNE_MAX.accel &&
+           limits.jerk >= TUNE_MIN.jerk && limits.jerk <= TUNE_MAX.jerk &&
+           limits.junctionDeviation > 0.0f && limits.junctionDeviation <= 1.0f;
+}
+
+} // namespace
+
+MotionLoad motionLoadOf(uint8_t piece) {
+    uint8_t type = pieceTypeOf(piece);
+    if (type == NO_PIECE_TYPE) return MOTION_LOAD_EMPTY;
+    return type >= ROOK ? MOTION_LOAD_HEAVY : MOTION_LOAD_LIGHT;
+}
+
+const char *motionLoadName(MotionLoad load) {
+    switch (load) {
+        case MOTION_LOAD_EMPTY: return "empty";
+        case MOTION_LOAD_LIGHT: return "light";
+        case MOTION_LOAD_HEAVY: return "heavy";
+    }
+    return "?";
+}
+
+bool motionProfilesValid(const MotionProfiles &profiles) {
+    if (profiles.version != MOTION_PROFILES_VERSION) return false;
+    for (int i = 0; i < MOTION_LOAD_COUNT; i++) {
+        if (!withinRange(profiles.limits[i])) return false;
+    }
+    return true;
+}
+
+void motionTunerBegin(MotionTuner &tuner, const MotionLimits &start) {
+    tuner.trial = scaled(start, 1.0f);
+    tuner.safe = tuner.trial;
+    tuner.passed = false;
+    tuner.done = false;
+    tuner.trials = 0;
+}
+
+void motionTunerResult(MotionTuner &tuner, bool arrived) {
+    if (tuner.done) return;
+    tuner.trials++;
+    MotionLimits next;
+    if (arrived) {
+        tuner.safe = tuner.trial;
+        tuner.passed = true;
+        next = scaled(tuner.trial, TUNE_STEP);
+    } else if (tuner.passed) {
+        // one step past the fastest passing trial: that one passed once, right under the slip point,
+        // so keep a step below it against the spread of felt, magnet and piece weight
+        tuner.safe = scaled(tuner.safe, 1.0f / TUNE_STEP);
+        tuner.done = true;
+        return;
+    } else {
+        next = scaled(tuner.trial, 1.0f / TUNE_STEP);
+    }
+    // a trial that no longer changes has hit the end of the range (down: nothing passed)
+    if (sameLimits(next, tuner.trial) || tuner.trials >= TUNE_MAX_TRIALS) {
+        tuner.done = true;
+        return;
+    }
+    tuner.trial = next;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// Motion limits per load, and the tuning that finds the fastest safe ones on a given board.
+// A dragged piece slips once the magnet cannot pull it along as hard as the carriage accelerates,
+// so the heavier the piece the gentler the ramps have to be; with the magnet released only the
+// motors limit the carriage. Each queued segment says what it carries (motion_queue.h) and every
+// path is planned with that load's limits.
+//
+// Tuning, one load at a time: every trial scales speed, acceleration and jerk by TUNE_STEP and
+// carries a piece out and back; the reed sensors tell whether it arrived where it should. The first
+// failure ends the load, and it keeps one TUNE_STEP below its last passing trial (a single pass
+// just under the slip point is no margin for real games). If the starting values already fail,
+// the trials scale down instead until one passes. The result is stored in flash as this struct
+// behind a version number.
+
+#include <stdint.h>
+#include "motion_planner.h"
+
+enum MotionLoad : uint8_t {
+    MOTION_LOAD_EMPTY = 0,   // magnet released
+    MOTION_LOAD_LIGHT = 1,   // pawn, knight, bishop
+    MOTION_LOAD_HEAVY = 2    // rook, queen, king
+};
+
+const int MOTION_LOAD_COUNT = 3;
+const uint32_t MOTION_PROFILES_VERSION = 1;
+
+struct MotionProfiles {
+    uint32_t version;
+    MotionLimits limits[MOTION_LOAD_COUNT];   // by MotionLoad
+};
+
+// Untuned: the old top speed for everything, softer ramps for the heavy pieces.
+const MotionProfiles MOTION_PROFILES_DEFAULTS = {
+    MOTION_PROFILES_VERSION,
+    { { 30.0f, 150.0f, 3000.0f, 0.1f },
+      { 30.0f, 150.0f, 3000.0f, 0.1f },
+      { 30.0f, 100.0f, 2000.0f, 0.1f } }
+};
+
+// Range the tuner stays in; the top speed is 7500 steps/s, well within the step generator.
+const MotionLimits TUNE_MIN = { 5.0f, 25.0f, 500.0f, 0.1f };
+const MotionLimits TUNE_MAX = { 150.0f, 1500.0f, 30000.0f, 0.1f };
+const float TUNE_STEP = 1.2f;
+const int TUNE_MAX_TRIALS = 24;
+
+// Load class of a piece code (chess_position.h); NO_PIECE is MOTION_LOAD_EMPTY.
+MotionLoad motionLoadOf(uint8_t piece);
+const char *motionLoadName(MotionLoad load);
+
+// Right version, and every load's limits within TUNE_MIN..TUNE_MAX.
+bool motionProfilesValid(const MotionProfiles &profiles);
+
+struct MotionTuner {
+    MotionLimits trial;   // what to run next
+    MotionLimits safe;    // fastest trial that passed; once a faster one failed, one TUNE_STEP below it
+    bool passed;          // safe is set
+    bool done;
+    int trials;
+};
+
+void motionTunerBegin(MotionTuner &tuner, const MotionLimits &start);
+// Outcome of a run at tuner.trial; afterwards tuner.trial is the next one to run, until done.
+void motionTunerResult(MotionTuner &tuner, bool arrived);
@@ -0,0 +1,126 @@
+#include "move_inference.h"
+#include "chess_attacks.h"
+#include "chess_move_table.h"
+#include <math.h>
+
+namespace {
+
+float clampRate(float rate) {
+    if (rate < SENSOR_ERROR_FLOOR) return SENSOR_ERROR_FLOOR;
+    if (rate > SENSOR_ERROR_CEILING) return SENSOR_ERROR_CEILING;
+    return rate;
+}
+
+Bitboard toSensorBits(Bitboard chessBits, uint8_t sensorMask) {
+    Bitboard bits = 0;
+    while (chessBits) {
+        int sq = __builtin_ctzll(chessBits);
+        chessBits &= chessBits - 1;
+        bits |= squareBit(chessToSensorSquare(sq, sensorMask));
+    }
+    return bits;
+}
+
+Bitboard neighbours(Bitboard squares) {
+    Bitboard around = 0;
+    while (squares) {
+        int sq = __builtin_ctzll(squares);
+        squares &= squares - 1;
+        around |= kingAttacks(sq);   // the mirrors keep adjacency, so sensor squares work too
+    }
+    return around;
+}
+
+// Per-square log-likelihood of the observed reading for each hypothesis state.
+struct SquareTerms {
+    float empty[64];
+    float occupied[64];
+    float coupled[64];   // empty, next to a piece that just landed
+};
+
+float scoreOccupancy(const SquareTerms &terms, Bitboard expected, Bitboard coupled) {
+    float score = 0.0f;
+    for (int sq = 0; sq < 64; sq++) {
+        Bitboard bit = squareBit(sq);
+        if (expected & bit) score += terms.occupied[sq];
+        else if (coupled & bit) score += terms.coupled[sq];
+        else score += terms.empty[sq];
+    }
+    return score;
+}
+
+} // namespace
+
+void sensorErrorModelDefaults(SensorErrorModel &model) {
+    for (int sq = 0; sq < 64; sq++) {
+        model.falsePositive[sq] = SENSOR_ERROR_FLOOR;
+        model.falseNegative[sq] = SENSOR_ERROR_FLOOR;
+    }
+}
+
+void sensorErrorModelFromCalibration(const SensorCalibration &calibration, Bitboard expected,
+                                     const SensorFilterConfig &filter, SensorErrorModel &model) {
+    sensorErrorModelDefaults(model);
+    if (calibration.samples == 0) return;
+    for (int sq = 0; sq < 64; sq++) {
+        Bitboard bit = squareBit(sq);
+        float closedRate = float(calibration.closed[sq]) / float(calibration.samples);
+        if (filter.suppressed & bit) {
+            model.falsePositive[sq] = model.falseNegative[sq] = 0.5f;
+        } else if (expected & bit) {
+            model.falseNegative[sq] = clampRate(1.0f - closedRate);
+        } else {
+            model.falsePositive[sq] = clampRate(closedRate);
+        }
+    }
+}
+
+MoveInference inferMostLikelyMove(const Position &pos, Bitboard observed, uint8_t sensorMask,
+                                  const SensorErrorModel &model, Bitboard lifted) {
+    SquareTerms terms;
+    for (int sq = 0; sq < 64; sq++) {
+        bool closed = (observed & squareBit(sq)) != 0;
+        float fp = model.falsePositive[sq], fn = model.falseNegative[sq];
+        float coupledFp = fp > SENSOR_COUPLING_FALSE_POSITIVE ? fp : SENSOR_COUPLING_FALSE_POSITIVE;
+        terms.empty[sq] = logf(closed ? fp : 1.0f - fp);
+        terms.occupied[sq] = logf(closed ? 1.0f - fn : fn);
+        terms.coupled[sq] = logf(closed ? coupledFp : 1.0f - coupledFp);
+    }
+
+    Bitboard before = toSensorBits(pos.occupiedAll, sensorMask);
+    MoveInference result = { MOVE_NONE, MOVE_NONE, 0.0f, 0 };
+    float bestScore = scoreOccupancy(terms, before, 0);   // "no move"
+    float runnerUpScore = -INFINITY;
+
+    MoveList list;
+    generateLegalMoves(pos, list);
+    for (int i = 0; i < list.count; i++) {
+        Move move = list.moves[i];
+        // the board always promotes to a queen; underpromotions would only tie with it
+        if (moveIsPromotion(move) && movePromotionType(move) != QUEEN) continue;
+        if (moveIsCapture(move)) {
+            int from = moveFrom(move), to = moveTo(move);
+            int victim = moveFlags(move) == MF_EP_CAPTURE ? squareOf(squareRow(from), squareCol(to)) : to;
+            if (!(lifted & squareBit(chessToSensorSquare(victim, sensorMask)))) continue;
+        }
+        Position next = pos;
+        UndoInfo undo;
+        makeMove(next, move, undo);
+        Bitboard after = toSensorBits(next.occupiedAll, sensorMask);
+        Bitboard landed = (after & ~before) | squareBit(chessToSensorSquare(moveTo(move), sensorMask));
+        float score = scoreOccupancy(terms, after, neighbours(landed) & ~after);
+        result.candidates++;
+
+        if (score > bestScore) {
+            runnerUpScore = bestScore;
+            result.runnerUp = result.best;
+            bestScore = score;
+            result.best = move;
+        } else if (score > runnerUpScore) {
+            runnerUpScore = score;
+            result.runnerUp = move;
+        }
+    }
+    result.margin = bestScore - runnerUpScore;
+    return result;
+}
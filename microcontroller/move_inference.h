@@ -0,0 +1,48 @@
+#pragma once
+
+// Maximum-likelihood move inference from a noisy occupancy reading.
+// Every legal move (and "no move") predicts an occupancy; each is scored by the log-likelihood of
+// the observed reading under a per-square error model:
+//   - false-positive / false-negative rates per reed, from calibration (sensor_filter.h);
+//   - squares next to where a piece has just landed read a false positive at least
+//     SENSOR_COUPLING_FALSE_POSITIVE of the time (the magnet couples into neighbouring reeds).
+// The best move is accepted when it beats the runner-up by MOVE_INFERENCE_MIN_MARGIN, so a stray
+// reed or a missed one no longer rejects a move that only one legal move explains.
+// Occupancy and the model are in sensor coordinates.
+
+#include "chess_movegen.h"
+#include "sensor_filter.h"
+
+const float SENSOR_ERROR_FLOOR = 0.005f;             // no reed is trusted more than this
+const float SENSOR_ERROR_CEILING = 0.45f;
+const float SENSOR_COUPLING_FALSE_POSITIVE = 0.05f;
+const float MOVE_INFERENCE_MIN_MARGIN = 2.7f;       // log-likelihood ratio, ~15:1
+
+struct SensorErrorModel {
+    float falsePositive[64];   // P(closed | empty), indexed by sensor square
+    float falseNegative[64];   // P(open | occupied)
+};
+
+// Floor rates everywhere (before calibration).
+void sensorErrorModelDefaults(SensorErrorModel &model);
+// Rates measured on a board that held `expected`. Suppressed reeds always report empty, so the
+// model treats them as carrying no information.
+void sensorErrorModelFromCalibration(const SensorCalibration &calibration, Bitboard expected,
+                                     const SensorFilterConfig &filter, SensorErrorModel &model);
+
+struct MoveInference {
+    Move best;          // MOVE_NONE if "no move" is the most likely reading
+    Move runnerUp;      // second most likely hypothesis (MOVE_NONE may mean "no move")
+    float margin;       // log-likelihood of best minus runner-up
+    int candidates;     // legal moves scored
+};
+
+// lifted: squares seen empty since pos (MoveTracker::lifted). Captures whose victim is not among
+// them are left out, as in the tracker: a piece held in the air reads exactly like its captures.
+MoveInference inferMostLikelyMove(const Position &pos, Bitboard observed, uint8_t sensorMask,
+                                  const SensorErrorModel &model, Bitboard lifted = ~Bitboard(0));
+
+// best is a move and beats every other hypothesis by at least minMargin.
+inline bool moveInferenceAccepted(const MoveInference &inference, float minMargin = MOVE_INFERENCE_MIN_MARGIN) {
+    return inference.best != MOVE_NONE && inference.margin >= minMargin;
+}
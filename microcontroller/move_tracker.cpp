@@ -0,0 +1,69 @@
+#include "move_tracker.h"
+
+namespace {
+
+MoveTrackerEvent event(uint8_t kind, Move move = MOVE_NONE) {
+    MoveTrackerEvent e = { kind, move };
+    return e;
+}
+
+// The one legal move that explains occupancy, or MOVE_NONE.
+Move matchMove(const MoveTracker &tracker, const MoveSignatureTable &table, Bitboard occupancy) {
+    const MoveSignature *first = nullptr;
+    int n = lookupMoveSignature(table, tracker.reference & ~occupancy, occupancy & ~tracker.reference, &first);
+    Move found = MOVE_NONE;
+    for (int i = 0; i < n; i++) {
+        Bitboard toBit = squareBit(chessToSensorSquare(moveTo(first[i].move), tracker.sensorMask));
+        // the victim's square never showed empty: the piece is still in the air
+        if ((tracker.reference & toBit) && !(tracker.lifted & toBit)) continue;
+        if (found != MOVE_NONE) return MOVE_NONE;
+        found = first[i].move;
+    }
+    return found;
+}
+
+} // namespace
+
+void moveTrackerReset(MoveTracker &tracker, Bitboard reference, uint8_t sensorMask, uint32_t nowMs) {
+    tracker.reference = reference;
+    tracker.lifted = 0;
+    tracker.last = reference;
+    tracker.lastChangeMs = nowMs;
+    tracker.candidate = MOVE_NONE;
+    tracker.sensorMask = sensorMask;
+    tracker.reported = false;
+}
+
+MoveTrackerEvent moveTrackerUpdate(MoveTracker &tracker, const MoveSignatureTable &table, Bitboard occupancy,
+                                   uint32_t nowMs, const MoveTrackerConfig &config) {
+    if (occupancy != tracker.last) {
+        bool left = tracker.last == tracker.reference;
+        tracker.last = occupancy;
+        tracker.lastChangeMs = nowMs;
+        tracker.reported = false;
+        if (occupancy == tracker.reference) {
+            // touched and put back: forget the lifts so they cannot vouch for a later capture
+            tracker.lifted = 0;
+            tracker.candidate = MOVE_NONE;
+            return event(MOVE_EVENT_RESTORE);
+        }
+        tracker.lifted |= tracker.reference & ~occupancy;
+        tracker.candidate = matchMove(tracker, table, occupancy);
+        if (left) return event(MOVE_EVENT_LIFT);
+        return event(MOVE_EVENT_NONE);
+    }
+
+    if (occupancy == tracker.reference) return event(MOVE_EVENT_NONE);
+    uint32_t held = nowMs - tracker.lastChangeMs;
+    if (tracker.candidate != MOVE_NONE) {
+        if (held < config.dwellMs) return event(MOVE_EVENT_NONE);
+        Move move = tracker.candidate;
+        moveTrackerReset(tracker, occupancy, tracker.sensorMask, nowMs);
+        return event(MOVE_EVENT_COMMIT, move);
+    }
+    if (!tracker.reported && held >= config.illegalMs) {
+        tracker.reported = true;
+        return event(MOVE_EVENT_ILLEGAL);
+    }
+    return event(MOVE_EVENT_NONE);
+}
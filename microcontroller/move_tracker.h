@@ -0,0 +1,55 @@
+#pragma once
+
+// Button-free move detection over the filtered occupancy stream (sensor_filter.h).
+// Every sensor snapshot is compared with the reference occupancy (the position before the move):
+//   - the squares that emptied and filled since then are looked up in the legal-move table, so
+//     the order of the lifts and places in between does not matter (capture: lift the victim and
+//     the attacker in either order, then place; castling and en passant likewise);
+//   - a capture also needs its victim's square to have been seen empty since the reference (the
+//     lift history): a piece held in the air leaves the same delta as every capture it could make,
+//     and when one piece has several captures it tells them apart;
+//   - a matching board that then stays unchanged for dwellMs is committed.
+// Castling is read correctly as long as the king moves first (as the rules require); rook first,
+// a pause longer than dwellMs on the rook's square commits the rook move.
+// Occupancy is in sensor coordinates, like the table keys.
+
+#include "chess_move_table.h"
+
+struct MoveTrackerConfig {
+    uint32_t dwellMs;     // a legal resulting board must hold this long to be committed
+    uint32_t illegalMs;   // a board that is neither the reference nor a legal result is reported after this
+};
+
+const MoveTrackerConfig MOVE_TRACKER_DEFAULTS = { 300, 3000 };
+
+enum MoveTrackerEventKind : uint8_t {
+    MOVE_EVENT_NONE = 0,
+    MOVE_EVENT_LIFT = 1,      // board left the reference
+    MOVE_EVENT_RESTORE = 2,   // board is back on the reference with no move made
+    MOVE_EVENT_COMMIT = 3,    // move is the legal move played; the result is the new reference
+    MOVE_EVENT_ILLEGAL = 4    // board has held an unexplained state for illegalMs (reported once)
+};
+
+struct MoveTrackerEvent {
+    uint8_t kind;         // MoveTrackerEventKind
+    Move move;            // MOVE_EVENT_COMMIT only
+};
+
+struct MoveTracker {
+    Bitboard reference;   // occupancy before the move
+    Bitboard lifted;      // reference squares seen empty since the reference was set
+    Bitboard last;        // last occupancy fed
+    uint32_t lastChangeMs;
+    Move candidate;       // legal move matching `last`, or MOVE_NONE
+    uint8_t sensorMask;   // as passed to buildMoveSignatureTable
+    bool reported;        // MOVE_EVENT_ILLEGAL already sent for `last`
+};
+
+// Starts tracking from the given occupancy (call whenever the position changes by other means).
+void moveTrackerReset(MoveTracker &tracker, Bitboard reference, uint8_t sensorMask, uint32_t nowMs);
+
+// Feeds one snapshot; table must be built for the reference position.
+// After MOVE_EVENT_COMMIT the tracker already uses the new board as its reference; the caller
+// rebuilds the table for the new position before the next update.
+MoveTrackerEvent moveTrackerUpdate(MoveTracker &tracker, const MoveSignatureTable &table, Bitboard occupancy,
+                                   uint32_t nowMs, const MoveTrackerConfig &config = MOVE_TRACKER_DEFAULTS);
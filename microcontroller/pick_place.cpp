@@ -0,0 +1,47 @@
+#include "pick_place.h"
+#include <math.h>
+#include <stdlib.h>
+
+void pickPlaceInit(PickPlace &pp, const ServoTiming &timing) {
+    pp.timing = timing;
+    pp.armAngle = timing.releaseAngle;
+}
+
+uint16_t servoTravelMs(const ServoTiming &timing, int fromAngle, int toAngle) {
+    return uint16_t(ceilf(abs(toAngle - fromAngle) * 1000.0f / timing.degreesPerSecond));
+}
+
+int pickPlaceRaise(PickPlace &pp, MotionCommand out[PICK_PLACE_MAX_COMMANDS]) {
+    const ServoTiming &timing = pp.timing;
+    int n = 0;
+    out[n++] = motionServo(timing.releaseAngle); // written even when already up (PWM noise)
+    if (pp.armAngle < timing.clearAngle) out[n++] = motionDwell(servoTravelMs(timing, pp.armAngle, timing.clearAngle));
+    pp.armAngle = timing.releaseAngle;
+    return n;
+}
+
+int pickPlaceGrip(PickPlace &pp, MotionCommand out[PICK_PLACE_MAX_COMMANDS]) {
+    const ServoTiming &timing = pp.timing;
+    int n = 0;
+    out[n++] = motionServo(timing.engageAngle, servoTravelMs(timing, pp.armAngle, timing.engageAngle));
+    out[n++] = motionDwell(timing.gripMs);
+    pp.armAngle = timing.engageAngle;
+    return n;
+}
+
+int pickPlaceDrop(PickPlace &pp, MotionCommand out[PICK_PLACE_MAX_COMMANDS]) {
+    const ServoTiming &timing = pp.timing;
+    int n = 0;
+    out[n++] = motionServo(timing.engageAngle); // tap down: the arm is always down while the piece seats
+    out[n++] = motionDwell(timing.seatMs);
+    out[n++] = motionServo(timing.releaseAngle);
+    out[n++] = motionDwell(servoTravelMs(timing, timing.engageAngle, timing.clearAngle));
+    pp.armAngle = timing.releaseAngle;
+    return n;
+}
+
+uint16_t pickPlaceLeadMs(const MotionPlan &plan, uint16_t leadMs) {
+    if (plan.count == 0) return 0;
+    float decelMs = plan.blocks[plan.count - 1].decelTime * 1000.0f;
+    return leadMs < decelMs ? leadMs : uint16_t(decelMs);
+}
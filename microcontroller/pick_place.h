@@ -0,0 +1,50 @@
+#pragma once
+
+// Magnet-arm timing for carrying a piece, from a model of the servo (a constant slew rate) instead
+// of fixed waits around every write:
+//   - before travelling to a piece the arm only has to be above clearAngle, where the magnet no
+//     longer drags anything, not all the way up: the carriage sets off while it is still rising;
+//   - picking up, lowering starts while the carriage is still decelerating into the square (the
+//     servo command's leadMs, at most the last block's deceleration) so only the rest of the way
+//     down is waited for once it stands, plus gripMs for the piece to snap to the magnet;
+//   - the arm stays down during the carry; at the drop seatMs lets the piece settle, then the
+//     carriage leaves as soon as the rising arm has passed clearAngle.
+// A PickPlace remembers the angle the queued commands leave the arm at, so a release that is
+// already done costs nothing.
+
+#include <stdint.h>
+#include "motion_queue.h"
+#include "motion_planner.h"
+
+struct ServoTiming {
+    float degreesPerSecond;
+    uint8_t engageAngle, releaseAngle;
+    uint8_t clearAngle;          // at or above this the magnet holds nothing
+    uint16_t gripMs, seatMs;
+};
+
+const ServoTiming SERVO_TIMING_DEFAULTS = { 450.0f, 0, 90, 20, 40, 60 };
+
+const int PICK_PLACE_MAX_COMMANDS = 4;
+
+struct PickPlace {
+    ServoTiming timing;
+    int armAngle;                // where the queued commands leave the arm
+};
+
+void pickPlaceInit(PickPlace &pp, const ServoTiming &timing = SERVO_TIMING_DEFAULTS);
+
+// Time for the arm to swing from one angle to another.
+uint16_t servoTravelMs(const ServoTiming &timing, int fromAngle, int toAngle);
+
+// The commands for each phase of a carry, written to out; each returns how many.
+// Before travelling unloaded: release, and wait until the arm is clear.
+int pickPlaceRaise(PickPlace &pp, MotionCommand out[PICK_PLACE_MAX_COMMANDS]);
+// After the path to the piece has been queued: lower (overlapping the stop) and grip.
+int pickPlaceGrip(PickPlace &pp, MotionCommand out[PICK_PLACE_MAX_COMMANDS]);
+// After the carry has been queued: press down, seat, release, wait until the arm is clear.
+int pickPlaceDrop(PickPlace &pp, MotionCommand out[PICK_PLACE_MAX_COMMANDS]);
+
+// How long before the end of a planned path a servo command with leadMs may be written:
+// within the path's last deceleration, so the arm never comes down on the way there.
+uint16_t pickPlaceLeadMs(const MotionPlan &plan, uint16_t leadMs);
@@ -0,0 +1,35 @@
+#include "scan_scheduler.h"
+#include "chess_attacks.h"
+
+void scanRoiMapDefaults(ScanRoiMap &map) {
+    for (int sq = 0; sq < 64; sq++) {
+        map.relevant[sq] = squareBit(sq) | kingAttacks(sq);   // the mirrors keep adjacency
+    }
+}
+
+void buildScanRoiMap(const MoveSignatureTable &table, uint8_t sensorMask, ScanRoiMap &map) {
+    scanRoiMapDefaults(map);
+    for (int i = 0; i < table.count; i++) {
+        Bitboard touched = moveSignatureSquares(table.entries[i], sensorMask);
+        Bitboard around = touched;
+        for (Bitboard rest = touched; rest; rest &= rest - 1) around |= kingAttacks(__builtin_ctzll(rest));
+        for (Bitboard rest = touched; rest; rest &= rest - 1) map.relevant[__builtin_ctzll(rest)] |= around;
+    }
+}
+
+Bitboard scanSchedulerNext(ScanScheduler &sched, uint32_t nowMs, const ScanSchedulerConfig &config) {
+    if (!sched.started || nowMs - sched.lastFullMs >= config.fullScanMs) {
+        sched.started = true;
+        sched.lastFullMs = nowMs;
+        return ~Bitboard(0);
+    }
+    if (sched.region && int32_t(nowMs - sched.activeUntilMs) >= 0) sched.region = 0;
+    return sched.region;
+}
+
+void scanSchedulerObserve(ScanScheduler &sched, const ScanRoiMap &map, Bitboard activity, uint32_t nowMs,
+                          const ScanSchedulerConfig &config) {
+    if (!activity) return;
+    for (Bitboard rest = activity; rest; rest &= rest - 1) sched.region |= map.relevant[__builtin_ctzll(rest)];
+    sched.activeUntilMs = nowMs + config.holdMs;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// Decides what the sensor task scans on each tick. The whole board is scanned at a slow background
+// rate; when a square shows activity (a raw reading that disagrees with the filter, or a filtered
+// flip) the squares that matter for it are rescanned on every tick until the board has been quiet
+// for holdMs. The filter (sensor_filter.h) counts scans, so a region rescanned every 2 ms confirms a
+// lift or place several times sooner than a full scan every 10 ms, while a full-board pass still
+// catches anything outside the region.
+//
+// What matters for a square comes from the legal moves (chess_move_table.h): every square a move
+// touching it also touches, plus the neighbours a landing magnet can couple into. Squares are
+// sensor squares throughout, like the table keys.
+
+#include "chess_move_table.h"
+
+struct ScanRoiMap {
+    Bitboard relevant[64];   // squares to rescan once the square shows activity; always includes itself
+};
+
+struct ScanSchedulerConfig {
+    uint32_t fullScanMs;   // background full-board period
+    uint32_t holdMs;       // the region stays active this long after the last activity in it
+};
+
+const ScanSchedulerConfig SCAN_SCHEDULER_DEFAULTS = { 20, 500 };
+
+struct ScanScheduler {
+    Bitboard region;       // squares rescanned on every tick while active
+    uint32_t lastFullMs;
+    uint32_t activeUntilMs;
+    bool started;          // false until the first (full) scan
+};
+
+// Region for a board with no position: each square with its neighbours.
+void scanRoiMapDefaults(ScanRoiMap &map);
+// Region for the legal moves in the table, on top of the defaults.
+void buildScanRoiMap(const MoveSignatureTable &table, uint8_t sensorMask, ScanRoiMap &map);
+
+// Squares to scan now: ALL of them when the background scan is due, the active region otherwise,
+// 0 when nothing needs scanning on this tick.
+Bitboard scanSchedulerNext(ScanScheduler &sched, uint32_t nowMs,
+                           const ScanSchedulerConfig &config = SCAN_SCHEDULER_DEFAULTS);
+
+// Feeds the squares that showed activity in the last scan; grows the region and restarts its hold.
+void scanSchedulerObserve(ScanScheduler &sched, const ScanRoiMap &map, Bitboard activity, uint32_t nowMs,
+                          const ScanSchedulerConfig &config = SCAN_SCHEDULER_DEFAULTS);
@@ -0,0 +1,90 @@
+#include "sensor_filter.h"
+#include <math.h>
+#include <string.h>
+
+namespace {
+
+const float FALSE_FLIP_ODDS = 1e-6f;   // per square and scan: ~1 false flip a day at 100 scans/s
+
+// Scans in a row before a reed with the given error rate flips the state by chance too rarely
+// to matter: the integrator climbs on errors and falls on good readings, so it reaches k with
+// odds of about (rate / (1 - rate))^k.
+uint8_t scansForErrorRate(uint16_t errors, uint16_t samples) {
+    float rate = float(errors) / float(samples);
+    float floorRate = 0.5f / float(samples);   // no errors seen: assume half of one
+    if (rate < floorRate) rate = floorRate;
+    if (rate >= 0.5f) return SENSOR_FILTER_MAX_SCANS;
+    float k = ceilf(logf(FALSE_FLIP_ODDS) / logf(rate / (1.0f - rate)));
+    if (k < SENSOR_FILTER_MIN_SCANS) return SENSOR_FILTER_MIN_SCANS;
+    if (k > SENSOR_FILTER_MAX_SCANS) return SENSOR_FILTER_MAX_SCANS;
+    return uint8_t(k);
+}
+
+} // namespace
+
+void sensorFilterDefaults(SensorFilterConfig &config) {
+    memset(config.onScans, SENSOR_FILTER_DEFAULT_SCANS, sizeof(config.onScans));
+    memset(config.offScans, SENSOR_FILTER_DEFAULT_SCANS, sizeof(config.offScans));
+    config.suppressed = 0;
+}
+
+void sensorCalibrationAdd(SensorCalibration &calibration, Bitboard raw) {
+    for (int sq = 0; sq < 64; sq++) {
+        if (raw & squareBit(sq)) calibration.closed[sq]++;
+    }
+    calibration.samples++;
+}
+
+int sensorFilterFromCalibration(const SensorCalibration &calibration, Bitboard expected, SensorFilterConfig &out) {
+    sensorFilterDefaults(out);
+    if (calibration.samples == 0) return 0;
+    int suppressedCount = 0;
+    for (int sq = 0; sq < 64; sq++) {
+        uint16_t closed = calibration.closed[sq];
+        if (expected & squareBit(sq)) {
+            // occupied: errors are open readings, which push towards empty
+            out.offScans[sq] = scansForErrorRate(calibration.samples - closed, calibration.samples);
+        } else if (uint32_t(closed) * 100 >= uint32_t(calibration.samples) * SENSOR_SUPPRESS_PERCENT) {
+            out.suppressed |= squareBit(sq);
+            suppressedCount++;
+        } else {
+            // empty: errors are closed readings, which push towards occupied
+            out.onScans[sq] = scansForErrorRate(closed, calibration.samples);
+        }
+    }
+    return suppressedCount;
+}
+
+void sensorFilterUpdate(SensorFilter &filter, const SensorFilterConfig &config, Bitboard raw, uint32_t nowMs,
+                        SensorSnapshot &out, Bitboard scanned) {
+    Bitboard reading = raw & ~config.suppressed;
+    if (filter.scans == 0) {
+        filter.stable = reading;
+        filter.changedAtMs = nowMs;
+        memset(filter.evidence, 0, sizeof(filter.evidence));
+    } else {
+        Bitboard diff = reading ^ filter.stable;
+        for (Bitboard rest = scanned; rest; rest &= rest - 1) {
+            int sq = __builtin_ctzll(rest);
+            Bitboard bit = squareBit(sq);
+            if (!(diff & bit)) {
+                if (filter.evidence[sq]) filter.evidence[sq]--;
+                continue;
+            }
+            uint8_t threshold = (filter.stable & bit) ? config.offScans[sq] : config.onScans[sq];
+            if (++filter.evidence[sq] >= threshold) {
+                filter.stable ^= bit;
+                filter.evidence[sq] = 0;
+                filter.changedAtMs = nowMs;
+            }
+        }
+    }
+    filter.scans++;
+
+    out.occupancy = filter.stable;
+    out.raw = raw;
+    out.scanned = scanned;
+    out.scannedAtMs = nowMs;
+    out.changedAtMs = filter.changedAtMs;
+    out.scan = filter.scans;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+// Streaming per-square filter for the reed scans, fed one scan at a time by the sensor task.
+// Each square integrates evidence against its current state: a reading that disagrees adds one,
+// a reading that agrees takes one away (never below zero), and the state flips once the evidence
+// reaches that square's threshold — onScans to become occupied, offScans to become empty.
+// A clean reed flips within a few scans; a noisy one needs as many as its measured error rate calls
+// for, so isolated glitches and a moving magnet's coupling are absorbed without a fixed vote window.
+//
+// Thresholds come from calibration: scans of a board whose occupancy is known give every square's
+// false-positive rate (closed while empty) and false-negative rate (open while occupied). Squares
+// that read closed nearly all the time while empty are suppressed and always report empty.
+
+#include "sensor_snapshot.h"
+
+const uint8_t SENSOR_FILTER_MIN_SCANS = 2;
+const uint8_t SENSOR_FILTER_MAX_SCANS = 15;
+const uint8_t SENSOR_FILTER_DEFAULT_SCANS = 3;   // before calibration
+const uint8_t SENSOR_SUPPRESS_PERCENT = 80;      // false-positive rate that marks a stuck reed
+
+struct SensorFilterConfig {
+    uint8_t onScans[64];   // indexed by sensor square (row * 8 + col)
+    uint8_t offScans[64];
+    Bitboard suppressed;
+};
+
+struct SensorCalibration {
+    uint16_t closed[64];   // scans that read the square closed
+    uint16_t samples;
+};
+
+struct SensorFilter {
+    Bitboard stable;
+    uint32_t changedAtMs;
+    uint32_t scans;
+    uint8_t evidence[64];  // integrated readings against stable
+};
+
+void sensorFilterDefaults(SensorFilterConfig &config);
+void sensorCalibrationAdd(SensorCalibration &calibration, Bitboard raw);
+// Thresholds for the calibrated scans of a board that held `expected` (sensor coordinates).
+// Each threshold is the fewest net wrong readings a square's error rate makes less likely than
+// 1 in 10^6, clamped to [MIN, MAX]; ~100 scans are needed for a clean reed to get three. Only the
+// direction the square's state lets it measure is set, the other keeps the default. Returns the
+// number of suppressed squares.
+int sensorFilterFromCalibration(const SensorCalibration &calibration, Bitboard expected, SensorFilterConfig &out);
+
+// Feeds one scan and fills the snapshot to publish. Only the squares in `scanned` take a step, so
+// a partial rescan (scan_scheduler.h) does not count the stale readings of the others again.
+// The first scan must be a full one and is taken as-is.
+void sensorFilterUpdate(SensorFilter &filter, const SensorFilterConfig &config, Bitboard raw, uint32_t nowMs,
+                        SensorSnapshot &out, Bitboard scanned = ~Bitboard(0));
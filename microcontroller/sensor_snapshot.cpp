@@ -0,0 +1,22 @@
+#include "sensor_snapshot.h"
+
+void sensorSnapshotPublish(SensorSnapshotChannel &channel, const SensorSnapshot &snapshot) {
+    uint32_t seq = channel.seq.load(std::memory_order_relaxed);
+    // slot (seq / 2) & 1 holds the latest snapshot; write the other one
+    channel.seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    channel.slots[((seq >> 1) + 1) & 1] = snapshot;
+    channel.seq.store(seq + 2, std::memory_order_release);
+}
+
+bool sensorSnapshotRead(const SensorSnapshotChannel &channel, SensorSnapshot &out) {
+    for (;;) {
+        uint32_t before = channel.seq.load(std::memory_order_acquire);
+        if (before < 2) return false;
+        out = channel.slots[(before >> 1) & 1];
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t after = channel.seq.load(std::memory_order_relaxed);
+        // that slot is rewritten once the writer starts the publish after next
+        if (after - (before & ~1u) <= 2) return true;
+    }
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Occupancy snapshots handed from the sensor task (which owns the reed muxes) to the rest of the
+// firmware. The task filters every scan (sensor_filter.h) and publishes the result; readers on
+// the other core copy the latest snapshot without locks:
+//   - two slots and a sequence counter (a seqlock): the writer fills the slot readers are not
+//     pointed at, then bumps the counter;
+//   - a reader copies the current slot and retries only if the writer lapped it meanwhile,
+//     i.e. finished a publish and started overwriting that slot (one scan period, far longer than a copy).
+// Single producer only. Occupancy here is in sensor coordinates (see sensorBoardBits).
+
+#include "chess_position.h"
+#include <atomic>
+
+struct SensorSnapshot {
+    Bitboard occupancy;    // filtered
+    Bitboard raw;          // the scan it was taken from (last reading of squares it did not cover)
+    Bitboard scanned;      // squares that scan read; all 64 for a full scan
+    uint32_t scannedAtMs;
+    uint32_t changedAtMs;  // when occupancy last changed
+    uint32_t scan;         // number of scans so far, 1 for the first snapshot
+};
+
+struct SensorSnapshotChannel {
+    std::atomic<uint32_t> seq;   // even: idle, odd: a publish is in progress
+    SensorSnapshot slots[2];
+};
+
+void sensorSnapshotPublish(SensorSnapshotChannel &channel, const SensorSnapshot &snapshot);
+// Copies the latest snapshot; false if nothing has been published yet.
+bool sensorSnapshotRead(const SensorSnapshotChannel &channel, SensorSnapshot &out);
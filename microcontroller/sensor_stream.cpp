@@ -0,0 +1,49 @@
+#include "sensor_stream.h"
+
+namespace {
+
+SensorFrame emitFrame(SensorStream &stream, Bitboard occupancy, uint32_t nowMs, uint8_t kind) {
+    stream.sent = occupancy;
+    stream.sentAt = nowMs;
+    stream.seq++;
+    stream.pending = false;
+    stream.started = true;
+    SensorFrame frame = { occupancy, stream.seq, kind };
+    return frame;
+}
+
+} // namespace
+
+void sensorStreamReset(SensorStream &stream) {
+    uint16_t seq = stream.seq; // keep counting so the server never sees the sequence go backwards
+    stream = SensorStream();
+    stream.seq = seq;
+}
+
+SensorFrame sensorStreamUpdate(SensorStream &stream, Bitboard occupancy, uint32_t nowMs,
+                               const SensorStreamConfig &config) {
+    if (!stream.started) return emitFrame(stream, occupancy, nowMs, SENSOR_FRAME_KEYFRAME);
+
+    if (occupancy == stream.sent) {
+        stream.pending = false;
+    } else {
+        if (!stream.pending) {
+            stream.pending = true;
+            stream.changedAt = nowMs;
+            stream.candidate = occupancy;
+            stream.candidateAt = nowMs;
+        } else if (occupancy != stream.candidate) {
+            stream.candidate = occupancy;
+            stream.candidateAt = nowMs;
+        }
+        if (nowMs - stream.candidateAt >= config.settleMs || nowMs - stream.changedAt >= config.maxHoldMs) {
+            return emitFrame(stream, occupancy, nowMs, SENSOR_FRAME_CHANGE);
+        }
+    }
+
+    if (!stream.pending && nowMs - stream.sentAt >= config.keyframeMs) {
+        return emitFrame(stream, stream.sent, nowMs, SENSOR_FRAME_KEYFRAME);
+    }
+    SensorFrame none = { stream.sent, stream.seq, SENSOR_FRAME_NONE };
+    return none;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+// Change-driven live view of the board occupancy (what the frontend draws while pieces are moved).
+// Every scan is fed in; a frame is only due when the occupancy differs from the last one sent:
+//   - a change is held until the reading has been steady for settleMs, so reed bounces and the
+//     intermediate states of a lift / slide / capture go out as one frame, but never longer than
+//     maxHoldMs after the first change while the reading keeps moving;
+//   - a reading that returns to the sent state before it settles sends nothing;
+//   - a keyframe repeats the current state every keyframeMs for viewers that joined late.
+// Frames carry a 16-bit sequence number so the server can drop stale ones.
+
+#include "chess_position.h"
+
+struct SensorStreamConfig {
+    uint32_t settleMs;
+    uint32_t maxHoldMs;
+    uint32_t keyframeMs;
+};
+
+const SensorStreamConfig SENSOR_STREAM_DEFAULTS = { 60, 250, 5000 };
+
+enum SensorFrameKind : uint8_t {
+    SENSOR_FRAME_NONE = 0,
+    SENSOR_FRAME_CHANGE = 1,
+    SENSOR_FRAME_KEYFRAME = 2
+};
+
+struct SensorFrame {
+    Bitboard occupancy;   // bit sq = row * 8 + col, chess coordinates
+    uint16_t seq;
+    uint8_t kind;         // SensorFrameKind
+};
+
+struct SensorStream {
+    Bitboard sent;        // occupancy of the last frame
+    Bitboard candidate;   // latest reading that differs from sent
+    uint32_t changedAt;   // first scan that differed from sent
+    uint32_t candidateAt; // first scan that showed candidate
+    uint32_t sentAt;
+    uint16_t seq;         // sequence number of the last frame
+    bool pending;         // a change is being coalesced
+    bool started;         // false until the first frame (always a keyframe)
+};
+
+// Forgets what was sent; the next update emits a keyframe (e.g. after re-joining the namespace).
+void sensorStreamReset(SensorStream &stream);
+
+// Feeds one scan taken at nowMs. Returns the frame to send now, kind SENSOR_FRAME_NONE if none is due.
+SensorFrame sensorStreamUpdate(SensorStream &stream, Bitboard occupancy, uint32_t nowMs,
+                               const SensorStreamConfig &config = SENSOR_STREAM_DEFAULTS);
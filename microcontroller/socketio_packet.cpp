@@ -0,0 +1,121 @@
+#include "socketio_packet.h"
+#include <string.h>
+
+namespace {
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+PacketSpan makeSpan(char *begin, char *end) {
+    PacketSpan span = { begin, size_t(end - begin) };
+    return span;
+}
+
+char *skipSpaces(char *p, char *end) {
+    while (p < end && isSpace(*p)) p++;
+    return p;
+}
+
+// Span between [ and its matching ], with surrounding whitespace trimmed; p is at the '['.
+// Brackets inside strings do not count and only whitespace may follow, so a frame cut short
+// (which never closes its array) is rejected even if it happens to end on an inner ].
+bool arrayContents(char *p, char *end, char *&contentBegin, char *&contentEnd) {
+    if (p >= end || *p != '[') return false;
+    int depth = 0;
+    char *close = p;
+    for (; close < end; close++) {
+        if (*close == '"') {
+            for (close++; close < end && *close != '"'; close += (*close == '\\') ? 2 : 1) {}
+            if (close >= end) return false;
+        } else if (*close == '[' || *close == '{') {
+            depth++;
+        } else if ((*close == ']' || *close == '}') && --depth == 0) {
+            break;
+        }
+    }
+    if (close >= end || *close != ']' || skipSpaces(close + 1, end) != end) return false;
+    contentBegin = skipSpaces(p + 1, close);
+    contentEnd = close;
+    while (contentEnd > contentBegin && isSpace(contentEnd[-1])) contentEnd--;
+    return true;
+}
+
+} // namespace
+
+bool PacketSpan::equals(const char *text) const {
+    size_t n = strlen(text);
+    return n == len && (n == 0 || memcmp(ptr, text, n) == 0);
+}
+
+bool parseSocketIoPacket(char *text, size_t len, SocketIoPacket &out) {
+    if (!text || len == 0 || text[0] < '0' || text[0] > '6') return false;
+    char *p = text + 1;
+    char *end = text + len;
+
+    out.engineType = uint8_t(text[0] - '0');
+    out.socketType = SIO_NONE;
+    out.nsp = makeSpan(p, p);
+    out.ackId = -1;
+    out.event = makeSpan(p, p);
+    out.args = makeSpan(p, end);
+    if (out.engineType != EIO_MESSAGE) return true;
+
+    if (p >= end || *p < '0' || *p > '6') return false;
+    out.socketType = uint8_t(*p++ - '0');
+
+    if (out.socketType == SIO_BINARY_EVENT || out.socketType == SIO_BINARY_ACK) {
+        while (p < end && isDigit(*p)) p++;
+        if (p >= end || *p != '-') return false;
+        p++;
+    }
+
+    if (p < end && *p == '/') {
+        char *nspBegin = p;
+        while (p < end && *p != ',') p++;
+        out.nsp = makeSpan(nspBegin, p);
+        if (p < end) p++; // ','
+    }
+
+    if (p < end && isDigit(*p)) {
+        int32_t ack = 0;
+        while (p < end && isDigit(*p)) {
+            if (ack > 99999999) return false;
+            ack = ack * 10 + (*p++ - '0');
+        }
+        out.ackId = ack;
+    }
+
+    out.args = makeSpan(p, end);
+    bool ack = out.socketType == SIO_ACK || out.socketType == SIO_BINARY_ACK;
+    if (out.socketType != SIO_EVENT && out.socketType != SIO_BINARY_EVENT && !ack) return true;
+
+    char *contentBegin, *contentEnd;
+    if (!arrayContents(p, end, contentBegin, contentEnd)) return false;
+    if (ack) {
+        out.args = makeSpan(contentBegin, contentEnd);
+        return true;
+    }
+
+    // ["name", arg, ...] — the name is a JSON string; event names never need unescaping here,
+    // but escaped quotes are still skipped so a bad name cannot run past the buffer.
+    p = contentBegin;
+    if (p >= contentEnd || *p != '"') return false;
+    char *nameBegin = ++p;
+    while (p < contentEnd && *p != '"') p += (*p == '\\') ? 2 : 1;
+    if (p >= contentEnd) return false;
+    out.event = makeSpan(nameBegin, p);
+
+    p = skipSpaces(p + 1, contentEnd);
+    if (p == contentEnd) {
+        out.args = makeSpan(p, p);
+        return true;
+    }
+    if (*p != ',') return false;
+    out.args = makeSpan(skipSpaces(p + 1, contentEnd), contentEnd);
+    return true;
+}
+
+bool packetInNamespace(const SocketIoPacket &packet, const char *nsp) {
+    if (packet.nsp.empty()) return nsp[0] == '\0' || (nsp[0] == '/' && nsp[1] == '\0');
+    return packet.nsp.equals(nsp);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+// Zero-copy Engine.IO v4 / Socket.IO v5 text packet parser.
+// Wire format: <engine type>[<socket type>[<attachments>-][<namespace>,][<ack id>]][<json>]
+// e.g. 42/friends,["moveMade",{...}] or 2 (ping) or 40/friends,{"sid":"..."}.
+// The parsed spans point into the caller's buffer — nothing is copied — and the argument span
+// is left mutable so it can be deserialized in place (ArduinoJson zero-copy mode).
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum EngineIoPacketType : uint8_t {
+    EIO_OPEN = 0,
+    EIO_CLOSE = 1,
+    EIO_PING = 2,
+    EIO_PONG = 3,
+    EIO_MESSAGE = 4,
+    EIO_UPGRADE = 5,
+    EIO_NOOP = 6
+};
+
+enum SocketIoPacketType : uint8_t {
+    SIO_CONNECT = 0,
+    SIO_DISCONNECT = 1,
+    SIO_EVENT = 2,
+    SIO_ACK = 3,
+    SIO_CONNECT_ERROR = 4,
+    SIO_BINARY_EVENT = 5,
+    SIO_BINARY_ACK = 6,
+    SIO_NONE = 0xFF // not an Engine.IO message packet
+};
+
+struct PacketSpan {
+    char *ptr;
+    size_t len;
+
+    bool empty() const { return len == 0; }
+    bool equals(const char *text) const;
+};
+
+struct SocketIoPacket {
+    uint8_t engineType;   // EngineIoPacketType
+    uint8_t socketType;   // SocketIoPacketType, SIO_NONE unless engineType == EIO_MESSAGE
+    PacketSpan nsp;       // "/friends"; empty for the default namespace "/"
+    int32_t ackId;        // -1 when the packet carries no ack id
+    PacketSpan event;     // event name without quotes (EVENT / BINARY_EVENT only)
+    PacketSpan args;      // EVENT: arguments after the name; ACK / BINARY_ACK: the array contents;
+                          // CONNECT / CONNECT_ERROR / non-message packets: the raw payload
+};
+
+// Parses one text frame. Returns false for malformed packets (out is then unspecified).
+bool parseSocketIoPacket(char *text, size_t len, SocketIoPacket &out);
+
+// True if the packet belongs to nsp ("/" or "" match the default namespace).
+bool packetInNamespace(const SocketIoPacket &packet, const char *nsp);
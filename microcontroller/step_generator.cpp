@@ -0,0 +1,135 @@
+#include "step_generator.h"
+#include <math.h>
+#include <stdlib.h>
+
+namespace {
+
+const float TICK_S = STEP_TICK_US * 1e-6f;
+
+// Loads the cursor's block, skipping any that moves neither motor; false past the last one.
+bool loadBlock(StepPathCursor &cursor) {
+    for (; cursor.block < cursor.plan->count; cursor.block++) {
+        const MotionBlock &block = cursor.plan->blocks[cursor.block];
+        cursor.xMm += block.dxMm;
+        cursor.yMm += block.dyMm;
+        long a = lroundf((cursor.xMm + cursor.yMm) * cursor.stepsPerMm);
+        long b = lroundf((cursor.xMm - cursor.yMm) * cursor.stepsPerMm);
+        long da = a - cursor.endA, db = b - cursor.endB;
+        cursor.endA = a;
+        cursor.endB = b;
+        cursor.blockA = uint16_t(labs(da));
+        cursor.blockB = uint16_t(labs(db));
+        cursor.major = cursor.blockA > cursor.blockB ? cursor.blockA : cursor.blockB;
+        cursor.reverse = (da < 0 ? STEP_MOTOR_A : 0) | (db < 0 ? STEP_MOTOR_B : 0);
+        cursor.blockStart = true;
+        cursor.done = 0;
+        cursor.t = 0.0f;
+        cursor.distance = 0.0f;
+        if (cursor.major > 0) return true;
+    }
+    return false;
+}
+
+} // namespace
+
+bool stepGeneratorPush(StepGenerator &gen, const StepSegment &segment) {
+    uint32_t head = gen.head.load(std::memory_order_relaxed);
+    if (head - gen.tail.load(std::memory_order_acquire) >= STEP_SEGMENT_CAPACITY) return false;
+    gen.segments[head % STEP_SEGMENT_CAPACITY] = segment;
+    gen.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool stepGeneratorIdle(const StepGenerator &gen) {
+    return gen.head.load(std::memory_order_relaxed) == gen.tail.load(std::memory_order_acquire);
+}
+
+StepOutput HAL_IRAM_ATTR stepGeneratorTick(StepGenerator &gen) {
+    uint32_t tail = gen.tail.load(std::memory_order_relaxed);
+    if (!gen.loaded) {
+        if (gen.head.load(std::memory_order_acquire) == tail) {
+            StepOutput idle = { 0, gen.reverse };
+            return idle;
+        }
+        gen.current = gen.segments[tail % STEP_SEGMENT_CAPACITY];
+        gen.loaded = true;
+        gen.tick = 0;
+        gen.timeError = 0;
+        if (gen.current.blockStart) {
+            // no step on a segment's first tick, so the new directions are set up before the first pulse
+            gen.reverse = gen.current.reverse;
+            gen.major = gen.current.blockA > gen.current.blockB ? gen.current.blockA : gen.current.blockB;
+            gen.errorA = gen.errorB = gen.major / 2;
+        }
+    }
+    StepOutput out = { 0, gen.reverse };
+    const StepSegment &segment = gen.current;
+    gen.timeError += segment.steps;
+    if (gen.timeError >= segment.ticks) {
+        gen.timeError -= segment.ticks;
+        gen.errorA += segment.blockA;
+        if (gen.errorA >= gen.major) {
+            gen.errorA -= gen.major;
+            out.step |= STEP_MOTOR_A;
+        }
+        gen.errorB += segment.blockB;
+        if (gen.errorB >= gen.major) {
+            gen.errorB -= gen.major;
+            out.step |= STEP_MOTOR_B;
+        }
+    }
+    if (++gen.tick == segment.ticks) {
+        gen.loaded = false;
+        gen.tail.store(tail + 1, std::memory_order_release);
+    }
+    return out;
+}
+
+void stepPathBegin(StepPathCursor &cursor, const MotionPlan &plan, float stepsPerMm, float minSpeed) {
+    cursor = StepPathCursor();
+    cursor.plan = &plan;
+    cursor.stepsPerMm = stepsPerMm;
+    cursor.minSpeed = minSpeed;
+    loadBlock(cursor);
+}
+
+bool stepPathNext(StepPathCursor &cursor, StepSegment &out) {
+    if (cursor.block >= cursor.plan->count) return false;
+    const MotionBlock &block = cursor.plan->blocks[cursor.block];
+    float perMm = cursor.major / block.length;   // leading-motor steps per mm of path
+    float duration = motionBlockDuration(block);
+    uint32_t left = cursor.major - cursor.done;
+    uint32_t steps, ticks;
+    if (cursor.t < duration) {
+        // one segment of the profile, distance by the midpoint rule
+        ticks = STEP_SEGMENT_TICKS;
+        if (duration - cursor.t < ticks * TICK_S) ticks = uint32_t(ceilf((duration - cursor.t) / TICK_S));
+        if (ticks < 2) ticks = 2;
+        float dt = ticks * TICK_S;
+        cursor.distance += motionBlockSpeedAt(*cursor.plan, block, cursor.t + 0.5f * dt) * dt;
+        cursor.t += dt;
+        long target = lroundf(cursor.distance * perMm);
+        steps = target > long(cursor.done) ? uint32_t(target) - cursor.done : 0;
+        if (steps > left) steps = left;
+        if (steps > ticks / 2) steps = ticks / 2;   // the rest follows in the next segments
+    } else {
+        float speed = block.exitSpeed > cursor.minSpeed ? block.exitSpeed : cursor.minSpeed;
+        steps = left < STEP_SEGMENT_MAX_STEPS ? left : STEP_SEGMENT_MAX_STEPS;
+        float exact = steps / (speed * perMm * TICK_S);
+        ticks = exact > 65535.0f ? 65535 : uint32_t(ceilf(exact));
+        if (ticks < 2 * steps) ticks = 2 * steps;
+    }
+    out.ticks = uint16_t(ticks);
+    out.steps = uint16_t(steps);
+    out.blockA = cursor.blockA;
+    out.blockB = cursor.blockB;
+    out.reverse = cursor.reverse;
+    out.blockStart = cursor.blockStart;
+    cursor.blockStart = false;
+    cursor.done += steps;
+    if (cursor.done == cursor.major) {
+        cursor.block++;
+        loadBlock(cursor);
+    }
+    return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Step pulses for the two CoreXY motors from a fixed-rate timer interrupt, instead of polling
+// AccelStepper from the motion task (float speed math on every call, and a step is late whenever
+// the loop is busy with anything else, e.g. the servo re-write).
+//   - the motion task cuts a planned path into short segments: how many steps the leading motor
+//     of the block makes in the next STEP_SEGMENT_TICKS of the profile;
+//   - the interrupt spreads each segment's steps evenly over its ticks (a Bresenham in time) and
+//     splits every step between A and B with a second Bresenham over the block's step counts.
+// The interrupt side is integer adds and compares only. A pulse is high for one tick and a motor's
+// steps are at least two ticks apart, so STEP_TICK_US = 20 allows 25000 steps/s per motor.
+// Segments go through a single-producer single-consumer ring like motion_queue.h: the interrupt
+// pops a segment once its last tick has run, so the generator is idle exactly when the motors are.
+
+#include <atomic>
+#include <stdint.h>
+#include "motion_planner.h"
+#include "board_hal.h"
+
+const uint32_t STEP_TICK_US = 20;
+const uint16_t STEP_SEGMENT_TICKS = 100;                        // 2 ms of profile per segment
+const uint16_t STEP_SEGMENT_MAX_STEPS = STEP_SEGMENT_TICKS / 2;
+const uint32_t STEP_SEGMENT_CAPACITY = 32;                      // 64 ms queued ahead
+
+enum StepMotorBits : uint8_t {
+    STEP_MOTOR_A = 1,
+    STEP_MOTOR_B = 2
+};
+
+struct StepSegment {
+    uint16_t ticks;
+    uint16_t steps;            // leading-motor steps, at most ticks / 2
+    uint16_t blockA, blockB;   // the block's step count per motor (the larger one leads)
+    uint8_t reverse;           // StepMotorBits running backwards in this block
+    uint8_t blockStart;        // first segment of a block: set the directions, restart the split
+};
+
+struct StepOutput {
+    uint8_t step;              // StepMotorBits to pulse this tick
+    uint8_t reverse;           // direction lines for the current block
+};
+
+struct StepGenerator {
+    std::atomic<uint32_t> head;   // segments pushed (motion task)
+    std::atomic<uint32_t> tail;   // segments finished (interrupt)
+    StepSegment segments[STEP_SEGMENT_CAPACITY];
+    // interrupt state
+    StepSegment current;
+    bool loaded;
+    uint16_t tick;
+    uint32_t timeError;
+    uint32_t major, errorA, errorB;
+    uint8_t reverse;
+};
+
+// Producer side. False (and nothing queued) when the ring is full.
+bool stepGeneratorPush(StepGenerator &gen, const StepSegment &segment);
+// No segment waiting and none running.
+bool stepGeneratorIdle(const StepGenerator &gen);
+
+// One timer tick (interrupt side): which motors step now, and the direction lines to hold.
+// In IRAM, and it must stay that way: it only touches gen (in DRAM) and calls nothing.
+StepOutput stepGeneratorTick(StepGenerator &gen);
+
+// Cuts a planned path into segments. Each block's motor step counts come from the path so far in
+// mm, so rounding never accumulates; within a block the leading motor follows the integrated
+// speed profile, and any steps left when the profile ends run at the exit speed (at least minSpeed).
+struct StepPathCursor {
+    const MotionPlan *plan;
+    float stepsPerMm, minSpeed;
+    int block;                 // plan->count when done
+    float xMm, yMm;            // path up to the end of the current block
+    long endA, endB;           // motor positions there, in steps from the start of the path
+    uint16_t blockA, blockB;
+    uint8_t reverse;
+    bool blockStart;
+    uint32_t major, done;      // leading-motor steps of the block, and queued so far
+    float t, distance;         // profile time and distance into the block
+};
+
+void stepPathBegin(StepPathCursor &cursor, const MotionPlan &plan, float stepsPerMm, float minSpeed);
+// Next segment of the path, false once all of it has been cut.
+bool stepPathNext(StepPathCursor &cursor, StepSegment &out);
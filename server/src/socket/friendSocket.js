@@ -17,6 +17,7 @@ import {
   handleGameEnd,
 } from './socketHelpers.js';
 import logger from '../utils/logger.js';
+import { decodeBoardSensorFrame, isNewerSensorSeq } from '../utils/boardSensorFrame.js';
 import { startGame as startGameFromInviteService } from '../services/inviteService.js';
 import {
   initQuickMatchService,
@@ -207,10 +208,18 @@ export function initFriendSocket(io) {
       });
     });
 
+    // Board live view: change-driven frames from the board, expanded back to rows for viewers.
+    // Frames that arrive out of order are dropped; a keyframe always resynchronizes.
+    let lastSensorSeq = null;
     socket.on('boardSensorUpdate', (data) => {
-      if (!data || !Array.isArray(data.rows) || data.rows.length !== 8) return;
+      const frame = decodeBoardSensorFrame(data);
+      if (!frame) return;
+      if (frame.seq !== null) {
+        if (!frame.keyframe && !isNewerSensorSeq(frame.seq, lastSensorSeq)) return;
+        lastSensorSeq = frame.seq;
+      }
       // Relay only to this user's private room — not to game partners
-      nsp.to(`user::${userId}`).emit('boardSensorUpdate', { rows: data.rows });
+      nsp.to(`user::${userId}`).emit('boardSensorUpdate', { rows: frame.rows });
     });
 
     socket.on('joinGameRoom', async ({ gameId }) => {
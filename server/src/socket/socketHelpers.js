@@ -7,6 +7,7 @@ import GameMove from '../models/GameMove.js';
 import { Op } from 'sequelize';
 import logger from '../utils/logger.js';
 import { Chess } from 'chess.js';
+import { zobristHashFromFen } from '../utils/zobrist.js';
 import { applyGameRatingChanges } from '../services/ratingService.js';
 
 // Store active user connections - تحسين لتتبع جميع الاتصالات لكل مستخدم
@@ -923,6 +924,24 @@ export async function updateGameTurn(nsp, gameId, newTurn) {
   }
 }
 
+// Physical boards send the Zobrist hash of the position after their move. Replaying the move on
+// the stored FEN and comparing hashes detects a board that drifted out of sync with the server.
+function verifyBoardHash(gameId, storedFen, moveData) {
+  let expected = null;
+  try {
+    const chess = new Chess(storedFen);
+    chess.move({ from: moveData.from, to: moveData.to, promotion: moveData.promotion || undefined });
+    expected = zobristHashFromFen(chess.fen());
+  } catch (error) {
+    // Move is illegal on the stored position: the board is already out of sync.
+  }
+  if (expected !== String(moveData.hash).toLowerCase()) {
+    logger.warn(`Board position hash mismatch in game ${gameId}: board=${moveData.hash} server=${expected}`);
+    return false;
+  }
+  return true;
+}
+
 // Handle game move and update turn
 export async function handleGameMove(nsp, gameId, moveData) {
   try {
@@ -935,6 +954,10 @@ export async function handleGameMove(nsp, gameId, moveData) {
       return;
     }
     
+    if (moveData.hash) {
+      verifyBoardHash(gameId, game.current_fen, moveData);
+    }
+
     // تحديث FEN والدور في قاعدة البيانات
     const newTurn = moveData.currentTurn || (game.current_turn === 'white' ? 'black' : 'white');
     await game.update({
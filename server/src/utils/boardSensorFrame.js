@@ -0,0 +1,34 @@
+// Live-view frames from the physical board (microcontroller/sensor_stream.h).
+// The board sends { occ, seq, kf } only when occupancy changes, plus a keyframe every few seconds:
+// occ is the 64-bit occupancy as 16 hex digits, bit sq = row * 8 + col (row 0 = rank 1, col 0 = file a).
+// Viewers keep receiving { rows: [8 bytes] } (rows[r] bit c), so the client is unchanged.
+// Older firmware that still sends { rows } is passed through.
+
+const SEQ_MOD = 0x10000;
+
+function isRowArray(rows) {
+  return Array.isArray(rows) && rows.length === 8 && rows.every((r) => Number.isInteger(r) && r >= 0 && r <= 255);
+}
+
+// Returns { rows, seq, keyframe } or null for a malformed frame. seq is null for legacy frames.
+export function decodeBoardSensorFrame(data) {
+  if (!data || typeof data !== 'object') return null;
+
+  if (typeof data.occ === 'string' && /^[0-9a-f]{16}$/i.test(data.occ)) {
+    const seq = Number(data.seq);
+    if (!Number.isInteger(seq) || seq < 0 || seq >= SEQ_MOD) return null;
+    const occ = BigInt(`0x${data.occ}`);
+    const rows = Array.from({ length: 8 }, (_, r) => Number((occ >> BigInt(8 * r)) & 0xffn));
+    return { rows, seq, keyframe: data.kf === 1 || data.kf === true };
+  }
+
+  if (isRowArray(data.rows)) return { rows: data.rows, seq: null, keyframe: true };
+  return null;
+}
+
+// 16-bit serial-number comparison: true if seq comes after lastSeq (allowing for wrap-around).
+export function isNewerSensorSeq(seq, lastSeq) {
+  if (lastSeq === null || lastSeq === undefined) return true;
+  const diff = (seq - lastSeq + SEQ_MOD) % SEQ_MOD;
+  return diff !== 0 && diff < SEQ_MOD / 2;
+}
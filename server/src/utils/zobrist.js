@@ -0,0 +1,63 @@
+// Zobrist hash of a FEN, bit-identical to Position::hash in the board firmware
+// (microcontroller/chess_position.cpp). Keys are splitmix64 of the key index:
+// piece code (PNBRQKpnbrqk) * 64 + square, 768 + castling rights, 784 + en-passant file, 792 = black to move.
+// The en-passant file only counts when a pawn of the side to move can capture there.
+
+const MASK64 = (1n << 64n) - 1n;
+const PIECE_LETTERS = 'PNBRQKpnbrqk';
+const CASTLING_BITS = { K: 1, Q: 2, k: 4, q: 8 };
+const ZOBRIST_CASTLING = 768;
+const ZOBRIST_EP_FILE = 784;
+const ZOBRIST_BLACK_TO_MOVE = 792;
+
+function zobristKey(index) {
+  let z = (BigInt(index + 1) * 0x9e3779b97f4a7c15n) & MASK64;
+  z = ((z ^ (z >> 30n)) * 0xbf58476d1ce4e5b9n) & MASK64;
+  z = ((z ^ (z >> 27n)) * 0x94d049bb133111ebn) & MASK64;
+  return z ^ (z >> 31n);
+}
+
+const KEYS = Array.from({ length: ZOBRIST_BLACK_TO_MOVE + 1 }, (_, i) => zobristKey(i));
+
+// Returns the hash as 16 lowercase hex digits (the format the board sends), or null for a malformed FEN.
+export function zobristHashFromFen(fen) {
+  const [placement, side = 'w', castling = '-', ep = '-'] = String(fen || '').trim().split(/\s+/);
+  const ranks = placement ? placement.split('/') : [];
+  if (ranks.length !== 8) return null;
+
+  const board = new Array(64).fill(null); // square = row * 8 + col, row 0 = rank 1
+  let hash = 0n;
+  for (let i = 0; i < 8; i++) {
+    const row = 7 - i;
+    let col = 0;
+    for (const ch of ranks[i]) {
+      if (ch >= '1' && ch <= '8') {
+        col += Number(ch);
+        continue;
+      }
+      const code = PIECE_LETTERS.indexOf(ch);
+      if (code < 0 || col > 7) return null;
+      board[row * 8 + col] = ch;
+      hash ^= KEYS[code * 64 + row * 8 + col];
+      col++;
+    }
+    if (col !== 8) return null;
+  }
+
+  let rights = 0;
+  for (const ch of castling) rights |= CASTLING_BITS[ch] || 0;
+  hash ^= KEYS[ZOBRIST_CASTLING + rights];
+
+  if (/^[a-h][36]$/.test(ep)) {
+    const file = ep.charCodeAt(0) - 97;
+    const pawnRow = side === 'w' ? 4 : 3;
+    const pawn = side === 'w' ? 'P' : 'p';
+    const capturable = [file - 1, file + 1].some(
+      (c) => c >= 0 && c < 8 && board[pawnRow * 8 + c] === pawn
+    );
+    if (capturable) hash ^= KEYS[ZOBRIST_EP_FILE + file];
+  }
+
+  if (side === 'b') hash ^= KEYS[ZOBRIST_BLACK_TO_MOVE];
+  return hash.toString(16).padStart(16, '0');
+}